@@ -0,0 +1,108 @@
+// Runs the firmware's benchmark kernels (main/include/bench.hh) on the host
+// and prints the same JSON as the device's /bench. Given a /bench response
+// saved from a device, it also prints the target/host ratio per kernel.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "harness.hh"
+#include "bench.hh"
+#include "pca9685.hh"
+
+namespace
+{
+    using namespace Harness;
+
+    // Host time expressed in cycles of the device's clock, so both sides report the same unit.
+    uint32_t hostCycles()
+    {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        return static_cast<uint32_t>(static_cast<uint64_t>(nanos) * Host::Clock::CPU_MHZ / 1000);
+    }
+
+    bool readFile(const char* path, std::string& content)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr) return false;
+        char buffer[1024];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) content.append(buffer, read);
+        fclose(file);
+        return true;
+    }
+
+    int compare(const std::string& host, const char* devicePath)
+    {
+        std::string device;
+        if (!readFile(devicePath, device))
+        {
+            fprintf(stderr, "cannot open %s\n", devicePath);
+            return 1;
+        }
+
+        JsonDocument hostDocument;
+        JsonDocument deviceDocument;
+        if (deserializeJson(hostDocument, host) || deserializeJson(deviceDocument, device))
+        {
+            fprintf(stderr, "cannot parse the /bench responses\n");
+            return 1;
+        }
+
+        printf("%-32s %14s %14s %8s\n", "kernel", "device cycles", "host cycles", "ratio");
+        for (const auto deviceKernel : deviceDocument["kernels"].as<JsonArray>())
+        {
+            const auto name = deviceKernel["name"].as<std::string>();
+            const auto deviceCycles = deviceKernel["meanCycles"].as<uint32_t>();
+            for (const auto hostKernel : hostDocument["kernels"].as<JsonArray>())
+            {
+                if (hostKernel["name"].as<std::string>() != name) continue;
+                const auto hostCycles = hostKernel["meanCycles"].as<uint32_t>();
+                printf("%-32s %14u %14u %8.1f\n", name.c_str(), deviceCycles, hostCycles,
+                       hostCycles ? static_cast<double>(deviceCycles) / hostCycles : 0.0);
+            }
+        }
+        return 0;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    const char* devicePath = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--device" && i + 1 < argc)
+        {
+            devicePath = argv[++i];
+            continue;
+        }
+        fprintf(stderr, "usage: %s [--device BENCH_JSON]\n", argv[0]);
+        return 2;
+    }
+
+    boot();
+    // Host only: all 16 channels of an expander on the fake bus change, whatever the board profile.
+    static OutputBackend::Pca9685 expander(Wire, OutputBackend::Pca9685::BASE_ADDRESS + 7, GPIO_NUM_NC, GPIO_NUM_NC);
+    Bench::add("pca9685.update16", []
+    {
+        static uint8_t duty = 0;
+        duty++;
+        for (uint8_t channel = 0; channel < OutputBackend::Pca9685::CHANNELS; ++channel)
+            expander.write(channel, duty + channel);
+        expander.flush();
+    }, 200);
+    Bench::runAll(hostCycles);
+    // Payload sizes of /state, which the kernel timings json.state and msgpack.state don't show.
+    for (const auto accept : {"application/json", "application/msgpack"})
+    {
+        const auto state = Host::Web::send({Host::Web::Method::Get, HTTP::Endpoints::STATE, {}, {}, true,
+                                            {{"Accept", accept}}});
+        fprintf(stderr, "/state as %-20s %zu B\n", state.contentType.c_str(), state.body.size());
+    }
+    const auto response = Host::Web::send({Host::Web::Method::Get, HTTP::Endpoints::BENCH});
+    if (devicePath) return compare(response.body, devicePath);
+    printf("%s\n", response.body.c_str());
+    return 0;
+}
@@ -0,0 +1,517 @@
+// Runs the controller's setup()/loop() against the host fakes on a virtual
+// clock while scripted clients generate traffic, and reports how the loop,
+// the heap and the outputs behaved. The fakes charge each peripheral
+// operation's nominal cost (Host::Cost) to the clock, so loop time and
+// latency are virtual too. Each scenario runs in its own process so it starts
+// from a freshly booted firmware; with --no-timing the report only contains
+// virtual-time figures and is identical from run to run. --trace
+// saves each scenario's command trace for trace_replay. A scenario fails,
+// and the exit code is nonzero, when a steady-state path allocates after
+// the warm-up.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "harness.hh"
+#include "websocket_message.hh"
+
+namespace
+{
+    using namespace Harness;
+
+    struct Scenario
+    {
+        const char* name;
+        const char* description;
+        uint8_t socketClients = 0;
+        uint32_t socketCommandIntervalMs = 0;
+        // The last `slowSocketClients` clients drain their send queues only this often; the others every pass.
+        uint8_t slowSocketClients = 0;
+        uint32_t slowDrainIntervalMs = 0;
+        uint32_t espNowBurstIntervalMs = 0;
+        uint8_t espNowBurstSize = 0;
+        uint32_t huePollIntervalMs = 0;
+        uint32_t hueCommandIntervalMs = 0;
+        uint32_t restScrapeIntervalMs = 0;
+    };
+
+    constexpr Scenario SCENARIOS[] = {
+        {"idle", "no traffic"},
+        {"websocket", "WebSocket clients sending a colour every 50 ms", 4, 50},
+        // The clients' own commands hold the colour broadcast back, so a remote changes the colour instead.
+        {"websocket-slow", "WebSocket clients watching a remote toggle every 100 ms, two draining every 5 s", 4, 0,
+         2, 5000, 100, 1},
+        {"espnow", "bursts of 20 ESP-NOW toggles every second", 0, 0, 0, 0, 1000, 20},
+        {"hue", "Hue polls every second and a command every 2 s", 0, 0, 0, 0, 0, 0, 1000, 2000},
+        {"rest", "REST scrapes of /state and /system/* every 500 ms", 0, 0, 0, 0, 0, 0, 0, 0, 500},
+        {"mixed", "all generators together", 4, 50, 0, 0, 1000, 20, 1000, 2000, 500},
+    };
+
+    struct Options
+    {
+        uint32_t durationMs = 10'000;
+        uint32_t seed = 1;
+        uint8_t clients = 0;
+        bool timing = true;
+        // Directory that receives a command trace of each scenario, see main/include/command_trace.hh.
+        const char* traceDirectory = nullptr;
+        std::vector<std::string_view> scenarios;
+    };
+
+    enum class Source : uint8_t
+    {
+        WebSocket,
+        EspNow,
+        Hue,
+        COUNT
+    };
+
+    constexpr const char* SOURCE_NAMES[] = {"websocket", "espnow", "hue"};
+
+    /**
+     * Paths that must not allocate once the firmware is warmed up, see
+     * HeapAccounting::NoAllocGuard. Only firmware allocations count: the fakes
+     * attribute their own to the library they stand in for.
+     */
+    enum class Path : uint8_t
+    {
+        // WebSocket and Hue colour commands.
+        OutputCommand,
+        // Loop passes, which build and send the WebSocket broadcasts.
+        Broadcast,
+        EspNow,
+        // GET /api/<user>/lights; the SSDP answers are sent from the loop.
+        HuePoll,
+        COUNT
+    };
+
+    constexpr const char* PATH_NAMES[] = {"output commands", "broadcasts", "esp-now", "hue polls"};
+    // Virtual time after the start of the traffic before allocations count; covers the delayed BLE start.
+    constexpr uint32_t WARM_UP_MS = 2500;
+
+    /**
+     * Command latency is the virtual time from injecting a command to the next
+     * output write: an LEDC write, or an I2C transaction on expander boards.
+     * Every generator changes the output on each command, so a command that
+     * never produces a write is reported as lost.
+     */
+    class LatencyTracker
+    {
+        struct Pending
+        {
+            Source source;
+            uint64_t injectedUs;
+        };
+
+        std::deque<Pending, UntrackedAllocator<Pending>> pending;
+        uint32_t observedWrites = 0;
+
+        static uint32_t outputWrites()
+        {
+            return Host::Ledc::getTotalWrites() + Host::I2c::getStats().transactions;
+        }
+
+    public:
+        std::array<Distribution, static_cast<size_t>(Source::COUNT)> latencies;
+        std::array<uint32_t, static_cast<size_t>(Source::COUNT)> injected = {};
+
+        void begin()
+        {
+            observedWrites = outputWrites();
+        }
+
+        void injecting(const Source source)
+        {
+            injected[static_cast<size_t>(source)]++;
+            pending.push_back({source, Host::Clock::nowUs()});
+        }
+
+        void observe()
+        {
+            const auto writes = outputWrites();
+            if (writes == observedWrites) return;
+            observedWrites = writes;
+            const auto now = Host::Clock::nowUs();
+            for (const auto& [source, injectedUs] : pending)
+                latencies[static_cast<size_t>(source)].add(now - injectedUs);
+            pending.clear();
+        }
+
+        [[nodiscard]] uint32_t lost(const Source source) const
+        {
+            return static_cast<uint32_t>(std::ranges::count_if(
+                pending, [source](const Pending& entry) { return entry.source == source; }));
+        }
+    };
+
+    // A periodic generator; it fires late rather than skip a tick when a loop pass overran it.
+    struct Timer
+    {
+        uint32_t intervalMs = 0;
+        uint32_t nextMs = 0;
+
+        bool due(const uint32_t nowMs)
+        {
+            if (intervalMs == 0 || nowMs < nextMs) return false;
+            nextMs += intervalMs;
+            return true;
+        }
+    };
+
+    struct Report
+    {
+        uint32_t loops = 0;
+        // Virtual time of each pass, i.e. the nominal cost of the peripheral work it did.
+        Distribution loopMicros;
+        Distribution loopNanos;
+        // Time spent in the handlers the network stack would run: WebSocket, ESP-NOW and HTTP callbacks.
+        Distribution handlerNanos;
+        Distribution loopAllocations;
+        uint32_t httpRequests = 0;
+        std::array<uint32_t, 6> httpByClass = {};
+        // Operations and firmware allocations on each steady-state path after the warm-up.
+        std::array<uint32_t, static_cast<size_t>(Path::COUNT)> pathOperations = {};
+        std::array<uint32_t, static_cast<size_t>(Path::COUNT)> pathAllocations = {};
+    };
+
+    class Simulation
+    {
+        const Scenario& scenario;
+        const Options& options;
+        std::mt19937 random;
+        LatencyTracker latency;
+        Report report;
+
+        std::vector<Host::Web::ClientId> clients;
+        std::vector<Host::Web::ClientId> slowClients;
+        std::string hueLight;
+        uint32_t commandCounter = 0;
+        uint64_t warmUpEndUs = 0;
+
+        template <typename Handler>
+        void timed(Handler&& handler)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            handler();
+            report.handlerNanos.add(nanosSince(start));
+        }
+
+        // Runs `operation` on `path`, counting the firmware allocations it makes once warmed up.
+        template <typename Operation>
+        void onPath(const Path path, Operation&& operation)
+        {
+            const auto before = Host::Heap::getStats().firmwareAllocations;
+            operation();
+            if (Host::Clock::nowUs() < warmUpEndUs) return;
+            report.pathOperations[static_cast<size_t>(path)]++;
+            report.pathAllocations[static_cast<size_t>(path)] += Host::Heap::getStats().firmwareAllocations - before;
+        }
+
+        void sendHttp(const Host::Web::Request& request)
+        {
+            Host::Web::Response response;
+            timed([&] { response = Host::Web::send(request); });
+            report.httpRequests++;
+            report.httpByClass[std::clamp(response.code / 100, 0, 5)]++;
+        }
+
+        // Periodic generators start at a random phase so they don't fire in lockstep.
+        [[nodiscard]] Timer timer(const uint32_t intervalMs)
+        {
+            return {intervalMs, intervalMs ? static_cast<uint32_t>(random() % intervalMs) : 0};
+        }
+
+        void sendSocketCommand(const Host::Web::ClientId client)
+        {
+            const auto value = static_cast<uint8_t>(1 + commandCounter++ % 254);
+            Output::State state;
+            for (auto& light : state.values) light = {true, value};
+            const WebSocket::ColorMessage message(state);
+            latency.injecting(Source::WebSocket);
+            onPath(Path::OutputCommand, [&]
+            {
+                timed([&]
+                {
+                    Host::Web::sendSocket(client, reinterpret_cast<const uint8_t*>(&message), sizeof(message));
+                });
+            });
+            latency.observe();
+        }
+
+        void sendEspNowBurst()
+        {
+            for (uint8_t i = 0; i < scenario.espNowBurstSize; ++i)
+            {
+                const EspNow::Message message = {EspNow::Message::Type::ToggleRed};
+                latency.injecting(Source::EspNow);
+                onPath(Path::EspNow, [&]
+                {
+                    timed([&]
+                    {
+                        Host::EspNow::receive(REMOTE_MAC, reinterpret_cast<const uint8_t*>(&message),
+                                              sizeof(message));
+                    });
+                });
+                latency.observe();
+            }
+        }
+
+        void pollHue()
+        {
+            Host::Network::injectUdp("M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\n"
+                                     "MAN: \"ssdp:discover\"\r\nST: urn:schemas-upnp-org:device:basic:1\r\n\r\n");
+            const Host::Web::Request request = {Host::Web::Method::Get, std::string("/api/") + HUE_USER + "/lights"};
+            onPath(Path::HuePoll, [&] { sendHttp(request); });
+        }
+
+        void sendHueCommand()
+        {
+            if (hueLight.empty()) return;
+            const auto brightness = 1 + commandCounter++ % 254;
+            const auto url = std::string("/api/") + HUE_USER + "/lights/" + hueLight + "/state";
+            latency.injecting(Source::Hue);
+            const auto body = R"({"on":true,"bri":)" + std::to_string(brightness) + "}";
+            const Host::Web::Request request = {Host::Web::Method::Post, url, {}, body};
+            onPath(Path::OutputCommand, [&] { sendHttp(request); });
+            latency.observe();
+        }
+
+        void scrapeRest()
+        {
+            for (const auto* url : {"/state", "/system/heap", "/system/profile", "/system/tasks"})
+                sendHttp({Host::Web::Method::Get, url});
+        }
+
+        void step(const uint32_t nowMs, std::array<Timer, 6>& timers)
+        {
+            if (timers[0].due(nowMs))
+            {
+                for (const auto client : clients) sendSocketCommand(client);
+                for (const auto client : slowClients) sendSocketCommand(client);
+            }
+            for (const auto client : clients) Host::Web::deliverSocket(client);
+            if (timers[1].due(nowMs))
+            {
+                for (const auto client : slowClients) Host::Web::deliverSocket(client);
+            }
+            if (timers[2].due(nowMs)) sendEspNowBurst();
+            if (timers[3].due(nowMs)) pollHue();
+            if (timers[4].due(nowMs)) sendHueCommand();
+            if (timers[5].due(nowMs)) scrapeRest();
+
+            const auto allocationsBefore = Host::Heap::getStats().allocations;
+            const auto start = std::chrono::steady_clock::now();
+            const auto startUs = Host::Clock::nowUs();
+            onPath(Path::Broadcast, [] { loop(); });
+            report.loopMicros.add(Host::Clock::nowUs() - startUs);
+            report.loopNanos.add(nanosSince(start));
+            Host::Workers::runDue();
+            report.loopAllocations.add(Host::Heap::getStats().allocations - allocationsBefore);
+            report.loops++;
+            latency.observe();
+        }
+
+    public:
+        Simulation(const Scenario& scenario, const Options& options)
+            : scenario(scenario), options(options), random(options.seed)
+        {
+        }
+
+        // Returns false when a steady-state path allocated after the warm-up.
+        bool run()
+        {
+            randomSeed(options.seed);
+            boot();
+
+            hueLight = discoverHueLight();
+            const uint8_t clientCount = options.clients ? options.clients : scenario.socketClients;
+            const uint8_t slowCount = std::min(clientCount, scenario.slowSocketClients);
+            for (uint8_t i = 0; i < clientCount; ++i)
+                (i < clientCount - slowCount ? clients : slowClients).push_back(Host::Web::connectSocket());
+
+            if (options.traceDirectory)
+                Host::Web::send({Host::Web::Method::Get, "/system/trace", {{"recording", "1"}, {"clear", "1"}}});
+
+            Host::Heap::resetPeak();
+            Host::Ledc::resetCounters();
+            Host::Nvs::resetCounters();
+            latency.begin();
+            warmUpEndUs = Host::Clock::nowUs() + WARM_UP_MS * 1000ull;
+            const auto socketsBefore = Host::Web::getSocketStats();
+            const auto udpBefore = Host::Network::getUdpResponses();
+
+            const auto slowDrainMs = scenario.slowDrainIntervalMs;
+            std::array timers = {
+                timer(scenario.socketCommandIntervalMs), Timer{slowDrainMs, slowDrainMs},
+                timer(scenario.espNowBurstIntervalMs), timer(scenario.huePollIntervalMs),
+                timer(scenario.hueCommandIntervalMs), timer(scenario.restScrapeIntervalMs)
+            };
+            // One pass per millisecond, like the loop yielding for the rest of it; a pass that overran the
+            // millisecond is followed by the next one right away.
+            const auto startUs = Host::Clock::nowUs();
+            const auto endUs = startUs + options.durationMs * 1000ull;
+            while (Host::Clock::nowUs() < endUs)
+            {
+                const auto nowMs = static_cast<uint32_t>((Host::Clock::nowUs() - startUs) / 1000);
+                step(nowMs, timers);
+                const auto nextUs = startUs + (nowMs + 1) * 1000ull;
+                if (Host::Clock::nowUs() < nextUs) Host::Clock::advanceUs(nextUs - Host::Clock::nowUs());
+            }
+
+            print(socketsBefore, udpBefore);
+            if (options.traceDirectory) saveTrace();
+
+            bool allocationFree = true;
+            for (size_t i = 0; i < static_cast<size_t>(Path::COUNT); ++i)
+            {
+                if (report.pathAllocations[i] == 0) continue;
+                fprintf(stderr, "%s: %s allocated %" PRIu32 " time(s) after the warm-up\n", scenario.name,
+                        PATH_NAMES[i], report.pathAllocations[i]);
+                allocationFree = false;
+            }
+            return allocationFree;
+        }
+
+    private:
+        void saveTrace() const
+        {
+            const auto trace = Host::Web::send({Host::Web::Method::Get, "/system/trace", {{"format", "binary"}}});
+            const auto path = std::string(options.traceDirectory) + "/" + scenario.name + ".trace";
+            FILE* file = fopen(path.c_str(), "wb");
+            if (file == nullptr || fwrite(trace.body.data(), 1, trace.body.size(), file) != trace.body.size())
+                fprintf(stderr, "cannot write %s\n", path.c_str());
+            if (file) fclose(file);
+        }
+
+        void print(const Host::Web::SocketStats& socketsBefore, const uint32_t udpBefore)
+        {
+            const auto heap = Host::Heap::getStats();
+            const auto nvs = Host::Nvs::getStats();
+            const auto sockets = Host::Web::getSocketStats();
+
+            printf("== %s: %s\n", scenario.name, scenario.description);
+            printf("  virtual time      %" PRIu32 " ms, %" PRIu32 " loops\n", options.durationMs, report.loops);
+            printf("  loop time         p50 %" PRIu64 " us, p99 %" PRIu64 " us, max %" PRIu64 " us\n",
+                   report.loopMicros.percentile(0.5), report.loopMicros.percentile(0.99), report.loopMicros.max());
+            if (options.timing)
+            {
+                printf("  loop time (host)  p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+                       report.loopNanos.percentile(0.5), report.loopNanos.percentile(0.99), report.loopNanos.max());
+                if (!report.handlerNanos.samples.empty())
+                {
+                    printf("  handlers (host)   p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+                           report.handlerNanos.percentile(0.5), report.handlerNanos.percentile(0.99),
+                           report.handlerNanos.max());
+                }
+            }
+            printf("  loop allocations  mean %.3f, p99 %" PRIu64 ", max %" PRIu64 "\n",
+                   report.loopAllocations.mean(), report.loopAllocations.percentile(0.99),
+                   report.loopAllocations.max());
+            for (size_t i = 0; i < static_cast<size_t>(Source::COUNT); ++i)
+            {
+                if (latency.injected[i] == 0) continue;
+                auto& samples = latency.latencies[i];
+                printf("  latency %-9s  %" PRIu32 " commands, p50 %" PRIu64 " us, p99 %" PRIu64 " us, max %" PRIu64
+                       " us, lost %" PRIu32 "\n",
+                       SOURCE_NAMES[i], latency.injected[i], samples.percentile(0.5), samples.percentile(0.99),
+                       samples.max(), latency.lost(static_cast<Source>(i)));
+            }
+            for (size_t i = 0; i < static_cast<size_t>(Path::COUNT); ++i)
+            {
+                if (report.pathOperations[i] == 0) continue;
+                printf("  steady allocs     %-15s  %" PRIu32 " in %" PRIu32 " operations\n", PATH_NAMES[i],
+                       report.pathAllocations[i], report.pathOperations[i]);
+            }
+            printf("  heap              peak live %zu B, min free %" PRIu32 " B\n", heap.peakBytes,
+                   esp_get_minimum_free_heap_size());
+            printf("  ledc writes       %" PRIu32 "\n", Host::Ledc::getTotalWrites());
+            printf("  nvs writes        %" PRIu32 " (redundant %" PRIu32 ")\n", nvs.writes, nvs.redundantWrites);
+            printf("  websocket frames  %" PRIu32 ", %" PRIu64 " B, delivered %" PRIu32 ", discarded %" PRIu32
+                   ", peak queue %zu\n",
+                   sockets.messages - socketsBefore.messages, sockets.bytes - socketsBefore.bytes,
+                   sockets.delivered - socketsBefore.delivered, sockets.discarded - socketsBefore.discarded,
+                   sockets.peakQueued);
+            printf("  http requests     %" PRIu32 " (2xx %" PRIu32 ", 4xx %" PRIu32 ", other %" PRIu32 ")\n",
+                   report.httpRequests, report.httpByClass[2], report.httpByClass[4],
+                   report.httpRequests - report.httpByClass[2] - report.httpByClass[4]);
+            printf("  ssdp responses    %" PRIu32 "\n", Host::Network::getUdpResponses() - udpBefore);
+        }
+    };
+
+    void usage(const char* program)
+    {
+        fprintf(stderr, "usage: %s [--duration-ms N] [--seed N] [--clients N] [--no-timing] [--trace DIR] "
+                "[scenario...]\n", program);
+        fprintf(stderr, "scenarios:\n");
+        for (const auto& scenario : SCENARIOS)
+            fprintf(stderr, "  %-15s %s\n", scenario.name, scenario.description);
+    }
+
+    bool parse(const int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            const auto value = [&] { return i + 1 < argc ? strtoul(argv[++i], nullptr, 10) : 0ul; };
+            if (arg == "--duration-ms") options.durationMs = value();
+            else if (arg == "--seed") options.seed = value();
+            else if (arg == "--clients") options.clients = static_cast<uint8_t>(value());
+            else if (arg == "--no-timing") options.timing = false;
+            else if (arg == "--trace" && i + 1 < argc) options.traceDirectory = argv[++i];
+            else if (arg.starts_with("-")) return false;
+            else options.scenarios.push_back(arg);
+        }
+        return options.durationMs > 0;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    bool matched = false;
+    for (const auto& scenario : SCENARIOS)
+    {
+        const auto& selected = options.scenarios;
+        if (!selected.empty() && std::ranges::find(selected, scenario.name) == selected.end()) continue;
+        matched = true;
+
+        fflush(stdout);
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            const bool allocationFree = Simulation(scenario, options).run();
+            fflush(stdout);
+            _exit(allocationFree ? 0 : 1);
+        }
+        int status = 0;
+        if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "scenario %s failed\n", scenario.name);
+            failures++;
+        }
+    }
+
+    if (!matched)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}
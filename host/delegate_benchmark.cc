@@ -0,0 +1,100 @@
+// Compares Delegate with std::function for the callback shapes used by the firmware:
+// call overhead, inline size and heap usage per stored callback.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include "delegate.hh"
+
+namespace
+{
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+
+    constexpr uint32_t ITERATIONS = 50'000'000;
+
+    struct Target
+    {
+        volatile uint32_t sum = 0;
+
+        void add(const uint8_t value)
+        {
+            sum = sum + value;
+        }
+    };
+
+    template <typename Callback>
+    double nanosPerCall(const Callback& callback)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; ++i)
+            callback(static_cast<uint8_t>(i));
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+    }
+
+    template <typename Callback, typename F>
+    size_t heapBytesToStore(F&& callable)
+    {
+        const auto before = allocatedBytes;
+        const Callback callback(std::forward<F>(callable));
+        (void)callback;
+        return allocatedBytes - before;
+    }
+
+    template <typename F>
+    void report(const char* shape, F callable)
+    {
+        const auto functionHeap = heapBytesToStore<std::function<void(uint8_t)>>(callable);
+        const auto delegateHeap = heapBytesToStore<Delegate<void(uint8_t)>>(callable);
+        const auto functionNs = nanosPerCall(std::function<void(uint8_t)>(callable));
+        const auto delegateNs = nanosPerCall(Delegate<void(uint8_t)>(callable));
+
+        printf("%-28s capture %2zu B | std::function %2zu B + %2zu B heap, %5.2f ns/call"
+               " | Delegate %2zu B + %zu B heap, %5.2f ns/call\n",
+               shape, sizeof(F),
+               sizeof(std::function<void(uint8_t)>), functionHeap, functionNs,
+               sizeof(Delegate<void(uint8_t)>), delegateHeap, delegateNs);
+    }
+
+    void freeFunction(uint8_t)
+    {
+    }
+}
+
+void* operator new(const size_t size)
+{
+    allocations++;
+    allocatedBytes += size;
+    if (void* ptr = malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+int main()
+{
+    Target target;
+    auto* self = &target;
+    const char* name = "device";
+    const uint8_t color = 2;
+
+    report("function pointer", &freeFunction);
+    report("[this]", [self](const uint8_t value) { self->add(value); });
+    report("[this, name]", [self, name](const uint8_t value) { self->add(value + (name != nullptr)); });
+    report("[this, name, color]", [self, name, color](const uint8_t value) { self->add(value + color + (name != nullptr)); });
+
+    printf("\nHeap allocations in total: %zu\n", allocations);
+    return 0;
+}
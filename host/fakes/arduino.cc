@@ -0,0 +1,339 @@
+#include "host.hh"
+
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include <Arduino.h>
+#include <esp_cpu.h>
+#include <esp_pm.h>
+#include <esp_rom_crc.h>
+#include <esp_rom_sys.h>
+#include <iot_knob.h>
+
+namespace
+{
+    uint64_t clockUs = 0;
+    uint32_t cpuMhz = Host::Clock::CPU_MHZ;
+    uint32_t restarts = 0;
+    esp_reset_reason_t resetReason = ESP_RST_POWERON;
+    uint32_t randomState = 1;
+
+    std::array<int, GPIO_NUM_MAX> levels = {};
+    std::array<uint32_t, GPIO_NUM_MAX> milliVolts = {};
+    std::array<Host::Ledc::Channel, Host::Ledc::MAX_CHANNELS> channels = {};
+
+    esp_log_level_t defaultLogLevel = ESP_LOG_WARN;
+    // Transparent, so looking a tag up does not build a std::string.
+    std::map<std::string, esp_log_level_t, std::less<>> tagLogLevels;
+
+    struct Knob
+    {
+        std::array<knob_cb_t, KNOB_EVENT_MAX> callbacks = {};
+        std::array<void*, KNOB_EVENT_MAX> args = {};
+    };
+
+    Knob* knob = nullptr;
+}
+
+namespace Host
+{
+    namespace Clock
+    {
+        uint64_t nowUs()
+        {
+            return clockUs;
+        }
+
+        void advanceUs(const uint64_t us)
+        {
+            clockUs += us;
+        }
+
+        void advanceMs(const uint32_t ms)
+        {
+            clockUs += static_cast<uint64_t>(ms) * 1000;
+        }
+
+        void reset()
+        {
+            clockUs = 0;
+        }
+    }
+
+    namespace Gpio
+    {
+        void setLevel(const uint8_t pin, const int level)
+        {
+            if (pin < levels.size()) levels[pin] = level;
+        }
+
+        int getLevel(const uint8_t pin)
+        {
+            return pin < levels.size() ? levels[pin] : LOW;
+        }
+
+        void setMilliVolts(const uint8_t pin, const uint32_t value)
+        {
+            if (pin < milliVolts.size()) milliVolts[pin] = value;
+        }
+    }
+
+    namespace Ledc
+    {
+        Channel getChannel(const uint8_t channel)
+        {
+            return channel < channels.size() ? channels[channel] : Channel{};
+        }
+
+        uint32_t getTotalWrites()
+        {
+            uint32_t total = 0;
+            for (const auto& channel : channels)
+                total += channel.writes;
+            return total;
+        }
+
+        void resetCounters()
+        {
+            for (auto& channel : channels)
+                channel.writes = 0;
+        }
+    }
+
+    namespace System
+    {
+        uint32_t getRestarts()
+        {
+            return restarts;
+        }
+
+        void setResetReason(const esp_reset_reason_t reason)
+        {
+            resetReason = reason;
+        }
+    }
+
+    namespace Knob
+    {
+        void turn(const bool left)
+        {
+            if (!knob) return;
+            const auto event = left ? KNOB_LEFT : KNOB_RIGHT;
+            if (const auto callback = knob->callbacks[event])
+                callback(knob, knob->args[event]);
+        }
+    }
+}
+
+unsigned long millis()
+{
+    return static_cast<unsigned long>(clockUs / 1000);
+}
+
+unsigned long micros()
+{
+    return static_cast<unsigned long>(clockUs);
+}
+
+void delay(const uint32_t ms)
+{
+    Host::Clock::advanceMs(ms);
+}
+
+void delayMicroseconds(const uint32_t us)
+{
+    Host::Clock::advanceUs(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(const uint8_t pin, const uint8_t value)
+{
+    Host::Gpio::setLevel(pin, value);
+}
+
+int digitalRead(const uint8_t pin)
+{
+    return Host::Gpio::getLevel(pin);
+}
+
+uint32_t analogReadMilliVolts(const uint8_t pin)
+{
+    return pin < milliVolts.size() ? milliVolts[pin] : 0;
+}
+
+bool ledcAttach(uint8_t pin, uint32_t frequency, uint8_t resolution)
+{
+    return true;
+}
+
+// Light drives LEDC by channel number, so `pin` indexes the channel table.
+bool ledcWrite(const uint8_t pin, const uint32_t duty)
+{
+    if (pin >= channels.size()) return false;
+    Host::Clock::advanceUs(Host::Cost::LEDC_WRITE_US);
+    channels[pin].writes++;
+    channels[pin].duty = duty;
+    return true;
+}
+
+long random(const long max)
+{
+    return max > 0 ? random(0, max) : 0;
+}
+
+long random(const long min, const long max)
+{
+    if (max <= min) return min;
+    randomState = randomState * 1103515245u + 12345u;
+    return min + static_cast<long>((randomState >> 1) % static_cast<uint32_t>(max - min));
+}
+
+void randomSeed(const unsigned long seed)
+{
+    randomState = static_cast<uint32_t>(seed);
+}
+
+int64_t esp_timer_get_time()
+{
+    return static_cast<int64_t>(clockUs);
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count()
+{
+    return static_cast<esp_cpu_cycle_count_t>(clockUs * cpuMhz);
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return cpuMhz;
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us()
+{
+    return cpuMhz;
+}
+
+bool setCpuFrequencyMhz(const uint32_t cpuFrequencyMhz)
+{
+    cpuMhz = cpuFrequencyMhz;
+    return true;
+}
+
+void esp_restart()
+{
+    restarts++;
+}
+
+esp_reset_reason_t esp_reset_reason()
+{
+    return resetReason;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, const uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; ++bit)
+            crc = crc & 1 ? crc >> 1 ^ 0xEDB88320u : crc >> 1;
+    }
+    return ~crc;
+}
+
+struct esp_pm_lock
+{
+    esp_pm_lock_type_t type;
+    uint32_t count = 0;
+};
+
+esp_err_t esp_pm_configure(const void* config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_pm_lock_create(const esp_pm_lock_type_t lock_type, int, const char*,
+                             esp_pm_lock_handle_t* out_handle)
+{
+    // Created once at boot and never deleted, like on the device.
+    *out_handle = new esp_pm_lock{lock_type};
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(const esp_pm_lock_handle_t handle)
+{
+    handle->count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(const esp_pm_lock_handle_t handle)
+{
+    if (handle->count == 0) return ESP_ERR_INVALID_STATE;
+    handle->count--;
+    return ESP_OK;
+}
+
+void esp_log_level_set(const char* tag, const esp_log_level_t level)
+{
+    if (std::string_view(tag) == "*")
+    {
+        defaultLogLevel = level;
+        tagLogLevels.clear();
+        return;
+    }
+    tagLogLevels[tag] = level;
+}
+
+esp_log_level_t esp_log_level_get(const char* tag)
+{
+    const auto it = tagLogLevels.find(std::string_view(tag));
+    return it != tagLogLevels.end() ? it->second : defaultLogLevel;
+}
+
+void esp_log_writev(const esp_log_level_t level, const char* tag, const char* format, va_list args)
+{
+    if (level > esp_log_level_get(tag)) return;
+    static constexpr char LETTERS[] = "NEWIDV";
+    fprintf(stderr, "%c (%lu) %s: ", LETTERS[level], millis(), tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+}
+
+void esp_log_write(const esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    esp_log_writev(level, tag, format, args);
+    va_end(args);
+}
+
+knob_handle_t iot_knob_create(const knob_config_t* config)
+{
+    if (knob) return nullptr;
+    knob = new Knob();
+    return knob;
+}
+
+esp_err_t iot_knob_delete(const knob_handle_t knob_handle)
+{
+    if (knob_handle != knob) return ESP_ERR_INVALID_ARG;
+    delete knob;
+    knob = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t iot_knob_register_cb(const knob_handle_t knob_handle, const knob_event_t event, const knob_cb_t cb,
+                               void* usr_data)
+{
+    if (knob_handle != knob || event >= KNOB_EVENT_MAX) return ESP_ERR_INVALID_ARG;
+    knob->callbacks[event] = cb;
+    knob->args[event] = usr_data;
+    return ESP_OK;
+}
@@ -0,0 +1,151 @@
+#include "host.hh"
+
+#include <cstring>
+#include <deque>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <freertos/FreeRTOS.h> // NOLINT
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+struct tskTaskControlBlock
+{
+    std::string name;
+    uint32_t stackDepth;
+    UBaseType_t priority;
+    BaseType_t core;
+    UBaseType_t number;
+};
+
+struct QueueDefinition
+{
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+namespace
+{
+    // The Arduino loop task, i.e. the thread running the simulation.
+    tskTaskControlBlock loopTask = {"loopTask", CONFIG_ARDUINO_LOOP_STACK_SIZE, 1, 1, 1};
+
+    std::list<tskTaskControlBlock>& getTasks()
+    {
+        static std::list<tskTaskControlBlock> tasks;
+        return tasks;
+    }
+
+    UBaseType_t nextTaskNumber = 2;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, const uint32_t stackDepth,
+                                   void* parameters, const UBaseType_t priority, TaskHandle_t* createdTask,
+                                   const BaseType_t coreId)
+{
+    auto& task = getTasks().emplace_back(tskTaskControlBlock{name, stackDepth, priority, coreId, nextTaskNumber++});
+    if (createdTask) *createdTask = &task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == nullptr || task == &loopTask) return;
+    getTasks().remove_if([task](const tskTaskControlBlock& entry) { return &entry == task; });
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    Host::Clock::advanceMs(ticks * portTICK_PERIOD_MS);
+}
+
+void vTaskPrioritySet(TaskHandle_t task, const UBaseType_t priority)
+{
+    (task ? task : &loopTask)->priority = priority;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return &loopTask;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name)
+{
+    if (loopTask.name == name) return &loopTask;
+    for (auto& task : getTasks())
+        if (task.name == name) return &task;
+    return nullptr;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    return (task ? task : &loopTask)->core;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks()
+{
+    return static_cast<UBaseType_t>(1 + getTasks().size());
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* statuses, const UBaseType_t size, uint32_t* totalRunTime)
+{
+    // Like FreeRTOS, fills in nothing when the array cannot hold every task.
+    if (size < uxTaskGetNumberOfTasks()) return 0;
+    // Only the loop task ever runs, so it owns all of the elapsed time.
+    const auto now = static_cast<uint32_t>(Host::Clock::nowUs());
+    UBaseType_t count = 0;
+    const auto add = [&](tskTaskControlBlock& task, const eTaskState state, const uint32_t runTime)
+    {
+        statuses[count++] = {
+            &task, task.name.c_str(), task.number, state, task.priority, task.priority, runTime, nullptr,
+            task.stackDepth / 2, task.core
+        };
+    };
+    add(loopTask, eRunning, now);
+    for (auto& task : getTasks())
+        add(task, eBlocked, 0);
+    if (totalRunTime) *totalRunTime = now;
+    return count;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return (task ? task : &loopTask)->stackDepth / 2;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return static_cast<TickType_t>(Host::Clock::nowUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t itemSize)
+{
+    return new QueueDefinition{length, itemSize, {}};
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait)
+{
+    if (queue->items.size() >= queue->length) return errQUEUE_FULL;
+    const auto* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait)
+{
+    if (queue->items.empty()) return errQUEUE_EMPTY;
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return static_cast<UBaseType_t>(queue->items.size());
+}
@@ -0,0 +1,186 @@
+#include "host.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <malloc.h>
+
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+
+extern "C" void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps);
+extern "C" void esp_heap_trace_free_hook(void* ptr);
+
+// The C allocator itself; every other object reaches malloc() and friends through the --wrap stubs below.
+extern "C" void* __real_malloc(size_t size);
+extern "C" void __real_free(void* ptr);
+
+namespace
+{
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+    size_t lowestFree = Host::Heap::CAPACITY;
+    uint32_t allocations = 0;
+    uint32_t frees = 0;
+    uint32_t firmwareAllocations = 0;
+    bool inLibrary = false;
+
+    // Sizes are taken from the allocator so a free needs no bookkeeping of its own.
+    void* allocate(const size_t size, const size_t alignment = 0)
+    {
+        void* ptr = alignment > alignof(std::max_align_t)
+                        ? aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                        : __real_malloc(size ? size : 1);
+        if (!ptr) return nullptr;
+
+        liveBytes += malloc_usable_size(ptr);
+        allocations++;
+        if (!inLibrary) firmwareAllocations++;
+        if (liveBytes > peakBytes) peakBytes = liveBytes;
+        if (const auto free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT); free < lowestFree) lowestFree = free;
+        esp_heap_trace_alloc_hook(ptr, size, MALLOC_CAP_DEFAULT);
+        return ptr;
+    }
+
+    void release(void* ptr)
+    {
+        if (!ptr) return;
+        esp_heap_trace_free_hook(ptr);
+        liveBytes -= malloc_usable_size(ptr);
+        frees++;
+        __real_free(ptr);
+    }
+
+    void* allocateOrThrow(const size_t size, const size_t alignment = 0)
+    {
+        if (void* ptr = allocate(size, alignment)) return ptr;
+        throw std::bad_alloc();
+    }
+}
+
+namespace Host::Heap
+{
+    Stats getStats()
+    {
+        return {liveBytes, peakBytes, allocations, frees, firmwareAllocations};
+    }
+
+    void resetPeak()
+    {
+        peakBytes = liveBytes;
+    }
+
+    void* allocateUntracked(const size_t size)
+    {
+        return __real_malloc(size);
+    }
+
+    void releaseUntracked(void* ptr)
+    {
+        __real_free(ptr);
+    }
+
+    LibraryScope::LibraryScope() : previous(std::exchange(inLibrary, true))
+    {
+    }
+
+    LibraryScope::~LibraryScope()
+    {
+        inLibrary = previous;
+    }
+
+    FirmwareScope::FirmwareScope() : previous(std::exchange(inLibrary, false))
+    {
+    }
+
+    FirmwareScope::~FirmwareScope()
+    {
+        inLibrary = previous;
+    }
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return liveBytes < Host::Heap::CAPACITY ? Host::Heap::CAPACITY - liveBytes : 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return lowestFree;
+}
+
+size_t heap_caps_get_largest_free_block(const uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+uint32_t esp_get_free_heap_size()
+{
+    return heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+uint32_t esp_get_minimum_free_heap_size()
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+}
+
+void* operator new(const size_t size) { return allocateOrThrow(size); }
+void* operator new[](const size_t size) { return allocateOrThrow(size); }
+void* operator new(const size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(const size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](const size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { release(ptr); }
+
+// Linked with --wrap, so C allocations from the firmware, ArduinoJson and the fakes are counted and hooked like
+// operator new. Blocks libc allocates for itself never pass through here.
+extern "C" void* __wrap_malloc(const size_t size)
+{
+    return allocate(size);
+}
+
+extern "C" void* __wrap_calloc(const size_t count, const size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size) return nullptr;
+    void* ptr = allocate(count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+// Always moves the block, so the heap hooks see a free and an allocation like on the device.
+extern "C" void* __wrap_realloc(void* ptr, const size_t size)
+{
+    if (!ptr) return allocate(size);
+    if (size == 0)
+    {
+        release(ptr);
+        return nullptr;
+    }
+    void* moved = allocate(size);
+    if (!moved) return nullptr;
+    memcpy(moved, ptr, std::min(size, malloc_usable_size(ptr)));
+    release(ptr);
+    return moved;
+}
+
+extern "C" void __wrap_free(void* ptr)
+{
+    release(ptr);
+}
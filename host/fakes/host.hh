@@ -0,0 +1,274 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "esp_system.h"
+
+/**
+ * Control surface of the in-memory fakes behind the host shims.
+ * Firmware code only sees the Arduino/IDF APIs; simulations and tools use
+ * this namespace to drive time, inject traffic and read back what the
+ * firmware did to the hardware.
+ */
+namespace Host
+{
+    /**
+     * Virtual time. Only delay()/vTaskDelay() and the Cost charges of the
+     * faked peripherals advance it, so a run is fully determined by the calls
+     * made against it.
+     */
+    namespace Clock
+    {
+        static constexpr uint32_t CPU_MHZ = 240;
+
+        [[nodiscard]] uint64_t nowUs();
+        void advanceUs(uint64_t us);
+        void advanceMs(uint32_t ms);
+        void reset();
+    }
+
+    /**
+     * Nominal time the device spends in the faked operations. Each fake charges
+     * it to the virtual clock, so loop time and command latency measure the
+     * work done instead of reading zero. Rough ESP32 figures at 240 MHz: good
+     * for comparing runs, not for predicting the device.
+     */
+    namespace Cost
+    {
+        static constexpr uint32_t LEDC_WRITE_US = 8;
+        // Start, address and stop, plus the driver's queueing.
+        static constexpr uint32_t I2C_TRANSACTION_US = 30;
+        // Nine bit times at 400 kHz.
+        static constexpr uint32_t I2C_BYTE_US = 23;
+        // A changed value: the entry is written and the page header updated.
+        static constexpr uint32_t NVS_WRITE_US = 2500;
+        // Copying a frame into a client's send queue.
+        static constexpr uint32_t WEBSOCKET_FRAME_US = 25;
+        // Filling and sending one TCP segment of an HTTP response.
+        static constexpr uint32_t HTTP_SEGMENT_US = 150;
+        static constexpr uint32_t UDP_SEND_US = 120;
+    }
+
+    namespace Gpio
+    {
+        void setLevel(uint8_t pin, int level);
+        [[nodiscard]] int getLevel(uint8_t pin);
+        void setMilliVolts(uint8_t pin, uint32_t milliVolts);
+    }
+
+    namespace Ledc
+    {
+        static constexpr uint8_t MAX_CHANNELS = 16;
+
+        struct Channel
+        {
+            uint32_t writes = 0;
+            uint32_t duty = 0;
+        };
+
+        [[nodiscard]] Channel getChannel(uint8_t channel);
+        [[nodiscard]] uint32_t getTotalWrites();
+        void resetCounters();
+    }
+
+    /**
+     * I2C bus where every address from 0x40 to 0x7F answers as a PCA9685,
+     * keeping its register file, unless it was removed with setPresent().
+     */
+    namespace I2c
+    {
+        struct Stats
+        {
+            uint32_t transactions = 0;
+            // Bytes after the address byte.
+            uint32_t bytes = 0;
+            // Transactions to an address nothing answered on.
+            uint32_t nacks = 0;
+        };
+
+        [[nodiscard]] Stats getStats();
+        [[nodiscard]] uint8_t getRegister(uint8_t address, uint8_t reg);
+        // Off time of PCA9685 `channel` in 1/4096 of a period; 4096 when fully on.
+        [[nodiscard]] uint16_t getPwm(uint8_t address, uint8_t channel);
+        void setPresent(uint8_t address, bool present);
+        void resetCounters();
+    }
+
+    namespace Nvs
+    {
+        struct Stats
+        {
+            // put*() calls that changed the stored value, i.e. flash writes on the device.
+            uint32_t writes = 0;
+            // put*() calls that stored the value already present; NVS skips those.
+            uint32_t redundantWrites = 0;
+            uint32_t reads = 0;
+            uint32_t removes = 0;
+        };
+
+        [[nodiscard]] Stats getStats();
+        void resetCounters();
+        void erase();
+    }
+
+    /**
+     * Heap as seen by the firmware: a fixed capacity minus what is live through
+     * operator new/delete. Every allocation is also reported to the
+     * esp_heap_trace hooks, so the firmware heap accounting works unchanged.
+     */
+    namespace Heap
+    {
+        static constexpr size_t CAPACITY = 300 * 1024;
+
+        struct Stats
+        {
+            size_t liveBytes = 0;
+            size_t peakBytes = 0;
+            uint32_t allocations = 0;
+            uint32_t frees = 0;
+            // Allocations made outside a LibraryScope, i.e. by firmware code.
+            uint32_t firmwareAllocations = 0;
+        };
+
+        [[nodiscard]] Stats getStats();
+        void resetPeak();
+
+        // Harness bookkeeping that must not show up in the firmware's heap figures.
+        [[nodiscard]] void* allocateUntracked(size_t size);
+        void releaseUntracked(void* ptr);
+
+        /**
+         * Attributes allocations to the library a fake stands in for (the web
+         * server, the WebSocket and network stacks) until the scope ends; a
+         * nested FirmwareScope hands them back around firmware callbacks.
+         * Only the attribution changes: the heap figures include both.
+         */
+        class LibraryScope
+        {
+            const bool previous;
+
+        public:
+            LibraryScope();
+            ~LibraryScope();
+
+            LibraryScope(const LibraryScope&) = delete;
+            LibraryScope& operator=(const LibraryScope&) = delete;
+        };
+
+        class FirmwareScope
+        {
+            const bool previous;
+
+        public:
+            FirmwareScope();
+            ~FirmwareScope();
+
+            FirmwareScope(const FirmwareScope&) = delete;
+            FirmwareScope& operator=(const FirmwareScope&) = delete;
+        };
+    }
+
+    namespace System
+    {
+        [[nodiscard]] uint32_t getRestarts();
+        // What esp_reset_reason() reports to the next boot.
+        void setResetReason(esp_reset_reason_t reason);
+    }
+
+    namespace Workers
+    {
+        // Runs every job posted to the worker pool that is due at the current virtual time.
+        uint32_t runDue();
+        [[nodiscard]] size_t getPending();
+    }
+
+    namespace Network
+    {
+        static constexpr std::array<uint8_t, 6> MAC = {0x24, 0x6F, 0x28, 0xA1, 0xB2, 0xC3};
+        static constexpr std::array<uint8_t, 4> IP = {192, 168, 1, 50};
+
+        // Delivers the Wi-Fi events of a successful association to WiFi.onEvent() listeners.
+        void connect();
+        void disconnect(uint8_t reason);
+        [[nodiscard]] const std::string& getSsid();
+
+        // Queues an SSDP datagram for the Alexa UDP socket.
+        void injectUdp(const std::string& datagram);
+        [[nodiscard]] uint32_t getUdpResponses();
+    }
+
+    namespace Web
+    {
+        enum class Method : uint8_t
+        {
+            Get,
+            Post
+        };
+
+        struct Request
+        {
+            Method method = Method::Get;
+            std::string url;
+            std::vector<std::pair<std::string, std::string>> params = {};
+            std::string body = {};
+            bool authenticated = true;
+            std::vector<std::pair<std::string, std::string>> headers = {};
+        };
+
+        struct Response
+        {
+            int code = 0;
+            std::string contentType;
+            std::string body;
+        };
+
+        // Routes the request through the handlers registered on the AsyncWebServer, like async_tcp would.
+        Response send(const Request& request);
+
+        using ClientId = uint32_t;
+
+        struct SocketStats
+        {
+            // Frames enqueued, and their size.
+            uint32_t messages = 0;
+            uint64_t bytes = 0;
+            // Frames refused because the client's queue was full.
+            uint32_t discarded = 0;
+            uint32_t delivered = 0;
+            // Deepest any client's send queue got.
+            size_t peakQueued = 0;
+        };
+
+        [[nodiscard]] ClientId connectSocket();
+        void sendSocket(ClientId client, const uint8_t* data, size_t len);
+        void closeSocket(ClientId client);
+        // Hands the frames queued for `client` to it, as the TCP stack draining its send queue would.
+        void deliverSocket(ClientId client);
+        void deliverSockets();
+        [[nodiscard]] SocketStats getSocketStats();
+    }
+
+    namespace Ble
+    {
+        void connect();
+        void disconnect();
+        bool write(const char* uuid, const uint8_t* data, size_t len);
+        [[nodiscard]] std::string read(const char* uuid);
+        [[nodiscard]] uint32_t getNotifications();
+    }
+
+    namespace EspNow
+    {
+        void receive(const std::array<uint8_t, 6>& mac, const uint8_t* data, size_t len);
+    }
+
+    namespace Knob
+    {
+        void turn(bool left);
+    }
+}
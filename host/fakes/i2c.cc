@@ -0,0 +1,113 @@
+#include "host.hh"
+
+#include <Wire.h>
+
+TwoWire Wire;
+
+namespace
+{
+    constexpr uint8_t FIRST_ADDRESS = 0x40;
+    constexpr uint8_t DEVICES = 0x40;
+    constexpr uint8_t MODE1 = 0x00;
+    constexpr uint8_t MODE1_AUTO_INCREMENT = 0x20;
+    constexpr uint8_t LED0_ON_L = 0x06;
+    constexpr uint8_t FULL = 0x10;
+
+    struct Device
+    {
+        bool present = true;
+        std::array<uint8_t, 256> registers = {};
+    };
+
+    std::array<Device, DEVICES> devices;
+    Host::I2c::Stats stats;
+
+    Device* find(const uint8_t address)
+    {
+        if (address < FIRST_ADDRESS || address - FIRST_ADDRESS >= DEVICES) return nullptr;
+        auto& device = devices[address - FIRST_ADDRESS];
+        return device.present ? &device : nullptr;
+    }
+}
+
+namespace Host::I2c
+{
+    Stats getStats()
+    {
+        return stats;
+    }
+
+    uint8_t getRegister(const uint8_t address, const uint8_t reg)
+    {
+        const auto device = find(address);
+        return device ? device->registers[reg] : 0;
+    }
+
+    uint16_t getPwm(const uint8_t address, const uint8_t channel)
+    {
+        const auto base = LED0_ON_L + 4 * channel;
+        if (getRegister(address, base + 1) & FULL) return 4096;
+        if (getRegister(address, base + 3) & FULL) return 0;
+        return static_cast<uint16_t>((getRegister(address, base + 3) & 0x0F) << 8 | getRegister(address, base + 2));
+    }
+
+    void setPresent(const uint8_t address, const bool present)
+    {
+        if (address >= FIRST_ADDRESS && address - FIRST_ADDRESS < DEVICES)
+            devices[address - FIRST_ADDRESS].present = present;
+    }
+
+    void resetCounters()
+    {
+        stats = {};
+    }
+}
+
+bool TwoWire::begin(int, int, uint32_t)
+{
+    return true;
+}
+
+void TwoWire::beginTransmission(const uint8_t address)
+{
+    this->address = address;
+    length = 0;
+    transmitting = true;
+}
+
+size_t TwoWire::write(const uint8_t data)
+{
+    if (!transmitting || length == buffer.size()) return 0;
+    buffer[length++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, const size_t len)
+{
+    size_t written = 0;
+    while (written < len && write(data[written])) written++;
+    return written;
+}
+
+uint8_t TwoWire::endTransmission(bool)
+{
+    transmitting = false;
+    Host::Clock::advanceUs(Host::Cost::I2C_TRANSACTION_US + Host::Cost::I2C_BYTE_US * length);
+    stats.transactions++;
+    stats.bytes += length;
+    const auto device = find(address);
+    if (device == nullptr)
+    {
+        stats.nacks++;
+        return 2;
+    }
+    // The first byte selects the register, the rest are written from there on.
+    if (length == 0) return 0;
+    auto reg = buffer[0];
+    for (size_t i = 1; i < length; ++i)
+    {
+        device->registers[reg] = buffer[i];
+        if (device->registers[MODE1] & MODE1_AUTO_INCREMENT) reg++;
+    }
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include "host.hh"
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_now.h>
+
+WiFiClass WiFi;
+
+namespace
+{
+    std::string hostname = "esp32";
+    std::string requestedSsid;
+    std::string connectedSsid;
+    bool connected = false;
+    int16_t scanResult = WIFI_SCAN_FAILED;
+
+    struct Listener
+    {
+        WiFiEventFuncCb callback;
+        arduino_event_id_t event;
+    };
+
+    std::vector<Listener> listeners;
+
+    std::deque<std::string> datagrams;
+    uint32_t udpResponses = 0;
+
+    bool espNowStarted = false;
+    esp_now_recv_cb_t espNowReceive = nullptr;
+    std::vector<std::array<uint8_t, ESP_NOW_ETH_ALEN>> espNowPeers;
+
+    void dispatch(const arduino_event_id_t event, const arduino_event_info_t& info)
+    {
+        // Copied: a listener may register another one while being notified.
+        const auto current = listeners;
+        for (const auto& listener : current)
+        {
+            if (listener.event == ARDUINO_EVENT_MAX || listener.event == event)
+                listener.callback(event, info);
+        }
+    }
+
+    IPAddress toAddress(const std::array<uint8_t, 4>& octets)
+    {
+        return {octets[0], octets[1], octets[2], octets[3]};
+    }
+}
+
+namespace Host
+{
+    namespace Network
+    {
+        void connect()
+        {
+            connected = true;
+            connectedSsid = requestedSsid;
+            dispatch(ARDUINO_EVENT_WIFI_STA_CONNECTED, {});
+            dispatch(ARDUINO_EVENT_WIFI_STA_GOT_IP, {});
+        }
+
+        void disconnect(const uint8_t reason)
+        {
+            connected = false;
+            arduino_event_info_t info = {};
+            info.wifi_sta_disconnected.reason = reason;
+            dispatch(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+        }
+
+        const std::string& getSsid()
+        {
+            return requestedSsid;
+        }
+
+        void injectUdp(const std::string& datagram)
+        {
+            datagrams.push_back(datagram);
+        }
+
+        uint32_t getUdpResponses()
+        {
+            return udpResponses;
+        }
+    }
+
+    namespace EspNow
+    {
+        void receive(const std::array<uint8_t, 6>& mac, const uint8_t* data, const size_t len)
+        {
+            if (!espNowStarted || !espNowReceive) return;
+            std::array<uint8_t, 6> source = mac;
+            std::array<uint8_t, 6> destination = Network::MAC;
+            wifi_pkt_rx_ctrl_t rxControl = {-50, 1};
+            const esp_now_recv_info_t info = {source.data(), destination.data(), &rxControl};
+            espNowReceive(&info, data, static_cast<int>(len));
+        }
+    }
+}
+
+bool WiFiClass::setHostname(const char* name)
+{
+    hostname = name;
+    return true;
+}
+
+const char* WiFiClass::getHostname()
+{
+    return hostname.c_str();
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, const arduino_event_id_t event)
+{
+    listeners.push_back({std::move(callback), event});
+    return static_cast<wifi_event_id_t>(listeners.size());
+}
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac)
+{
+    memcpy(mac, Host::Network::MAC.data(), Host::Network::MAC.size());
+    return mac;
+}
+
+String WiFiClass::macAddress()
+{
+    const auto& mac = Host::Network::MAC;
+    char text[18];
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return text;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return connected ? toAddress(Host::Network::IP) : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP()
+{
+    return connected ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask()
+{
+    return connected ? IPAddress(255, 255, 255, 0) : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index)
+{
+    return connected ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+String WiFiClass::SSID() const
+{
+    return connected ? String(connectedSsid) : String();
+}
+
+String WiFiClass::SSID(uint8_t networkItem)
+{
+    return {};
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t networkItem)
+{
+    return WIFI_AUTH_OPEN;
+}
+
+int WiFiClass::begin(const char* ssid, const char* passphrase)
+{
+    requestedSsid = ssid ? ssid : "";
+    return 0;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp)
+{
+    if (!connected) return false;
+    Host::Network::disconnect(WIFI_REASON_UNSPECIFIED);
+    return true;
+}
+
+bool WiFiClass::reconnect()
+{
+    return !requestedSsid.empty();
+}
+
+bool WiFiClass::isConnected() const
+{
+    return connected;
+}
+
+// A steady, reasonably strong signal while associated; 0 like the real driver otherwise.
+int8_t WiFiClass::RSSI()
+{
+    return connected ? -60 : 0;
+}
+
+// No access points are visible from the host, so every scan completes empty.
+int16_t WiFiClass::scanNetworks(bool async)
+{
+    scanResult = 0;
+    return scanResult;
+}
+
+int16_t WiFiClass::scanComplete()
+{
+    return scanResult;
+}
+
+void WiFiClass::scanDelete()
+{
+    scanResult = WIFI_SCAN_FAILED;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress address, uint16_t port)
+{
+    listening = true;
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    listening = false;
+    clear();
+}
+
+int WiFiUDP::parsePacket()
+{
+    if (!listening || datagrams.empty()) return 0;
+    packet = std::move(datagrams.front());
+    datagrams.pop_front();
+    readPosition = 0;
+    return static_cast<int>(packet.size());
+}
+
+int WiFiUDP::read(uint8_t* buffer, const size_t len)
+{
+    const size_t count = std::min(len, packet.size() - readPosition);
+    memcpy(buffer, packet.data() + readPosition, count);
+    readPosition += count;
+    return static_cast<int>(count);
+}
+
+void WiFiUDP::clear()
+{
+    packet.clear();
+    readPosition = 0;
+}
+
+int WiFiUDP::endPacket()
+{
+    Host::Clock::advanceUs(Host::Cost::UDP_SEND_US);
+    udpResponses++;
+    return 1;
+}
+
+esp_err_t esp_now_init()
+{
+    espNowStarted = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit()
+{
+    espNowStarted = false;
+    espNowReceive = nullptr;
+    espNowPeers.clear();
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(const esp_now_recv_cb_t cb)
+{
+    if (!espNowStarted) return ESP_ERR_ESPNOW_NOT_INIT;
+    espNowReceive = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    return espNowStarted ? ESP_OK : ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer)
+{
+    if (!espNowStarted) return ESP_ERR_ESPNOW_NOT_INIT;
+    if (esp_now_is_peer_exist(peer->peer_addr)) return ESP_ERR_ESPNOW_EXIST;
+    auto& address = espNowPeers.emplace_back();
+    memcpy(address.data(), peer->peer_addr, ESP_NOW_ETH_ALEN);
+    return ESP_OK;
+}
+
+bool esp_now_is_peer_exist(const uint8_t* peer_addr)
+{
+    for (const auto& peer : espNowPeers)
+        if (memcmp(peer.data(), peer_addr, ESP_NOW_ETH_ALEN) == 0) return true;
+    return false;
+}
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, const size_t len)
+{
+    if (!espNowStarted) return ESP_ERR_ESPNOW_NOT_INIT;
+    if (len > ESP_NOW_MAX_DATA_LEN) return ESP_ERR_ESPNOW_ARG;
+    return esp_now_is_peer_exist(peer_addr) ? ESP_OK : ESP_ERR_ESPNOW_NOT_FOUND;
+}
@@ -0,0 +1,129 @@
+#include "host.hh"
+
+#include <algorithm>
+#include <memory>
+
+#include <NimBLEDevice.h>
+
+namespace
+{
+    std::unique_ptr<NimBLEServer> server;
+    bool initialized = false;
+    uint32_t notifications = 0;
+
+    NimBLECharacteristic* find(const char* uuid)
+    {
+        return server ? server->findCharacteristic(uuid) : nullptr;
+    }
+
+    NimBLEConnInfo connInfo(const uint16_t connHandle)
+    {
+        NimBLEConnInfo info;
+        info.connHandle = connHandle;
+        return info;
+    }
+}
+
+namespace Host::Ble
+{
+    void connect()
+    {
+        if (server) server->connect();
+    }
+
+    void disconnect()
+    {
+        if (!server) return;
+        for (const auto peer : server->getPeerDevices())
+            server->disconnect(peer);
+    }
+
+    bool write(const char* uuid, const uint8_t* data, const size_t len)
+    {
+        auto* characteristic = find(uuid);
+        if (!characteristic || server->getConnectedCount() == 0) return false;
+        characteristic->setValue(data, len);
+        auto info = connInfo(server->getPeerDevices().front());
+        if (auto* callbacks = characteristic->getCallbacks())
+            callbacks->onWrite(characteristic, info);
+        return true;
+    }
+
+    std::string read(const char* uuid)
+    {
+        auto* characteristic = find(uuid);
+        if (!characteristic || server->getConnectedCount() == 0) return {};
+        auto info = connInfo(server->getPeerDevices().front());
+        if (auto* callbacks = characteristic->getCallbacks())
+            callbacks->onRead(characteristic, info);
+        const auto value = characteristic->getValue();
+        return {value.c_str(), value.size()};
+    }
+
+    uint32_t getNotifications()
+    {
+        return notifications;
+    }
+}
+
+void NimBLECharacteristic::setValue(const uint8_t* data, const size_t len)
+{
+    Host::Heap::LibraryScope library;
+    value.assign(data, data + len);
+}
+
+bool NimBLECharacteristic::notify()
+{
+    if (!server || server->getConnectedCount() == 0 || !(properties & NOTIFY)) return false;
+    notifications++;
+    return true;
+}
+
+uint16_t NimBLEServer::connect()
+{
+    const uint16_t handle = nextConnHandle++;
+    peers.push_back(handle);
+    advertising.stop();
+    auto info = connInfo(handle);
+    if (callbacks) callbacks->onConnect(this, info);
+    return handle;
+}
+
+bool NimBLEServer::disconnect(const uint16_t connHandle, const uint8_t reason)
+{
+    const auto it = std::ranges::find(peers, connHandle);
+    if (it == peers.end()) return false;
+    peers.erase(it);
+    auto info = connInfo(connHandle);
+    if (callbacks) callbacks->onDisconnect(this, info, reason);
+    return true;
+}
+
+bool NimBLEDevice::init(const std::string& deviceName)
+{
+    initialized = true;
+    return true;
+}
+
+bool NimBLEDevice::deinit(const bool clearAll)
+{
+    if (clearAll) server.reset();
+    initialized = false;
+    return true;
+}
+
+NimBLEServer* NimBLEDevice::createServer()
+{
+    if (!server) server = std::make_unique<NimBLEServer>();
+    return server.get();
+}
+
+NimBLEServer* NimBLEDevice::getServer()
+{
+    return server.get();
+}
+
+bool NimBLEDevice::isInitialized()
+{
+    return initialized;
+}
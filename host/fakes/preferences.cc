@@ -0,0 +1,215 @@
+#include "host.hh"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Preferences.h>
+#include <nvs_flash.h>
+
+namespace
+{
+    using Namespace = std::map<std::string, std::vector<uint8_t>>;
+
+    std::map<std::string, Namespace> store;
+    Host::Nvs::Stats stats;
+}
+
+namespace Host::Nvs
+{
+    Stats getStats()
+    {
+        return stats;
+    }
+
+    void resetCounters()
+    {
+        stats = {};
+    }
+
+    void erase()
+    {
+        store.clear();
+    }
+}
+
+esp_err_t nvs_flash_init()
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase()
+{
+    Host::Nvs::erase();
+    return ESP_OK;
+}
+
+Preferences::~Preferences()
+{
+    end();
+}
+
+bool Preferences::begin(const char* name, const bool readOnly, const char* partitionLabel)
+{
+    if (started || !name || strlen(name) >= sizeof(this->name)) return false;
+    if (readOnly && !store.contains(name)) return false;
+    strncpy(this->name, name, sizeof(this->name));
+    this->readOnly = readOnly;
+    if (!readOnly) store.try_emplace(name);
+    started = true;
+    return true;
+}
+
+void Preferences::end()
+{
+    started = false;
+}
+
+bool Preferences::clear()
+{
+    if (!started || readOnly) return false;
+    store[name].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key)
+{
+    if (!started || readOnly) return false;
+    stats.removes++;
+    return store[name].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key)
+{
+    return started && store[name].contains(key);
+}
+
+bool Preferences::put(const char* key, const void* value, const size_t len)
+{
+    if (!started || readOnly || !key) return false;
+    const auto* bytes = static_cast<const uint8_t*>(value);
+    auto& stored = store[name][key];
+    if (stored.size() == len && std::equal(stored.begin(), stored.end(), bytes))
+    {
+        stats.redundantWrites++;
+        return true;
+    }
+    stored.assign(bytes, bytes + len);
+    Host::Clock::advanceUs(Host::Cost::NVS_WRITE_US);
+    stats.writes++;
+    return true;
+}
+
+bool Preferences::get(const char* key, void* value, const size_t len) const
+{
+    if (!started || !key) return false;
+    stats.reads++;
+    const auto& entries = store[name];
+    const auto it = entries.find(key);
+    if (it == entries.end() || it->second.size() != len) return false;
+    memcpy(value, it->second.data(), len);
+    return true;
+}
+
+size_t Preferences::putBool(const char* key, const bool value)
+{
+    return putUChar(key, value ? 1 : 0);
+}
+
+size_t Preferences::putUChar(const char* key, const uint8_t value)
+{
+    return put(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putUInt(const char* key, const uint32_t value)
+{
+    return put(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putULong(const char* key, const uint32_t value)
+{
+    return putUInt(key, value);
+}
+
+size_t Preferences::putFloat(const char* key, const float value)
+{
+    return put(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putString(const char* key, const char* value)
+{
+    // NVS stores strings with their terminator.
+    const size_t len = strlen(value) + 1;
+    return put(key, value, len) ? len - 1 : 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value)
+{
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, const size_t len)
+{
+    return put(key, value, len) ? len : 0;
+}
+
+bool Preferences::getBool(const char* key, const bool defaultValue)
+{
+    return getUChar(key, defaultValue ? 1 : 0) != 0;
+}
+
+uint8_t Preferences::getUChar(const char* key, const uint8_t defaultValue)
+{
+    uint8_t value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, const uint32_t defaultValue)
+{
+    uint32_t value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getULong(const char* key, const uint32_t defaultValue)
+{
+    return getUInt(key, defaultValue);
+}
+
+float Preferences::getFloat(const char* key, const float defaultValue)
+{
+    float value;
+    return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::getString(const char* key, char* value, const size_t maxLen)
+{
+    const size_t len = getBytesLength(key);
+    if (len == 0 || len > maxLen) return 0;
+    return getBytes(key, value, maxLen) ? len - 1 : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue)
+{
+    const size_t len = getBytesLength(key);
+    if (len == 0) return defaultValue;
+    std::string value(len, '\0');
+    getBytes(key, value.data(), len);
+    value.resize(len - 1);
+    return String(value);
+}
+
+size_t Preferences::getBytesLength(const char* key)
+{
+    if (!started || !key) return 0;
+    const auto& entries = store[name];
+    const auto it = entries.find(key);
+    return it != entries.end() ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, const size_t maxLen)
+{
+    const size_t len = getBytesLength(key);
+    if (len == 0 || len > maxLen) return 0;
+    return get(key, buffer, len) ? len : 0;
+}
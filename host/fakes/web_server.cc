@@ -0,0 +1,540 @@
+#include "host.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <ESPAsyncWebServer.h>
+
+namespace
+{
+    // One TCP segment: the window async_tcp asks a response to fill at a time.
+    constexpr size_t SEGMENT_SIZE = 1436;
+
+    AsyncWebServer* activeServer = nullptr;
+    Host::Web::SocketStats socketStats;
+
+    bool equalsIgnoreCase(const String& a, const char* b)
+    {
+        return strcasecmp(a.c_str(), b) == 0;
+    }
+
+    AsyncWebSocket* findSocket()
+    {
+        if (!activeServer) return nullptr;
+        for (auto* handler : activeServer->getHandlers())
+            if (auto* socket = dynamic_cast<AsyncWebSocket*>(handler)) return socket;
+        return nullptr;
+    }
+
+    void runMiddlewares(AsyncWebServerRequest* request, const std::vector<AsyncMiddleware*>& middlewares,
+                        const size_t index, const std::function<void()>& handle)
+    {
+        Host::Heap::LibraryScope library;
+        if (index == middlewares.size())
+        {
+            handle();
+            return;
+        }
+        ArMiddlewareNext next = [&] { runMiddlewares(request, middlewares, index + 1, handle); };
+        Host::Heap::FirmwareScope firmware;
+        middlewares[index]->run(request, std::move(next));
+    }
+}
+
+namespace Host::Web
+{
+    Response send(const Request& request)
+    {
+        if (!activeServer) return {};
+
+        Host::Heap::LibraryScope library;
+        const auto method = request.method == Method::Post ? HTTP_POST : HTTP_GET;
+        auto* webRequest = new AsyncWebServerRequest(method, request.url.c_str(), request.authenticated,
+                                                     request.body.size());
+        for (const auto& [name, value] : request.params)
+            webRequest->addParam(name.c_str(), value.c_str());
+        if (!request.body.empty())
+            webRequest->addHeader("Content-Length", std::to_string(request.body.size()).c_str());
+        for (const auto& [name, value] : request.headers)
+            webRequest->addHeader(name.c_str(), value.c_str());
+
+        AsyncWebHandler* handler = nullptr;
+        for (auto* candidate : activeServer->getHandlers())
+        {
+            Host::Heap::FirmwareScope firmware;
+            if (candidate->filter(webRequest) && candidate->canHandle(webRequest))
+            {
+                handler = candidate;
+                break;
+            }
+        }
+
+        // Server middlewares run first, also for requests answered by the not-found handler.
+        runMiddlewares(webRequest, activeServer->getMiddlewares(), 0, [&]
+        {
+            if (!handler)
+            {
+                if (const auto& notFound = activeServer->getNotFoundHandler())
+                {
+                    Host::Heap::FirmwareScope firmware;
+                    notFound(webRequest);
+                }
+                else webRequest->send(404, "text/plain", "Not found");
+                return;
+            }
+            runMiddlewares(webRequest, handler->getMiddlewares(), 0, [&]
+            {
+                std::string body = request.body;
+                Host::Heap::FirmwareScope firmware;
+                if (!body.empty())
+                    handler->handleBody(webRequest, reinterpret_cast<uint8_t*>(body.data()), body.size(), 0,
+                                        body.size());
+                handler->handleRequest(webRequest);
+            });
+        });
+
+        Response response;
+        if (auto* webResponse = webRequest->_getResponse())
+        {
+            response.code = webResponse->code();
+            response.contentType = webResponse->contentType().c_str();
+            response.body = webResponse->_render(SEGMENT_SIZE);
+        }
+        delete webRequest;
+        return response;
+    }
+
+    ClientId connectSocket()
+    {
+        auto* socket = findSocket();
+        return socket ? socket->_connect()->id() : 0;
+    }
+
+    void sendSocket(const ClientId client, const uint8_t* data, const size_t len)
+    {
+        if (auto* socket = findSocket())
+        {
+            if (auto* target = socket->_find(client))
+                socket->_receive(target, data, len);
+        }
+    }
+
+    void closeSocket(const ClientId client)
+    {
+        if (auto* socket = findSocket())
+        {
+            if (auto* target = socket->_find(client))
+                socket->_disconnect(target);
+        }
+    }
+
+    void deliverSocket(const ClientId client)
+    {
+        if (auto* socket = findSocket())
+        {
+            if (auto* target = socket->_find(client))
+                socketStats.delivered += target->_deliver();
+        }
+    }
+
+    void deliverSockets()
+    {
+        if (auto* socket = findSocket())
+            socket->_deliver();
+    }
+
+    SocketStats getSocketStats()
+    {
+        return socketStats;
+    }
+}
+
+void AsyncWebServerResponse::setContentType(const char* type)
+{
+    Host::Heap::LibraryScope library;
+    _contentType = type;
+}
+
+bool AsyncWebServerResponse::addHeader(const char* name, const char* value, const bool replaceExisting)
+{
+    Host::Heap::LibraryScope library;
+    for (auto& [headerName, headerValue] : _headers)
+    {
+        if (!equalsIgnoreCase(headerName, name)) continue;
+        if (!replaceExisting) return false;
+        headerValue = value;
+        return true;
+    }
+    _headers.emplace_back(name, value);
+    return true;
+}
+
+const String* AsyncWebServerResponse::getHeader(const char* name) const
+{
+    for (const auto& [headerName, headerValue] : _headers)
+        if (equalsIgnoreCase(headerName, name)) return &headerValue;
+    return nullptr;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(const int code, const char* contentType, const char* content)
+    : content(content ? content : "")
+{
+    _code = code;
+    _contentType = contentType;
+    _contentLength = this->content.size();
+}
+
+std::string AsyncAbstractResponse::_render(const size_t windowSize)
+{
+    Host::Heap::LibraryScope library;
+    std::string body;
+    std::string window(windowSize, '\0');
+    while (_sentLength < _contentLength)
+    {
+        const size_t wanted = std::min(windowSize, _contentLength - _sentLength);
+        size_t filled;
+        {
+            Host::Heap::FirmwareScope firmware;
+            filled = _fillBuffer(reinterpret_cast<uint8_t*>(window.data()), wanted);
+        }
+        if (filled == 0) break;
+        Host::Clock::advanceUs(Host::Cost::HTTP_SEGMENT_US);
+        body.append(window.data(), filled);
+        _sentLength += filled;
+    }
+    return body;
+}
+
+AsyncResponseStream::AsyncResponseStream(const char* contentType, const size_t bufferSize)
+{
+    Host::Heap::LibraryScope library;
+    _code = 200;
+    _contentType = contentType;
+    content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::_fillBuffer(uint8_t* buffer, const size_t maxLen)
+{
+    const size_t count = std::min(maxLen, content.size() - _sentLength);
+    memcpy(buffer, content.data() + _sentLength, count);
+    return count;
+}
+
+size_t AsyncResponseStream::write(const uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t AsyncResponseStream::write(const uint8_t* data, const size_t len)
+{
+    Host::Heap::LibraryScope library;
+    content.append(reinterpret_cast<const char*>(data), len);
+    _contentLength = content.size();
+    return len;
+}
+
+bool AsyncAuthenticationMiddleware::allowed(AsyncWebServerRequest* request) const
+{
+    return authType == AUTH_NONE || request->_isAuthenticated();
+}
+
+void AsyncAuthenticationMiddleware::run(AsyncWebServerRequest* request, ArMiddlewareNext next)
+{
+    Host::Heap::LibraryScope library;
+    if (allowed(request))
+        next();
+    else
+        request->requestAuthentication(authType, realm.c_str(), authFailMessage.c_str());
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(const WebRequestMethodComposite method, const char* url,
+                                             const bool authenticated, const size_t contentLength)
+    : _method(method), _url(url), _contentLength(contentLength), _authenticated(authenticated)
+{
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest()
+{
+    for (const auto& handler : _disconnectHandlers)
+        handler();
+    delete _response;
+    // The library releases _tempObject with free(), so handlers must allocate it with malloc().
+    free(_tempObject);
+}
+
+const char* AsyncWebServerRequest::methodToString() const
+{
+    switch (_method)
+    {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "UNKNOWN";
+    }
+}
+
+bool AsyncWebServerRequest::hasParam(const char* name, const bool post, const bool file) const
+{
+    return getParam(name, post, file) != nullptr;
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(const char* name, const bool post, const bool file) const
+{
+    if (post || file) return nullptr;
+    for (const auto& param : _params)
+        if (param.name() == name) return &param;
+    return nullptr;
+}
+
+bool AsyncWebServerRequest::hasHeader(const char* name) const
+{
+    for (const auto& [headerName, headerValue] : _headers)
+        if (equalsIgnoreCase(headerName, name)) return true;
+    return false;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const
+{
+    static const String EMPTY;
+    for (const auto& [headerName, headerValue] : _headers)
+        if (equalsIgnoreCase(headerName, name)) return headerValue;
+    return EMPTY;
+}
+
+void AsyncWebServerRequest::setAttribute(const char* name, const bool value)
+{
+    Host::Heap::LibraryScope library;
+    for (auto& [attributeName, attributeValue] : _attributes)
+    {
+        if (attributeName == name)
+        {
+            attributeValue = value;
+            return;
+        }
+    }
+    _attributes.emplace_back(name, value);
+}
+
+bool AsyncWebServerRequest::hasAttribute(const char* name) const
+{
+    return std::ranges::any_of(_attributes, [name](const auto& attribute) { return attribute.first == name; });
+}
+
+bool AsyncWebServerRequest::getAttribute(const char* name, const bool defaultValue) const
+{
+    for (const auto& [attributeName, attributeValue] : _attributes)
+        if (attributeName == name) return attributeValue;
+    return defaultValue;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response)
+{
+    Host::Heap::LibraryScope library;
+    // Like the library, the first response wins and later ones are dropped.
+    if (_response)
+    {
+        delete response;
+        return;
+    }
+    _response = response;
+}
+
+void AsyncWebServerRequest::send(const int code, const char* contentType, const char* content)
+{
+    Host::Heap::LibraryScope library;
+    send(new AsyncBasicResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(const int code, const char* contentType, const __FlashStringHelper* content)
+{
+    send(code, contentType, reinterpret_cast<const char*>(content));
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const int code, const char* contentType,
+                                                             const char* content)
+{
+    Host::Heap::LibraryScope library;
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const char* contentType, const size_t bufferSize)
+{
+    Host::Heap::LibraryScope library;
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+void AsyncWebServerRequest::redirect(const char* url, const int code)
+{
+    Host::Heap::LibraryScope library;
+    auto* response = new AsyncBasicResponse(code, "", "");
+    response->addHeader("Location", url);
+    send(response);
+}
+
+void AsyncWebServerRequest::requestAuthentication(const AsyncAuthType method, const char* realm,
+                                                  const char* authFailMsg)
+{
+    Host::Heap::LibraryScope library;
+    auto* response = new AsyncBasicResponse(401, "text/html", authFailMsg ? authFailMsg : "");
+    const std::string challenge = std::string("Basic realm=\"") + (realm && *realm ? realm : "Login Required") +
+        "\"";
+    response->addHeader("WWW-Authenticate", challenge.c_str());
+    send(response);
+}
+
+AsyncWebServer::AsyncWebServer(uint16_t port)
+{
+}
+
+AsyncWebServer::~AsyncWebServer()
+{
+    end();
+}
+
+void AsyncWebServer::begin()
+{
+    activeServer = this;
+}
+
+void AsyncWebServer::end()
+{
+    if (activeServer == this) activeServer = nullptr;
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler)
+{
+    handlers.push_back(handler);
+    return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler* handler)
+{
+    const auto it = std::ranges::find(handlers, handler);
+    if (it == handlers.end()) return false;
+    handlers.erase(it);
+    return true;
+}
+
+AsyncStaticWebHandler& AsyncWebServer::serveStatic(const char* uri, fs::FS& fs, const char* path,
+                                                   const char* cacheControl)
+{
+    auto& handler = staticHandlers.emplace_back();
+    handlers.push_back(&handler);
+    return handler;
+}
+
+bool AsyncWebSocketClient::binary(const uint8_t* data, const size_t len)
+{
+    if (!connected || queueIsFull())
+    {
+        socketStats.discarded++;
+        return false;
+    }
+    Host::Clock::advanceUs(Host::Cost::WEBSOCKET_FRAME_US);
+    queue[(head + queued) % queue.size()] = len;
+    queued++;
+    socketStats.messages++;
+    socketStats.bytes += len;
+    socketStats.peakQueued = std::max(socketStats.peakQueued, queued);
+    return true;
+}
+
+size_t AsyncWebSocketClient::_deliver()
+{
+    const auto count = queued;
+    head = (head + queued) % queue.size();
+    queued = 0;
+    return count;
+}
+
+bool AsyncWebSocketClient::text(const char* message)
+{
+    return binary(reinterpret_cast<const uint8_t*>(message), strlen(message));
+}
+
+void AsyncWebSocket::cleanupClients(const uint16_t maxClients)
+{
+    Host::Heap::LibraryScope library;
+    clients.remove_if([](const AsyncWebSocketClient& client) { return !client.isConnected(); });
+    while (clients.size() > maxClients)
+    {
+        _disconnect(&clients.front());
+        clients.pop_front();
+    }
+}
+
+size_t AsyncWebSocket::count() const
+{
+    return std::ranges::count_if(clients, [](const AsyncWebSocketClient& client) { return client.isConnected(); });
+}
+
+AsyncWebSocket::SendStatus AsyncWebSocket::binaryAll(const uint8_t* data, const size_t len)
+{
+    size_t sent = 0;
+    size_t targets = 0;
+    for (auto& client : clients)
+    {
+        if (!client.isConnected()) continue;
+        targets++;
+        if (client.binary(data, len)) sent++;
+    }
+    if (sent == 0) return DISCARDED;
+    return sent == targets ? ENQUEUED : PARTIALLY_ENQUEUED;
+}
+
+AsyncWebSocket::SendStatus AsyncWebSocket::textAll(const char* message)
+{
+    return binaryAll(reinterpret_cast<const uint8_t*>(message), strlen(message));
+}
+
+AsyncWebSocketClient* AsyncWebSocket::_connect()
+{
+    Host::Heap::LibraryScope library;
+    auto* client = &clients.emplace_back(nextId++);
+    Host::Heap::FirmwareScope firmware;
+    if (eventHandler) eventHandler(this, client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+    return client;
+}
+
+AsyncWebSocketClient* AsyncWebSocket::_find(const uint32_t id)
+{
+    for (auto& client : clients)
+        if (client.id() == id && client.isConnected()) return &client;
+    return nullptr;
+}
+
+void AsyncWebSocket::_receive(AsyncWebSocketClient* client, const uint8_t* data, const size_t len)
+{
+    AwsFrameInfo info = {};
+    info.message_opcode = WS_BINARY;
+    info.opcode = WS_BINARY;
+    info.final = 1;
+    info.index = 0;
+    info.len = len;
+    // The library hands the handler a mutable copy of the frame.
+    std::string frame;
+    {
+        Host::Heap::LibraryScope library;
+        frame.assign(reinterpret_cast<const char*>(data), len);
+    }
+    if (eventHandler)
+        eventHandler(this, client, WS_EVT_DATA, &info, reinterpret_cast<uint8_t*>(frame.data()), len);
+}
+
+void AsyncWebSocket::_disconnect(AsyncWebSocketClient* client)
+{
+    if (!client->isConnected()) return;
+    client->close();
+    if (eventHandler) eventHandler(this, client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+}
+
+void AsyncWebSocket::_deliver()
+{
+    for (auto& client : clients)
+        socketStats.delivered += client._deliver();
+}
@@ -0,0 +1,117 @@
+#include "host.hh"
+
+#include <deque>
+
+#include <esp_log.h>
+#include <worker_pool.hh>
+
+// Host replacement for main/src/worker_pool.cc: the same limits and the same
+// failure modes, but jobs only run when the simulation calls
+// Host::Workers::runDue(), so their effects land at a known virtual time.
+namespace Async
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "WorkerPool";
+
+        constexpr size_t QUEUE_LENGTH = 16;
+        constexpr uint32_t WHEEL_TICK_MS = 10;
+        constexpr uint8_t MAX_DELAYED_JOBS = 16;
+
+        struct DelayedJob
+        {
+            Job job;
+            uint64_t dueUs;
+        };
+
+        bool started = false;
+        std::deque<Job> ready;
+        std::deque<DelayedJob> delayed;
+
+        uint32_t submitted = 0;
+        uint32_t completed = 0;
+        uint32_t rejected = 0;
+
+        bool enqueue(const Job& job)
+        {
+            if (ready.size() >= QUEUE_LENGTH)
+            {
+                ++rejected;
+                ESP_LOGE(LOG_TAG, "Job queue full, dropping job");
+                return false;
+            }
+            ready.push_back(job);
+            ++submitted;
+            return true;
+        }
+    }
+
+    bool begin()
+    {
+        started = true;
+        return true;
+    }
+
+    bool post(const Job& job, const uint32_t delayMs)
+    {
+        if (!started)
+        {
+            ESP_LOGE(LOG_TAG, "Worker pool not started");
+            return false;
+        }
+        if (delayMs == 0) return enqueue(job);
+
+        if (delayed.size() >= MAX_DELAYED_JOBS)
+        {
+            ++rejected;
+            ESP_LOGE(LOG_TAG, "Timer wheel full, dropping delayed job");
+            return false;
+        }
+        // The device rounds delays up to whole wheel ticks.
+        const uint32_t ticks = std::max<uint32_t>(1, (delayMs + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS);
+        delayed.push_back({job, Host::Clock::nowUs() + static_cast<uint64_t>(ticks) * WHEEL_TICK_MS * 1000});
+        return true;
+    }
+
+    Stats getStats()
+    {
+        return {submitted, completed, rejected, static_cast<uint8_t>(delayed.size())};
+    }
+}
+
+namespace Host::Workers
+{
+    uint32_t runDue()
+    {
+        const auto now = Clock::nowUs();
+        for (auto it = Async::delayed.begin(); it != Async::delayed.end();)
+        {
+            if (it->dueUs > now)
+            {
+                ++it;
+                continue;
+            }
+            // Like the wheel, a full queue leaves the job for the next call instead of dropping it.
+            if (Async::ready.size() >= Async::QUEUE_LENGTH) break;
+            Async::ready.push_back(it->job);
+            ++Async::submitted;
+            it = Async::delayed.erase(it);
+        }
+
+        uint32_t ran = 0;
+        while (!Async::ready.empty())
+        {
+            const auto job = Async::ready.front();
+            Async::ready.pop_front();
+            if (job) job();
+            ++Async::completed;
+            ++ran;
+        }
+        return ran;
+    }
+
+    size_t getPending()
+    {
+        return Async::ready.size() + Async::delayed.size();
+    }
+}
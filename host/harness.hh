@@ -0,0 +1,148 @@
+#pragma once
+
+// Pieces shared by the host tools that boot the controller firmware:
+// provisioning, boot, Hue discovery and harness-side bookkeeping.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "host.hh"
+#include "wifi_manager.hh"
+#include "alexa_integration.hh"
+#include "esp_now_handler_controller.hh"
+#include "esp_now_handler.hh"
+
+void setup();
+void loop();
+
+namespace Harness
+{
+    constexpr std::array<uint8_t, 6> REMOTE_MAC = {0x24, 0x6F, 0x28, 0x11, 0x22, 0x33};
+    constexpr auto HUE_USER = "2WLEDHardQrI3WHYTHoMcXHgEspsM8ZZRpSKtBQr";
+
+    // Harness bookkeeping bypasses the tracked heap so it doesn't show up in the firmware's heap figures.
+    template <typename T>
+    struct UntrackedAllocator
+    {
+        using value_type = T;
+
+        UntrackedAllocator() = default;
+
+        template <typename U>
+        explicit UntrackedAllocator(const UntrackedAllocator<U>&)
+        {
+        }
+
+        T* allocate(const size_t count)
+        {
+            if (auto* ptr = static_cast<T*>(Host::Heap::allocateUntracked(count * sizeof(T)))) return ptr;
+            throw std::bad_alloc();
+        }
+
+        void deallocate(T* ptr, size_t) { Host::Heap::releaseUntracked(ptr); }
+
+        bool operator==(const UntrackedAllocator&) const = default;
+    };
+
+    template <typename T>
+    using Vector = std::vector<T, UntrackedAllocator<T>>;
+
+    struct Distribution
+    {
+        Vector<uint64_t> samples;
+
+        void add(const uint64_t sample) { samples.push_back(sample); }
+
+        [[nodiscard]] uint64_t percentile(const double p)
+        {
+            if (samples.empty()) return 0;
+            std::ranges::sort(samples);
+            const auto index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+            return samples[index];
+        }
+
+        [[nodiscard]] uint64_t max() const
+        {
+            return samples.empty() ? 0 : *std::ranges::max_element(samples);
+        }
+
+        [[nodiscard]] double mean() const
+        {
+            if (samples.empty()) return 0;
+            uint64_t total = 0;
+            for (const auto sample : samples) total += sample;
+            return static_cast<double>(total) / static_cast<double>(samples.size());
+        }
+    };
+
+    inline uint64_t nanosSince(const std::chrono::steady_clock::time_point start)
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    // A freshly flashed device has no configuration, so the tools provision it
+    // the way the app would: Wi-Fi credentials, Alexa in RGBW mode and one paired remote.
+    inline void provision()
+    {
+        Preferences prefs;
+        WiFiConnectionDetails details;
+        details.encryptionType = WiFiEncryptionType::WPA2_PSK;
+        strncpy(details.ssid.data(), "simulation", details.ssid.size() - 1);
+        strncpy(details.credentials.simple.password.data(), "password", WIFI_MAX_PASSWORD_LENGTH);
+        prefs.begin("wifi-config", false);
+        prefs.putUChar("encryptionType", static_cast<uint8_t>(details.encryptionType));
+        prefs.putBytes("ssid", details.ssid.data(), details.ssid.size());
+        prefs.putBytes("password", details.credentials.simple.password.data(),
+                       details.credentials.simple.password.size());
+        prefs.end();
+
+        prefs.begin("alexa-config", false);
+        prefs.putUChar("mode", static_cast<uint8_t>(AlexaIntegration::Settings::Mode::RGBW_DEVICE));
+        prefs.putString("r", "Strip");
+        prefs.end();
+
+        EspNow::DeviceData remotes;
+        remotes.deviceCount = 1;
+        strncpy(remotes.devices[0].name.data(), "remote", EspNow::Device::NAME_MAX_LENGTH);
+        remotes.devices[0].address = REMOTE_MAC;
+        prefs.begin("esp-now", false);
+        prefs.putUInt("devCount", remotes.deviceCount);
+        prefs.putBytes("devData", remotes.devices.data(), remotes.deviceCount * sizeof(EspNow::Device));
+        prefs.end();
+    }
+
+    // Provisions, boots like initArduino() and connects, then lets boot-time work (restores, the
+    // first telemetry and heap samples) settle for a virtual second.
+    inline void boot()
+    {
+        provision();
+        initVariant();
+        setup();
+        Host::Network::connect();
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            loop();
+            Host::Workers::runDue();
+            Host::Clock::advanceMs(1);
+        }
+    }
+
+    // Like the Alexa app, learn the light id from the first key of the light list.
+    inline std::string discoverHueLight()
+    {
+        const auto lights = Host::Web::send({
+            Host::Web::Method::Get, std::string("/api/") + HUE_USER + "/lights"
+        });
+        const auto start = lights.body.find('"');
+        if (start == std::string::npos) return {};
+        return lights.body.substr(start + 1, lights.body.find('"', start + 1) - start - 1);
+    }
+}
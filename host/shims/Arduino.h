@@ -0,0 +1,127 @@
+#pragma once
+
+// Host stand-in for the arduino-esp32 core: time comes from Host::Clock,
+// GPIO and LEDC are backed by the in-memory fakes in host/fakes.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include <math.h>
+
+#include "WString.h"
+#include "IPAddress.h"
+#include "Print.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp32-hal-cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#define ARDUHAL_LOG_LEVEL_NONE 0
+#define ARDUHAL_LOG_LEVEL_ERROR 1
+#define ARDUHAL_LOG_LEVEL_WARN 2
+#define ARDUHAL_LOG_LEVEL_INFO 3
+#define ARDUHAL_LOG_LEVEL_DEBUG 4
+#define ARDUHAL_LOG_LEVEL_VERBOSE 5
+#define ARDUHAL_LOG_LEVEL ARDUHAL_LOG_LEVEL_INFO
+
+#ifndef __unused
+#define __unused __attribute__((unused))
+#endif
+
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+typedef enum
+{
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_1,
+    GPIO_NUM_2,
+    GPIO_NUM_3,
+    GPIO_NUM_4,
+    GPIO_NUM_5,
+    GPIO_NUM_6,
+    GPIO_NUM_7,
+    GPIO_NUM_8,
+    GPIO_NUM_9,
+    GPIO_NUM_10,
+    GPIO_NUM_11,
+    GPIO_NUM_12,
+    GPIO_NUM_13,
+    GPIO_NUM_14,
+    GPIO_NUM_15,
+    GPIO_NUM_16,
+    GPIO_NUM_17,
+    GPIO_NUM_18,
+    GPIO_NUM_19,
+    GPIO_NUM_20,
+    GPIO_NUM_21,
+    GPIO_NUM_22,
+    GPIO_NUM_23,
+    GPIO_NUM_25 = 25,
+    GPIO_NUM_26,
+    GPIO_NUM_27,
+    GPIO_NUM_32 = 32,
+    GPIO_NUM_33,
+    GPIO_NUM_34,
+    GPIO_NUM_35,
+    GPIO_NUM_36,
+    GPIO_NUM_37,
+    GPIO_NUM_38,
+    GPIO_NUM_39,
+    GPIO_NUM_MAX,
+} gpio_num_t;
+
+unsigned long millis();
+unsigned long micros();
+// Advances the virtual clock: the caller is the only thing running.
+// Weak hook the core runs before setup(); the host tools call it themselves.
+extern "C" void initVariant();
+
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+
+bool ledcAttach(uint8_t pin, uint32_t frequency, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+
+// Deterministic across runs: the sequence only depends on randomSeed().
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() { return esp_get_free_heap_size(); }
+    uint32_t getMinFreeHeap() { return esp_get_minimum_free_heap_size(); }
+    void restart() { esp_restart(); }
+};
+
+inline EspClass ESP;
@@ -0,0 +1,7 @@
+#pragma once
+
+// The firmware renders JSON through Json::PooledResponse; only the includes are needed.
+
+#include <ArduinoJson.h>
+
+#include "ESPAsyncWebServer.h"
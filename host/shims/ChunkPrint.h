@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Print.h"
+
+// Writes the window [from, from + len) of whatever is printed into `destination`.
+class ChunkPrint : public Print
+{
+    uint8_t* destination;
+    size_t toSkip;
+    size_t toWrite;
+    size_t position = 0;
+
+public:
+    ChunkPrint(uint8_t* destination, const size_t from, const size_t len)
+        : destination(destination), toSkip(from), toWrite(len)
+    {
+    }
+
+    size_t write(const uint8_t c) override
+    {
+        if (toSkip > 0)
+        {
+            toSkip--;
+            return 1;
+        }
+        if (toWrite > 0)
+        {
+            toWrite--;
+            destination[position++] = c;
+            return 1;
+        }
+        return 0;
+    }
+
+    size_t write(const uint8_t* buffer, const size_t size) override
+    {
+        return Print::write(buffer, size);
+    }
+};
@@ -0,0 +1,428 @@
+#pragma once
+
+// Host ESPAsyncWebServer: handlers, middleware and responses keep the
+// library's interfaces, but requests come from Host::Web::send() instead of
+// async_tcp and responses are rendered into memory through the same
+// _fillBuffer() calls the TCP stack would make.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+
+typedef enum
+{
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+using WebRequestMethodComposite = uint8_t;
+
+typedef enum
+{
+    AUTH_NONE = 0,
+    AUTH_BASIC = 1,
+    AUTH_DIGEST = 2,
+    AUTH_BEARER = 3,
+    AUTH_OTHER = 4,
+    AUTH_DENIED = 255,
+} AsyncAuthType;
+
+class AsyncWebServerRequest;
+
+using ArDisconnectHandler = std::function<void()>;
+using ArMiddlewareNext = std::function<void()>;
+using ArMiddlewareCallback = std::function<void(AsyncWebServerRequest* request, ArMiddlewareNext next)>;
+using ArRequestFilterFunction = std::function<bool(AsyncWebServerRequest* request)>;
+using ArRequestHandlerFunction = std::function<void(AsyncWebServerRequest* request)>;
+
+class AsyncWebParameter
+{
+    String _name;
+    String _value;
+
+public:
+    AsyncWebParameter(const String& name, const String& value) : _name(name), _value(value)
+    {
+    }
+
+    [[nodiscard]] const String& name() const { return _name; }
+    [[nodiscard]] const String& value() const { return _value; }
+};
+
+class AsyncWebServerResponse
+{
+public:
+    int _code = 0;
+    String _contentType;
+    size_t _contentLength = 0;
+    size_t _sentLength = 0;
+    std::vector<std::pair<String, String>> _headers;
+
+    virtual ~AsyncWebServerResponse() = default;
+
+    void setContentType(const char* type);
+    bool addHeader(const char* name, const char* value, bool replaceExisting = true);
+    [[nodiscard]] const String* getHeader(const char* name) const;
+
+    [[nodiscard]] int code() const { return _code; }
+    [[nodiscard]] const String& contentType() const { return _contentType; }
+
+    [[nodiscard]] virtual bool _sourceValid() const { return false; }
+    // Renders the whole body the way the TCP stack pulls it, one window at a time.
+    [[nodiscard]] virtual std::string _render(size_t windowSize) = 0;
+};
+
+class AsyncBasicResponse final : public AsyncWebServerResponse
+{
+    std::string content;
+
+public:
+    AsyncBasicResponse(int code, const char* contentType, const char* content);
+
+    [[nodiscard]] bool _sourceValid() const override { return true; }
+    [[nodiscard]] std::string _render(size_t windowSize) override { return content; }
+};
+
+class AsyncAbstractResponse : public AsyncWebServerResponse
+{
+public:
+    [[nodiscard]] bool _sourceValid() const override { return false; }
+
+    virtual size_t _fillBuffer(uint8_t* buffer, size_t maxLen) { return 0; }
+
+    [[nodiscard]] std::string _render(size_t windowSize) override;
+};
+
+class AsyncResponseStream final : public AsyncAbstractResponse, public Print
+{
+    std::string content;
+
+public:
+    AsyncResponseStream(const char* contentType, size_t bufferSize);
+
+    [[nodiscard]] bool _sourceValid() const override { return true; }
+
+    size_t _fillBuffer(uint8_t* buffer, size_t maxLen) override;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+};
+
+class AsyncMiddleware
+{
+public:
+    virtual ~AsyncMiddleware() = default;
+
+    virtual void run(AsyncWebServerRequest* request, ArMiddlewareNext next)
+    {
+        next();
+    }
+};
+
+class AsyncMiddlewareFunction : public AsyncMiddleware
+{
+    ArMiddlewareCallback callback;
+
+public:
+    explicit AsyncMiddlewareFunction(ArMiddlewareCallback callback) : callback(std::move(callback))
+    {
+    }
+
+    void run(AsyncWebServerRequest* request, ArMiddlewareNext next) override
+    {
+        callback(request, std::move(next));
+    }
+};
+
+/**
+ * Credentials are not checked on the host: a request is allowed when the
+ * simulated client marked it authenticated (Host::Web::Request::authenticated).
+ */
+class AsyncAuthenticationMiddleware : public AsyncMiddleware
+{
+    String username;
+    String password;
+    String realm;
+    String authFailMessage;
+    AsyncAuthType authType = AUTH_NONE;
+
+public:
+    void setUsername(const char* value) { username = value; }
+    void setPassword(const char* value) { password = value; }
+    void setRealm(const char* value) { realm = value; }
+    void setAuthFailureMessage(const char* value) { authFailMessage = value; }
+    void setAuthType(const AsyncAuthType value) { authType = value; }
+
+    bool generateHash() { return true; }
+
+    [[nodiscard]] bool allowed(AsyncWebServerRequest* request) const;
+
+    void run(AsyncWebServerRequest* request, ArMiddlewareNext next) override;
+};
+
+class AsyncWebHandler
+{
+    std::vector<AsyncMiddleware*> middlewares;
+    ArRequestFilterFunction requestFilter;
+
+public:
+    virtual ~AsyncWebHandler() = default;
+
+    AsyncWebHandler& addMiddleware(AsyncMiddleware* middleware)
+    {
+        middlewares.push_back(middleware);
+        return *this;
+    }
+
+    AsyncWebHandler& setFilter(ArRequestFilterFunction filter)
+    {
+        requestFilter = std::move(filter);
+        return *this;
+    }
+
+    // Checked before canHandle(), like the library does.
+    bool filter(AsyncWebServerRequest* request) { return !requestFilter || requestFilter(request); }
+
+    [[nodiscard]] const std::vector<AsyncMiddleware*>& getMiddlewares() const { return middlewares; }
+
+    virtual bool canHandle(AsyncWebServerRequest* request) const { return false; }
+
+    virtual void handleRequest(AsyncWebServerRequest* request)
+    {
+    }
+
+    virtual void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                              size_t len, bool final)
+    {
+    }
+
+    virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)
+    {
+    }
+
+    [[nodiscard]] virtual bool isRequestHandlerTrivial() const { return true; }
+};
+
+// Nothing is stored on the host filesystem, so static files never match.
+class AsyncStaticWebHandler final : public AsyncWebHandler
+{
+public:
+    AsyncStaticWebHandler& setDefaultFile(const char* filename) { return *this; }
+    AsyncStaticWebHandler& setTryGzipFirst(bool value) { return *this; }
+    AsyncStaticWebHandler& setCacheControl(const char* cacheControl) { return *this; }
+};
+
+class AsyncWebServerRequest
+{
+    WebRequestMethodComposite _method;
+    String _url;
+    std::vector<AsyncWebParameter> _params;
+    std::vector<std::pair<String, String>> _headers;
+    std::vector<std::pair<String, bool>> _attributes;
+    std::vector<ArDisconnectHandler> _disconnectHandlers;
+    AsyncWebServerResponse* _response = nullptr;
+    size_t _contentLength = 0;
+    bool _authenticated;
+    bool _aborted = false;
+
+public:
+    void* _tempObject = nullptr;
+
+    AsyncWebServerRequest(WebRequestMethodComposite method, const char* url, bool authenticated,
+                          size_t contentLength = 0);
+    ~AsyncWebServerRequest();
+
+    AsyncWebServerRequest(const AsyncWebServerRequest&) = delete;
+    AsyncWebServerRequest& operator=(const AsyncWebServerRequest&) = delete;
+
+    [[nodiscard]] WebRequestMethodComposite method() const { return _method; }
+    [[nodiscard]] const String& url() const { return _url; }
+    [[nodiscard]] const char* methodToString() const;
+    [[nodiscard]] size_t contentLength() const { return _contentLength; }
+
+    void addParam(const char* name, const char* value) { _params.emplace_back(name, value); }
+    [[nodiscard]] size_t params() const { return _params.size(); }
+    [[nodiscard]] bool hasParam(const char* name, bool post = false, bool file = false) const;
+    [[nodiscard]] const AsyncWebParameter* getParam(const char* name, bool post = false, bool file = false) const;
+
+    void addHeader(const char* name, const char* value) { _headers.emplace_back(name, value); }
+    [[nodiscard]] bool hasHeader(const char* name) const;
+    [[nodiscard]] const String& header(const char* name) const;
+
+    void setAttribute(const char* name, bool value);
+    [[nodiscard]] bool hasAttribute(const char* name) const;
+    [[nodiscard]] bool getAttribute(const char* name, bool defaultValue = false) const;
+
+    void onDisconnect(ArDisconnectHandler handler) { _disconnectHandlers.push_back(std::move(handler)); }
+
+    void send(AsyncWebServerResponse* response);
+    void send(int code, const char* contentType = "", const char* content = "");
+    void send(int code, const char* contentType, const __FlashStringHelper* content);
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType = "", const char* content = "");
+    AsyncResponseStream* beginResponseStream(const char* contentType, size_t bufferSize = 1460);
+    void redirect(const char* url, int code = 302);
+    void requestAuthentication(AsyncAuthType method = AUTH_BASIC, const char* realm = nullptr,
+                               const char* authFailMsg = nullptr);
+    void abort() { _aborted = true; }
+
+    [[nodiscard]] bool _isAuthenticated() const { return _authenticated; }
+    [[nodiscard]] bool _isAborted() const { return _aborted; }
+    [[nodiscard]] AsyncWebServerResponse* _getResponse() const { return _response; }
+};
+
+class AsyncWebServer
+{
+    std::vector<AsyncWebHandler*> handlers;
+    std::list<AsyncStaticWebHandler> staticHandlers;
+    std::vector<AsyncMiddleware*> middlewares;
+    ArRequestHandlerFunction notFoundHandler;
+
+public:
+    explicit AsyncWebServer(uint16_t port);
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+    bool removeHandler(AsyncWebHandler* handler);
+    void addMiddleware(AsyncMiddleware* middleware) { middlewares.push_back(middleware); }
+    void onNotFound(ArRequestHandlerFunction handler) { notFoundHandler = std::move(handler); }
+    AsyncStaticWebHandler& serveStatic(const char* uri, fs::FS& fs, const char* path,
+                                       const char* cacheControl = nullptr);
+
+    [[nodiscard]] const std::vector<AsyncWebHandler*>& getHandlers() const { return handlers; }
+    [[nodiscard]] const std::vector<AsyncMiddleware*>& getMiddlewares() const { return middlewares; }
+    [[nodiscard]] const ArRequestHandlerFunction& getNotFoundHandler() const { return notFoundHandler; }
+};
+
+typedef enum
+{
+    WS_EVT_CONNECT,
+    WS_EVT_DISCONNECT,
+    WS_EVT_PING,
+    WS_EVT_PONG,
+    WS_EVT_ERROR,
+    WS_EVT_DATA
+} AwsEventType;
+
+typedef enum
+{
+    WS_CONTINUATION,
+    WS_TEXT,
+    WS_BINARY,
+    WS_DISCONNECT = 0x08,
+    WS_PING,
+    WS_PONG
+} AwsFrameType;
+
+typedef struct
+{
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+#define WS_MAX_QUEUED_MESSAGES 32
+#define DEFAULT_MAX_WS_CLIENTS 8
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient
+{
+    uint32_t clientId;
+    // Sizes of the frames waiting to be sent, oldest at `head`.
+    std::array<size_t, WS_MAX_QUEUED_MESSAGES> queue = {};
+    size_t head = 0;
+    size_t queued = 0;
+    bool connected = true;
+
+    friend class AsyncWebSocket;
+
+public:
+    explicit AsyncWebSocketClient(const uint32_t id) : clientId(id)
+    {
+    }
+
+    [[nodiscard]] uint32_t id() const { return clientId; }
+    [[nodiscard]] IPAddress remoteIP() const { return {192, 168, 1, static_cast<uint8_t>(100 + clientId % 100)}; }
+    [[nodiscard]] bool queueIsFull() const { return queued >= WS_MAX_QUEUED_MESSAGES; }
+    [[nodiscard]] size_t queueLen() const { return queued; }
+    [[nodiscard]] bool isConnected() const { return connected; }
+
+    bool binary(const uint8_t* data, size_t len);
+    bool text(const char* message);
+    void close(uint16_t code = 0, const char* message = nullptr) { connected = false; }
+
+    // Sends every queued frame and returns how many there were.
+    size_t _deliver();
+};
+
+/**
+ * Each client has a bounded send queue like the library's; frames stay queued
+ * until Host::Web::deliverSocket() drains it, so a slow consumer fills its
+ * queue, further frames for it are discarded (closeWhenFull off) and
+ * binaryAll() reports PARTIALLY_ENQUEUED exactly as on the device.
+ */
+class AsyncWebSocket : public AsyncWebHandler
+{
+public:
+    enum SendStatus
+    {
+        DISCARDED = 0,
+        ENQUEUED = 1,
+        PARTIALLY_ENQUEUED = 2,
+    };
+
+    using AwsEventHandler = std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*,
+                                               uint8_t*, size_t)>;
+
+private:
+    String url;
+    AwsEventHandler eventHandler;
+    std::list<AsyncWebSocketClient> clients;
+    uint32_t nextId = 1;
+
+public:
+    explicit AsyncWebSocket(const char* url) : url(url)
+    {
+    }
+
+    void onEvent(AwsEventHandler handler) { eventHandler = std::move(handler); }
+
+    bool canHandle(AsyncWebServerRequest* request) const override { return request->url() == url; }
+
+    void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+    [[nodiscard]] size_t count() const;
+    // The connected client with `id`, or nullptr.
+    AsyncWebSocketClient* client(uint32_t id) { return _find(id); }
+    SendStatus binaryAll(const uint8_t* data, size_t len);
+    SendStatus textAll(const char* message);
+
+    AsyncWebSocketClient* _connect();
+    [[nodiscard]] AsyncWebSocketClient* _find(uint32_t id);
+    void _receive(AsyncWebSocketClient* client, const uint8_t* data, size_t len);
+    void _disconnect(AsyncWebSocketClient* client);
+    void _deliver();
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+#include "WString.h"
+
+class IPAddress
+{
+    std::array<uint8_t, 4> octets = {};
+
+public:
+    IPAddress() = default;
+
+    IPAddress(const uint8_t a, const uint8_t b, const uint8_t c, const uint8_t d) : octets{a, b, c, d}
+    {
+    }
+
+    // Same byte order as lwIP: the first octet is the least significant byte.
+    explicit IPAddress(const uint32_t address)
+        : octets{
+            static_cast<uint8_t>(address), static_cast<uint8_t>(address >> 8),
+            static_cast<uint8_t>(address >> 16), static_cast<uint8_t>(address >> 24)
+        }
+    {
+    }
+
+    explicit operator uint32_t() const
+    {
+        return octets[0] | octets[1] << 8 | octets[2] << 16 | static_cast<uint32_t>(octets[3]) << 24;
+    }
+
+    uint8_t operator[](const int index) const { return octets[index]; }
+
+    bool operator==(const IPAddress& other) const { return octets == other.octets; }
+
+    [[nodiscard]] String toString() const
+    {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+        return text;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "WString.h"
+
+namespace fs
+{
+    class FS
+    {
+    };
+}
+
+// No filesystem on the host: static files are not served.
+class LittleFSFS : public fs::FS
+{
+public:
+    bool begin(bool formatOnFail = false) { return true; }
+    bool exists(const char* path) { return false; }
+    bool exists(const String& path) { return false; }
+};
+
+inline LittleFSFS LittleFS;
@@ -0,0 +1,250 @@
+#pragma once
+
+// Host NimBLE: a GATT table kept in memory. There is no radio; a simulated
+// central connects, reads and writes through Host::Ble, which invokes the
+// same callbacks the NimBLE host task would.
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+typedef enum
+{
+    READ = 0x0002,
+    READ_ENC = 0x0200,
+    READ_AUTHEN = 0x0400,
+    READ_AUTHOR = 0x0800,
+    WRITE = 0x0008,
+    WRITE_NR = 0x0004,
+    WRITE_ENC = 0x1000,
+    WRITE_AUTHEN = 0x2000,
+    WRITE_AUTHOR = 0x4000,
+    BROADCAST = 0x0001,
+    NOTIFY = 0x0010,
+    INDICATE = 0x0020
+} NIMBLE_PROPERTY;
+
+class NimBLEServer;
+class NimBLECharacteristic;
+
+class NimBLEConnInfo
+{
+public:
+    uint16_t connHandle = 0;
+
+    [[nodiscard]] uint16_t getConnHandle() const { return connHandle; }
+};
+
+// Keeps a terminator past the value, like NimBLE, so c_str() is safe.
+class NimBLEAttValue
+{
+    std::vector<uint8_t> bytes = {0};
+
+public:
+    NimBLEAttValue() = default;
+
+    NimBLEAttValue(const uint8_t* data, const size_t len) : bytes(data, data + len)
+    {
+        bytes.push_back(0);
+    }
+
+    [[nodiscard]] const uint8_t* data() const { return bytes.data(); }
+    [[nodiscard]] size_t size() const { return bytes.size() - 1; }
+    [[nodiscard]] size_t length() const { return size(); }
+    [[nodiscard]] const uint8_t* begin() const { return bytes.data(); }
+    [[nodiscard]] const uint8_t* end() const { return bytes.data() + size(); }
+    [[nodiscard]] const char* c_str() const { return reinterpret_cast<const char*>(bytes.data()); }
+
+    bool operator==(const char* text) const
+    {
+        return size() == strlen(text) && memcmp(bytes.data(), text, size()) == 0;
+    }
+};
+
+class NimBLECharacteristicCallbacks
+{
+public:
+    virtual ~NimBLECharacteristicCallbacks() = default;
+
+    virtual void onRead(NimBLECharacteristic* characteristic, NimBLEConnInfo& connInfo)
+    {
+    }
+
+    virtual void onWrite(NimBLECharacteristic* characteristic, NimBLEConnInfo& connInfo)
+    {
+    }
+};
+
+class NimBLECharacteristic
+{
+    std::string uuid;
+    uint32_t properties;
+    NimBLEServer* server;
+    std::vector<uint8_t> value;
+    std::unique_ptr<NimBLECharacteristicCallbacks> callbacks;
+
+public:
+    NimBLECharacteristic(const char* uuid, const uint32_t properties, NimBLEServer* server)
+        : uuid(uuid), properties(properties), server(server)
+    {
+    }
+
+    [[nodiscard]] const std::string& getUUID() const { return uuid; }
+    [[nodiscard]] uint32_t getProperties() const { return properties; }
+    [[nodiscard]] NimBLECharacteristicCallbacks* getCallbacks() const { return callbacks.get(); }
+
+    void setCallbacks(NimBLECharacteristicCallbacks* newCallbacks) { callbacks.reset(newCallbacks); }
+
+    void setValue(const uint8_t* data, size_t len);
+    void setValue(const char* text) { setValue(reinterpret_cast<const uint8_t*>(text), strlen(text)); }
+    void setValue(const std::string& text) { setValue(reinterpret_cast<const uint8_t*>(text.data()), text.size()); }
+
+    [[nodiscard]] NimBLEAttValue getValue() const { return {value.data(), value.size()}; }
+
+    template <typename T>
+    [[nodiscard]] T getValue() const
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T result = {};
+        if (value.size() >= sizeof(T)) memcpy(&result, value.data(), sizeof(T));
+        return result;
+    }
+
+    [[nodiscard]] size_t getLength() const { return value.size(); }
+
+    // Succeeds while a central is connected and counts in Host::Ble::getNotifications().
+    bool notify();
+};
+
+class NimBLEService
+{
+    std::string uuid;
+    NimBLEServer* server;
+    std::vector<std::unique_ptr<NimBLECharacteristic>> characteristics;
+
+public:
+    NimBLEService(const char* uuid, NimBLEServer* server) : uuid(uuid), server(server)
+    {
+    }
+
+    NimBLECharacteristic* createCharacteristic(const char* characteristicUuid, uint32_t properties = READ | WRITE,
+                                               uint16_t maxLen = 512)
+    {
+        return characteristics.emplace_back(
+            std::make_unique<NimBLECharacteristic>(characteristicUuid, properties, server)).get();
+    }
+
+    [[nodiscard]] NimBLECharacteristic* getCharacteristic(const char* characteristicUuid) const
+    {
+        for (const auto& characteristic : characteristics)
+            if (characteristic->getUUID() == characteristicUuid) return characteristic.get();
+        return nullptr;
+    }
+
+    bool start() { return true; }
+};
+
+class NimBLEServerCallbacks
+{
+public:
+    virtual ~NimBLEServerCallbacks() = default;
+
+    virtual void onConnect(NimBLEServer* server, NimBLEConnInfo& connInfo)
+    {
+    }
+
+    virtual void onDisconnect(NimBLEServer* server, NimBLEConnInfo& connInfo, int reason)
+    {
+    }
+};
+
+class NimBLEAdvertisementData
+{
+    std::string name;
+
+public:
+    bool setName(const std::string& newName, bool isComplete = true)
+    {
+        name = newName;
+        return true;
+    }
+
+    [[nodiscard]] const std::string& getName() const { return name; }
+};
+
+class NimBLEAdvertising
+{
+    bool advertising = false;
+
+public:
+    bool setScanResponseData(const NimBLEAdvertisementData& data) { return true; }
+    bool setManufacturerData(const uint8_t* data, size_t length) { return true; }
+
+    bool start(uint32_t duration = 0)
+    {
+        advertising = true;
+        return true;
+    }
+
+    bool stop()
+    {
+        advertising = false;
+        return true;
+    }
+
+    [[nodiscard]] bool isAdvertising() const { return advertising; }
+};
+
+class NimBLEServer
+{
+    std::vector<std::unique_ptr<NimBLEService>> services;
+    std::unique_ptr<NimBLEServerCallbacks> callbacks;
+    NimBLEAdvertising advertising;
+    std::vector<uint16_t> peers;
+    uint16_t nextConnHandle = 1;
+
+public:
+    NimBLEService* createService(const char* uuid)
+    {
+        return services.emplace_back(std::make_unique<NimBLEService>(uuid, this)).get();
+    }
+
+    void setCallbacks(NimBLEServerCallbacks* newCallbacks, bool deleteCallbacks = true)
+    {
+        callbacks.reset(newCallbacks);
+    }
+
+    [[nodiscard]] NimBLECharacteristic* findCharacteristic(const char* uuid) const
+    {
+        for (const auto& service : services)
+            if (auto* characteristic = service->getCharacteristic(uuid)) return characteristic;
+        return nullptr;
+    }
+
+    [[nodiscard]] std::vector<uint16_t> getPeerDevices() const { return peers; }
+    [[nodiscard]] uint8_t getConnectedCount() const { return static_cast<uint8_t>(peers.size()); }
+
+    NimBLEAdvertising* getAdvertising() { return &advertising; }
+    bool startAdvertising(uint8_t instanceId = 0, int duration = 0) { return advertising.start(); }
+    bool stopAdvertising() { return advertising.stop(); }
+
+    [[nodiscard]] NimBLEServerCallbacks* getCallbacks() const { return callbacks.get(); }
+
+    uint16_t connect();
+    bool disconnect(uint16_t connHandle, uint8_t reason = 0x13);
+};
+
+class NimBLEDevice
+{
+public:
+    static bool init(const std::string& deviceName);
+    static bool deinit(bool clearAll = false);
+    static NimBLEServer* createServer();
+    static NimBLEServer* getServer();
+    static bool isInitialized();
+};
+
+using BLEDevice = NimBLEDevice;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "WString.h"
+
+/**
+ * Preferences over the in-memory NVS store of the host fakes.
+ * Namespaces and keys behave like NVS (a read-only handle can't write,
+ * a missing namespace can't be opened read-only) and every put is counted
+ * in Host::Nvs::getStats().
+ */
+class Preferences
+{
+    // NVS namespaces are at most 15 characters.
+    char name[16] = {};
+    bool readOnly = false;
+    bool started = false;
+
+    [[nodiscard]] bool put(const char* key, const void* value, size_t len);
+    [[nodiscard]] bool get(const char* key, void* value, size_t len) const;
+
+public:
+    Preferences() = default;
+    ~Preferences();
+
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBool(const char* key, bool value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putULong(const char* key, uint32_t value);
+    size_t putFloat(const char* key, float value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    bool getBool(const char* key, bool defaultValue = false);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = NAN);
+    size_t getString(const char* key, char* value, size_t maxLen);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLen);
+};
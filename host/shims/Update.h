@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+// Accepts any image and discards it; only the byte count is kept.
+class UpdateClass
+{
+    size_t written = 0;
+    bool running = false;
+
+public:
+    bool setMD5(const char* md5) { return md5 != nullptr; }
+
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH)
+    {
+        written = 0;
+        running = true;
+        return true;
+    }
+
+    size_t write(const uint8_t* data, const size_t len)
+    {
+        if (!running) return 0;
+        written += len;
+        return len;
+    }
+
+    bool end(bool evenIfRemaining = false)
+    {
+        const bool wasRunning = running;
+        running = false;
+        return wasRunning;
+    }
+
+    void abort() { running = false; }
+
+    [[nodiscard]] const char* errorString() const { return "No Error"; }
+
+    [[nodiscard]] size_t progress() const { return written; }
+};
+
+inline UpdateClass Update;
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class __FlashStringHelper;
+
+// Arduino String backed by std::string; only the members the firmware uses.
+class String
+{
+    std::string value;
+
+public:
+    String() = default;
+    String(const char* text) : value(text ? text : "") {} // NOLINT
+    String(const std::string& text) : value(text) {} // NOLINT
+    String(const __FlashStringHelper* text) : String(reinterpret_cast<const char*>(text)) {} // NOLINT
+    explicit String(char c) : value(1, c) {}
+    explicit String(int number) : value(std::to_string(number)) {}
+    explicit String(unsigned number) : value(std::to_string(number)) {}
+    explicit String(long number) : value(std::to_string(number)) {}
+    explicit String(unsigned long number) : value(std::to_string(number)) {}
+
+    [[nodiscard]] const char* c_str() const { return value.c_str(); }
+    [[nodiscard]] unsigned length() const { return value.length(); }
+    [[nodiscard]] bool isEmpty() const { return value.empty(); }
+    [[nodiscard]] long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+    [[nodiscard]] float toFloat() const { return strtof(value.c_str(), nullptr); }
+
+    [[nodiscard]] String substring(const unsigned from) const
+    {
+        return from < value.size() ? String(value.substr(from)) : String();
+    }
+
+    [[nodiscard]] String substring(const unsigned from, const unsigned to) const
+    {
+        if (from >= value.size() || to <= from) return {};
+        return String(value.substr(from, to - from));
+    }
+
+    [[nodiscard]] int indexOf(const char* needle, const unsigned from = 0) const
+    {
+        const auto pos = value.find(needle, from);
+        return pos == std::string::npos ? -1 : static_cast<int>(pos);
+    }
+
+    [[nodiscard]] int indexOf(const char c, const unsigned from = 0) const
+    {
+        const auto pos = value.find(c, from);
+        return pos == std::string::npos ? -1 : static_cast<int>(pos);
+    }
+
+    [[nodiscard]] int indexOf(const String& needle, const unsigned from = 0) const
+    {
+        return indexOf(needle.c_str(), from);
+    }
+
+    [[nodiscard]] bool startsWith(const char* prefix) const { return value.starts_with(prefix); }
+    [[nodiscard]] bool endsWith(const char* suffix) const { return value.ends_with(suffix); }
+    [[nodiscard]] bool equals(const char* other) const { return value == other; }
+
+    void replace(const char* from, const char* to)
+    {
+        const size_t fromLength = strlen(from);
+        if (fromLength == 0) return;
+        const size_t toLength = strlen(to);
+        for (auto pos = value.find(from); pos != std::string::npos; pos = value.find(from, pos + toLength))
+            value.replace(pos, fromLength, to);
+    }
+
+    void toLowerCase()
+    {
+        for (auto& c : value) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+
+    void toUpperCase()
+    {
+        for (auto& c : value) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+
+    bool reserve(const unsigned size)
+    {
+        value.reserve(size);
+        return true;
+    }
+
+    char operator[](const unsigned index) const { return index < value.size() ? value[index] : '\0'; }
+
+    String& operator+=(const String& other)
+    {
+        value += other.value;
+        return *this;
+    }
+
+    String& operator+=(const char* other)
+    {
+        value += other;
+        return *this;
+    }
+
+    String& operator+=(const char c)
+    {
+        value += c;
+        return *this;
+    }
+
+    friend String operator+(String lhs, const String& rhs) { return lhs += rhs; }
+    friend String operator+(String lhs, const char* rhs) { return lhs += rhs; }
+
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == other; }
+    bool operator!=(const String& other) const { return value != other.value; }
+    bool operator!=(const char* other) const { return value != other; }
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "Arduino.h"
+#include "esp_err.h"
+
+typedef enum
+{
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum
+{
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+    WIFI_AUTH_WAPI_PSK,
+    WIFI_AUTH_WPA3_ENT_192,
+    WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+typedef enum
+{
+    WIFI_REASON_UNSPECIFIED = 1,
+    WIFI_REASON_AUTH_EXPIRE = 2,
+    WIFI_REASON_AUTH_FAIL = 202,
+    WIFI_REASON_NO_AP_FOUND = 201,
+    WIFI_REASON_ASSOC_FAIL = 203,
+    WIFI_REASON_HANDSHAKE_TIMEOUT = 204,
+    WIFI_REASON_CONNECTION_FAIL = 205,
+} wifi_err_reason_t;
+
+typedef enum
+{
+    ARDUINO_EVENT_NONE = 0,
+    ARDUINO_EVENT_WIFI_READY,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP6,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef struct
+{
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef union
+{
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+using WiFiEvent_t = arduino_event_id_t;
+using WiFiEventInfo_t = arduino_event_info_t;
+using WiFiEventFuncCb = std::function<void(arduino_event_id_t event, arduino_event_info_t info)>;
+using wifi_event_id_t = uint16_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+/**
+ * Station interface of the host fakes. Association never happens on its own:
+ * Host::Network::connect()/disconnect() deliver the events a real access
+ * point would produce, synchronously, to the onEvent() listeners.
+ */
+class WiFiClass
+{
+public:
+    static bool setHostname(const char* hostname);
+    static const char* getHostname();
+
+    void persistent(bool persistent) {}
+    bool mode(wifi_mode_t mode) { return true; }
+
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+    uint8_t* macAddress(uint8_t* mac);
+    String macAddress();
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+
+    String SSID() const;
+    String SSID(uint8_t networkItem);
+    wifi_auth_mode_t encryptionType(uint8_t networkItem);
+
+    int begin(const char* ssid, const char* passphrase = nullptr);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool reconnect();
+    [[nodiscard]] bool isConnected() const;
+    int8_t RSSI();
+
+    int16_t scanNetworks(bool async = false);
+    int16_t scanComplete();
+    void scanDelete();
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "IPAddress.h"
+
+// Multicast socket fed by Host::Network::injectUdp(); sent datagrams are only counted.
+class WiFiUDP
+{
+    std::string packet;
+    size_t readPosition = 0;
+    bool listening = false;
+
+public:
+    uint8_t beginMulticast(IPAddress address, uint16_t port);
+    void stop();
+
+    int parsePacket();
+    int read(uint8_t* buffer, size_t len);
+    int read(char* buffer, size_t len) { return read(reinterpret_cast<uint8_t*>(buffer), len); }
+    void clear();
+
+    IPAddress remoteIP() { return {192, 168, 1, 10}; }
+    uint16_t remotePort() { return 1900; }
+
+    int beginPacket(IPAddress address, uint16_t port) { return 1; }
+    size_t write(const uint8_t* buffer, size_t size) { return size; }
+    int endPacket();
+};
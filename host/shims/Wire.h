@@ -0,0 +1,29 @@
+#pragma once
+
+// Host stand-in for the arduino-esp32 Wire library, backed by the I2C bus
+// fake in host/fakes (see Host::I2c).
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire
+{
+    std::array<uint8_t, I2C_BUFFER_LENGTH> buffer = {};
+    size_t length = 0;
+    uint8_t address = 0;
+    bool transmitting = false;
+
+public:
+    bool begin(int sda, int scl, uint32_t frequency = 0);
+    void beginTransmission(uint8_t address);
+    // Returns 0 once the transmit buffer is full, like the device.
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t len);
+    // 0 on success, 2 when no device acknowledged the address.
+    uint8_t endTransmission(bool sendStop = true);
+};
+
+extern TwoWire Wire;
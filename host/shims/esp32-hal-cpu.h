@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+uint32_t getCpuFrequencyMhz();
+bool setCpuFrequencyMhz(uint32_t cpuFrequencyMhz);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+using esp_cpu_cycle_count_t = uint32_t;
+
+// Derived from the virtual clock at Host::Clock::CPU_MHZ; wraps like the CCOUNT register.
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count();
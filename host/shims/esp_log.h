@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdarg>
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+// Host logs go to stderr; the default level is WARN so simulations stay readable.
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char* tag);
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...);
+void esp_log_writev(esp_log_level_t level, const char* tag, const char* format, va_list args);
+
+#define ESP_LOGE(tag, format, ...) esp_log_write(ESP_LOG_ERROR, tag, format __VA_OPT__(,) __VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_write(ESP_LOG_WARN, tag, format __VA_OPT__(,) __VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_write(ESP_LOG_INFO, tag, format __VA_OPT__(,) __VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_write(ESP_LOG_DEBUG, tag, format __VA_OPT__(,) __VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_write(ESP_LOG_VERBOSE, tag, format __VA_OPT__(,) __VA_ARGS__)
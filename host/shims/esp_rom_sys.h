@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+// The current CPU frequency, i.e. what setCpuFrequencyMhz() last set.
+uint32_t esp_rom_get_cpu_ticks_per_us();
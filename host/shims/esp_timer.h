@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+// Microseconds of virtual time, see Host::Clock.
+int64_t esp_timer_get_time();
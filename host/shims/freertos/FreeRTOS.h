@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+using BaseType_t = int;
+using UBaseType_t = unsigned int;
+using TickType_t = uint32_t;
+using StackType_t = uint8_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define errQUEUE_EMPTY ((BaseType_t)0)
+#define errQUEUE_FULL ((BaseType_t)0)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / CONFIG_FREERTOS_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)CONFIG_FREERTOS_HZ) / (TickType_t)1000U))
+
+#define configMAX_TASK_NAME_LEN 16
+#define configMAX_PRIORITIES 25
+#define portNUM_PROCESSORS 2
+
+// The host runs a single thread, so critical sections have nothing to exclude.
+typedef struct
+{
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+inline bool xPortInIsrContext()
+{
+    return false;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Copying queues; with no other task running, a receive on an empty queue returns at once.
+struct QueueDefinition;
+using QueueHandle_t = QueueDefinition*;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+/**
+ * Tasks of the host fakes are recorded but never run: the simulation drives
+ * the Arduino loop and the worker pool itself, which keeps runs deterministic.
+ * The calling thread is always the loop task.
+ */
+struct tskTaskControlBlock;
+using TaskHandle_t = tskTaskControlBlock*;
+using TaskFunction_t = void (*)(void*);
+
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef struct
+{
+    TaskHandle_t xHandle;
+    const char* pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t* pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TaskHandle_t xTaskGetHandle(const char* name);
+BaseType_t xTaskGetCoreID(TaskHandle_t task);
+UBaseType_t uxTaskGetNumberOfTasks();
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* statuses, UBaseType_t size, uint32_t* totalRunTime);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TickType_t xTaskGetTickCount();
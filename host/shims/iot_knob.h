@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef void* knob_handle_t;
+
+typedef enum
+{
+    KNOB_LEFT = 0,
+    KNOB_RIGHT,
+    KNOB_H_LIM,
+    KNOB_L_LIM,
+    KNOB_ZERO,
+    KNOB_EVENT_MAX,
+} knob_event_t;
+
+typedef void (*knob_cb_t)(void* arg, void* data);
+
+typedef struct
+{
+    uint8_t default_direction;
+    uint8_t gpio_encoder_a;
+    uint8_t gpio_encoder_b;
+    bool enable_power_save;
+} knob_config_t;
+
+// Turns are injected with Host::Knob::turn().
+knob_handle_t iot_knob_create(const knob_config_t* config);
+esp_err_t iot_knob_delete(knob_handle_t knob_handle);
+esp_err_t iot_knob_register_cb(knob_handle_t knob_handle, knob_event_t event, knob_cb_t cb, void* usr_data);
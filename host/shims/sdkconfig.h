@@ -0,0 +1,33 @@
+#pragma once
+
+// Host build configuration: Kconfig defaults of main/Kconfig.projbuild plus sdkconfig.defaults.
+
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_ARDUINO_LOOP_STACK_SIZE 8192
+#define CONFIG_HEAP_USE_HOOKS 1
+#define CONFIG_PM_ENABLE 1
+#define CONFIG_FREERTOS_USE_TICKLESS_IDLE 1
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 240
+
+#define CONFIG_RGBW_CTRL_BOARD_RGBW 1
+#define CONFIG_RGBW_CTRL_NETWORK_CORE 0
+#define CONFIG_RGBW_CTRL_OUTPUT_CORE 1
+#define CONFIG_RGBW_CTRL_CALLBACK_BUDGET_US 2000
+#define CONFIG_RGBW_CTRL_SHED_REDUCED_BYTES 48000
+#define CONFIG_RGBW_CTRL_SHED_BYTES 32000
+#define CONFIG_RGBW_CTRL_SHED_CRITICAL_BYTES 20000
+#define CONFIG_RGBW_CTRL_LOW_HEAP_BYTES 20000
+#define CONFIG_RGBW_CTRL_LOW_HEAP_LARGEST_BLOCK_BYTES 8192
+#define CONFIG_RGBW_CTRL_PM_MIN_CPU_MHZ 40
+#define CONFIG_RGBW_CTRL_LIGHT_SLEEP 1
+// The simulations already run one loop() per virtual millisecond, so the loop does not sleep on its own.
+#define CONFIG_RGBW_CTRL_LOOP_DELAY_MS 0
+#define CONFIG_RGBW_CTRL_IDLE_LOOP_DELAY_MS 0
+#define CONFIG_RGBW_CTRL_STALL_THRESHOLD_MS 1000
+#define CONFIG_RGBW_CTRL_BINARY_LOG_ENTRIES 128
+#define CONFIG_RGBW_CTRL_BINARY_LOG_DRAIN 1
+#define CONFIG_RGBW_CTRL_HISTORY_SECONDS 300
+#define CONFIG_RGBW_CTRL_HISTORY_MINUTES 240
+#define CONFIG_RGBW_CTRL_COMMAND_TRACE_RECORDS 32
+// Off by default on the device; the host build runs the same kernels for comparison.
+#define CONFIG_RGBW_CTRL_BENCHMARKS 1
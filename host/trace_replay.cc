@@ -0,0 +1,282 @@
+// Replays a command trace downloaded from /system/trace (or saved by
+// controller_simulation --trace) against the host build. Each command is
+// injected at its recorded offset on the virtual clock, and the report
+// compares what the replay did with what the device recorded: whether each
+// command changed the output, and how long handlers took there and here.
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "harness.hh"
+#include "command_trace.hh"
+
+extern Output::Manager outputManager;
+
+namespace
+{
+    using namespace Harness;
+
+    struct Command
+    {
+        Trace::RecordHeader header;
+        std::array<uint8_t, Trace::MAX_PAYLOAD> payload;
+    };
+
+    struct Options
+    {
+        const char* path = nullptr;
+        bool timing = true;
+        // Virtual time to keep running the loop after the last command.
+        uint32_t settleMs = 1000;
+    };
+
+    bool load(const char* path, Trace::FileHeader& fileHeader, Vector<Command>& commands)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            return false;
+        }
+
+        bool valid = fread(&fileHeader, sizeof(fileHeader), 1, file) == 1 &&
+            fileHeader.magic == Trace::MAGIC && fileHeader.version == Trace::FORMAT_VERSION;
+        for (uint16_t i = 0; valid && i < fileHeader.count; ++i)
+        {
+            Command command = {};
+            valid = fread(&command.header, sizeof(command.header), 1, file) == 1 &&
+                command.header.length <= Trace::MAX_PAYLOAD &&
+                fread(command.payload.data(), 1, command.header.length, file) == command.header.length;
+            if (valid) commands.push_back(command);
+        }
+        fclose(file);
+
+        if (!valid) fprintf(stderr, "%s is not a version %u command trace\n", path, Trace::FORMAT_VERSION);
+        return valid;
+    }
+
+    struct SourceReport
+    {
+        uint32_t replayed = 0;
+        uint32_t skipped = 0;
+        // Commands whose effect on the output differs from the recording.
+        uint32_t diverged = 0;
+        Distribution deviceMicros;
+        Distribution hostNanos;
+        // Virtual time from injecting the command to the next LEDC write.
+        Distribution applyMs;
+    };
+
+    class Replay
+    {
+        const Options& options;
+        const Vector<Command>& commands;
+        std::array<SourceReport, Trace::SOURCE_COUNT> reports;
+        Host::Web::ClientId socket = 0;
+        uint32_t hueLightBase = 0;
+        int32_t firstDivergence = -1;
+
+        struct Pending
+        {
+            Trace::Source source;
+            uint64_t injectedUs;
+        };
+
+        Vector<Pending> pending;
+        uint32_t observedWrites = 0;
+
+        void observe()
+        {
+            const auto writes = Host::Ledc::getTotalWrites();
+            if (writes == observedWrites) return;
+            observedWrites = writes;
+            const auto now = Host::Clock::nowUs();
+            for (const auto& [source, injectedUs] : pending)
+                reports[static_cast<size_t>(source)].applyMs.add((now - injectedUs) / 1000);
+            pending.clear();
+        }
+
+        void step()
+        {
+            loop();
+            Host::Workers::runDue();
+            Host::Web::deliverSockets();
+            observe();
+        }
+
+        void runUntil(const uint64_t targetUs)
+        {
+            while (Host::Clock::nowUs() + 1000 <= targetUs)
+            {
+                Host::Clock::advanceMs(1);
+                step();
+            }
+            if (const auto now = Host::Clock::nowUs(); now < targetUs) Host::Clock::advanceUs(targetUs - now);
+        }
+
+        void inject(const Command& command)
+        {
+            const auto& header = command.header;
+            const auto* payload = command.payload.data();
+            switch (header.source)
+            {
+            case Trace::Source::EspNow:
+                Host::EspNow::receive(REMOTE_MAC, payload, header.length);
+                break;
+            case Trace::Source::WebSocket:
+                Host::Web::sendSocket(socket, payload, header.length);
+                break;
+            case Trace::Source::Ble:
+                Host::Ble::write(BLE::UUID::OUTPUT_COLOR_CHARACTERISTIC, payload, header.length);
+                break;
+            case Trace::Source::Hue:
+                Host::Web::send({
+                    Host::Web::Method::Post,
+                    std::string("/api/") + HUE_USER + "/lights/" + std::to_string(hueLightBase | header.channel) +
+                    "/state",
+                    {},
+                    std::string(reinterpret_cast<const char*>(payload), header.length)
+                });
+                break;
+            default:
+                break;
+            }
+        }
+
+        void prepare()
+        {
+            boot();
+            hueLightBase = static_cast<uint32_t>(strtoul(discoverHueLight().c_str(), nullptr, 10)) & ~127u;
+            socket = Host::Web::connectSocket();
+            if (std::ranges::any_of(commands, [](const Command& command)
+            {
+                return command.header.source == Trace::Source::Ble;
+            }))
+            {
+                Host::Web::send({Host::Web::Method::Get, "/bluetooth", {{"state", "on"}}});
+                Host::Ble::connect();
+            }
+            Host::Web::deliverSockets();
+            observedWrites = Host::Ledc::getTotalWrites();
+        }
+
+    public:
+        Replay(const Options& options, const Vector<Command>& commands)
+            : options(options), commands(commands)
+        {
+        }
+
+        void run()
+        {
+            prepare();
+
+            const auto startUs = Host::Clock::nowUs();
+            const auto firstUs = commands.empty() ? 0 : commands.front().header.timestampUs;
+            auto lastVersion = outputManager.getStateVersion();
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                const auto& command = commands[i];
+                const auto& header = command.header;
+                auto& report = reports[static_cast<size_t>(header.source)];
+                runUntil(startUs + (header.timestampUs - firstUs));
+
+                if (header.flags & Trace::TRUNCATED)
+                {
+                    report.skipped++;
+                    continue;
+                }
+
+                pending.push_back({header.source, Host::Clock::nowUs()});
+                const auto start = std::chrono::steady_clock::now();
+                inject(command);
+                report.hostNanos.add(nanosSince(start));
+                report.deviceMicros.add(header.durationUs);
+                report.replayed++;
+                observe();
+
+                // The first command has no recorded predecessor to compare its effect with.
+                const auto version = outputManager.getStateVersion();
+                if (i > 0)
+                {
+                    const bool recordedChange = header.stateVersion != commands[i - 1].header.stateVersion;
+                    if (recordedChange != (version != lastVersion))
+                    {
+                        report.diverged++;
+                        if (firstDivergence < 0) firstDivergence = static_cast<int32_t>(i);
+                    }
+                }
+                lastVersion = version;
+            }
+            runUntil(Host::Clock::nowUs() + options.settleMs * 1000ull);
+
+            print(firstUs, startUs);
+        }
+
+    private:
+        void print(const uint64_t firstUs, const uint64_t startUs)
+        {
+            const auto recordedSpanMs = commands.empty()
+                                            ? 0
+                                            : (commands.back().header.timestampUs - firstUs) / 1000;
+            printf("== %s: %zu commands over %" PRIu64 " ms\n", options.path, commands.size(), recordedSpanMs);
+            for (uint8_t i = 0; i < Trace::SOURCE_COUNT; ++i)
+            {
+                auto& report = reports[i];
+                if (report.replayed == 0 && report.skipped == 0) continue;
+                printf("  %-10s %" PRIu32 " replayed, %" PRIu32 " skipped (truncated), %" PRIu32 " diverged\n",
+                       Trace::sourceName(static_cast<Trace::Source>(i)), report.replayed, report.skipped,
+                       report.diverged);
+                printf("    device handler  p50 %" PRIu64 " us, max %" PRIu64 " us\n",
+                       report.deviceMicros.percentile(0.5), report.deviceMicros.max());
+                if (options.timing)
+                {
+                    printf("    host handler    p50 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+                           report.hostNanos.percentile(0.5), report.hostNanos.max());
+                }
+                printf("    apply latency   p50 %" PRIu64 " ms, max %" PRIu64 " ms, %zu samples\n",
+                       report.applyMs.percentile(0.5), report.applyMs.max(), report.applyMs.samples.size());
+            }
+            if (firstDivergence >= 0)
+                printf("  first divergence  command %" PRId32 "\n", firstDivergence);
+            else
+                printf("  output changes match the recording\n");
+            printf("  replay time       %" PRIu64 " ms virtual\n", (Host::Clock::nowUs() - startUs) / 1000);
+        }
+    };
+
+    bool parse(const int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            if (arg == "--no-timing") options.timing = false;
+            else if (arg == "--settle-ms" && i + 1 < argc) options.settleMs = strtoul(argv[++i], nullptr, 10);
+            else if (arg.starts_with("-") || options.path) return false;
+            else options.path = argv[i];
+        }
+        return options.path != nullptr;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--no-timing] [--settle-ms N] TRACE\n", argv[0]);
+        return 2;
+    }
+
+    Trace::FileHeader fileHeader;
+    Vector<Command> commands;
+    if (!load(options.path, fileHeader, commands)) return 1;
+    if (fileHeader.dropped)
+        printf("note: the device dropped %" PRIu32 " older commands before this trace\n", fileHeader.dropped);
+
+    Replay(options, commands).run();
+    return 0;
+}
@@ -5,19 +5,24 @@
 #include "async_esp_alexa_color_utils.hh"
 
 #include "output_manager.hh"
+#include "binary_log.hh"
+#include "callback_budget.hh"
+#include "heap_accounting.hh"
+#include "pending_value.hh"
+#include "reflect.hh"
 
 class AlexaIntegration final : public BLE::Service, public StateJsonFiller
 {
     static constexpr auto LOG_TAG = "AlexaIntegration";
     static constexpr unsigned long OUTPUT_STATE_UPDATE_INTERVAL_MS = 500;
+    static constexpr auto& OUTPUTS = ControllerHardware::BOARD.outputs;
+    // The color modes drive the first zone; the multi-device mode has one device per output.
+    static constexpr auto WHITE_OUTPUT = ControllerHardware::findOutput(Color::White).value();
 
 public:
 #pragma pack(push, 1)
     struct Settings
     {
-        static constexpr auto MAX_DEVICE_NAME_LENGTH
-            = AsyncEspAlexaDevice::MAX_DEVICE_NAME_LENGTH;
-
         enum class Mode : uint8_t
         {
             OFF = 0,
@@ -26,8 +31,33 @@ public:
             MULTI_DEVICE = 3
         };
 
+        // Boards with many outputs get shorter names, so the settings still fit in one BLE attribute.
+        static constexpr size_t MAX_DEVICE_NAME_LENGTH = std::min<size_t>(
+            AsyncEspAlexaDevice::MAX_DEVICE_NAME_LENGTH,
+            (BLE::MAX_ATTRIBUTE_LENGTH - sizeof(Mode)) / ControllerHardware::OUTPUT_COUNT);
+
+        using DeviceNames = std::array<std::array<char, MAX_DEVICE_NAME_LENGTH>, ControllerHardware::OUTPUT_COUNT>;
+
         Mode integrationMode = Mode::OFF;
-        std::array<std::array<char, MAX_DEVICE_NAME_LENGTH>, 4> deviceNames = {};
+        // One name per output; the color modes use the first one and, for the standalone device, white's.
+        DeviceNames deviceNames = {};
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("mode", &Settings::integrationMode, [](JsonVariant to, const Mode mode)
+                {
+                    to.set(modeString(mode));
+                }),
+                // Unused outputs have no name and are left out.
+                Reflect::field("names", &Settings::deviceNames, [](JsonVariant to, const DeviceNames& names)
+                {
+                    const auto array = to.to<JsonArray>();
+                    for (const auto& name : names)
+                        if (name[0] != '\0') Reflect::toJson(name, array.add<JsonVariant>());
+                }),
+            };
+        }
 
         bool operator==(const Settings& other) const
         {
@@ -43,15 +73,17 @@ public:
 
         void toJson(const JsonObject& to) const
         {
-            to["mode"] = this->integrationModeString();
-            const auto names = to["names"].to<JsonArray>();
-            for (const auto& name : deviceNames)
-                if (name[0] != '\0') names.add(name.data()); // NOLINT
+            Reflect::toJson(*this, to);
         }
 
         [[nodiscard]] const char* integrationModeString() const
         {
-            switch (integrationMode)
+            return modeString(integrationMode);
+        }
+
+        [[nodiscard]] static const char* modeString(const Mode mode)
+        {
+            switch (mode)
             {
             case Mode::OFF:
                 return "off";
@@ -80,7 +112,7 @@ private:
 
     struct MultiMode
     {
-        std::array<AsyncEspAlexaDimmableDevice*, 4> devices = {nullptr, nullptr, nullptr, nullptr};
+        std::array<AsyncEspAlexaDimmableDevice*, ControllerHardware::OUTPUT_COUNT> devices = {};
     };
 
     union ModeDevice
@@ -95,6 +127,7 @@ private:
     AsyncEspAlexaManager espAlexaManager;
 
     Settings settings;
+    PendingValue<Settings> pendingSettings;
     ModeDevice devices = {};
     Output::State outputState;
     unsigned long lastOutputStateUpdate = 0;
@@ -109,16 +142,25 @@ public:
         clearDevices();
     }
 
+    // Builds the devices from NVS; the web handler can be registered afterwards.
     void begin()
     {
         loadPreferences();
         setupDevices();
-        espAlexaManager.begin();
         outputState = outputManager.getState();
     }
 
+    // Answers SSDP searches; needs an IP address, so it is called again after every reconnect.
+    void startDiscovery()
+    {
+        espAlexaManager.begin();
+    }
+
     void handle(const unsigned long now)
     {
+        HeapAccounting::Scope heapScope(HeapAccounting::Tag::Alexa);
+        if (const auto newSettings = pendingSettings.take())
+            applySettings(newSettings.value());
         espAlexaManager.loop();
         if (now - lastOutputStateUpdate >= OUTPUT_STATE_UPDATE_INTERVAL_MS)
         {
@@ -142,6 +184,16 @@ public:
         return settings;
     }
 
+    /**
+     * Defers applySettings() to the next handle() call, so the devices are
+     * rebuilt on the loop task that also serves them instead of inside a
+     * BLE or WebSocket callback.
+     */
+    void requestSettings(const Settings& settings)
+    {
+        pendingSettings.put(settings);
+    }
+
     void applySettings(const Settings& settings)
     {
         this->settings = settings;
@@ -191,21 +243,13 @@ private:
             settings.integrationMode = Settings::Mode::OFF;
         }
 
-        const String r = prefs.getString("r", "");
-        const String g = prefs.getString("g", "");
-        const String b = prefs.getString("b", "");
-        const String w = prefs.getString("w", "");
+        for (size_t i = 0; i < OUTPUTS.size(); ++i)
+        {
+            const String name = prefs.getString(OUTPUTS[i].key, "");
+            strncpy(settings.deviceNames[i].data(), name.c_str(), Settings::MAX_DEVICE_NAME_LENGTH - 1);
+            settings.deviceNames[i][Settings::MAX_DEVICE_NAME_LENGTH - 1] = '\0';
+        }
         prefs.end();
-
-        strncpy(settings.deviceNames[0].data(), r.c_str(), Settings::MAX_DEVICE_NAME_LENGTH - 1);
-        strncpy(settings.deviceNames[1].data(), g.c_str(), Settings::MAX_DEVICE_NAME_LENGTH - 1);
-        strncpy(settings.deviceNames[2].data(), b.c_str(), Settings::MAX_DEVICE_NAME_LENGTH - 1);
-        strncpy(settings.deviceNames[3].data(), w.c_str(), Settings::MAX_DEVICE_NAME_LENGTH - 1);
-
-        settings.deviceNames[0][Settings::MAX_DEVICE_NAME_LENGTH - 1] = '\0';
-        settings.deviceNames[1][Settings::MAX_DEVICE_NAME_LENGTH - 1] = '\0';
-        settings.deviceNames[2][Settings::MAX_DEVICE_NAME_LENGTH - 1] = '\0';
-        settings.deviceNames[3][Settings::MAX_DEVICE_NAME_LENGTH - 1] = '\0';
     }
 
     void savePreferences()
@@ -213,10 +257,8 @@ private:
         Preferences prefs;
         prefs.begin("alexa-config", false);
         prefs.putUChar("mode", static_cast<uint8_t>(settings.integrationMode));
-        prefs.putString("r", settings.deviceNames[0].data());
-        prefs.putString("g", settings.deviceNames[1].data());
-        prefs.putString("b", settings.deviceNames[2].data());
-        prefs.putString("w", settings.deviceNames[3].data());
+        for (size_t i = 0; i < OUTPUTS.size(); ++i)
+            prefs.putString(OUTPUTS[i].key, settings.deviceNames[i].data());
         prefs.end();
     }
 
@@ -236,7 +278,7 @@ private:
             setupStandaloneDevice();
             break;
         case Settings::Mode::MULTI_DEVICE:
-            espAlexaManager.reserve(4);
+            espAlexaManager.reserve(OUTPUTS.size());
             setupMultiDevice();
             break;
         }
@@ -280,8 +322,9 @@ private:
             return;
         }
         ESP_LOGI(LOG_TAG, "Adding RGB device: %s", settings.deviceNames[0].data());
-        const auto [r, g, b, w]
-            = outputManager.getValues();
+        const auto r = outputManager.getValue(Color::Red);
+        const auto g = outputManager.getValue(Color::Green);
+        const auto b = outputManager.getValue(Color::Blue);
         const auto on = outputManager.isOn(Color::Red)
             || outputManager.isOn(Color::Green)
             || outputManager.isOn(Color::Blue);
@@ -301,26 +344,23 @@ private:
 
     void setupStandaloneDevice()
     {
-        devices.rgb.standaloneDevice = createSingleChannelDevice(settings.deviceNames[3].data(), Color::White);
+        devices.rgb.standaloneDevice = createSingleChannelDevice(settings.deviceNames[WHITE_OUTPUT].data(),
+                                                                 WHITE_OUTPUT);
         if (devices.rgb.standaloneDevice)
             espAlexaManager.addDevice(devices.rgb.standaloneDevice);
     }
 
     void setupMultiDevice()
     {
-        const auto rDevice = createSingleChannelDevice(settings.deviceNames[0].data(), Color::Red);
-        const auto gDevice = createSingleChannelDevice(settings.deviceNames[1].data(), Color::Green);
-        const auto bDevice = createSingleChannelDevice(settings.deviceNames[2].data(), Color::Blue);
-        const auto wDevice = createSingleChannelDevice(settings.deviceNames[3].data(), Color::White);
-        if (rDevice) espAlexaManager.addDevice(rDevice);
-        if (gDevice) espAlexaManager.addDevice(gDevice);
-        if (bDevice) espAlexaManager.addDevice(bDevice);
-        if (wDevice) espAlexaManager.addDevice(wDevice);
-        devices.multi = {rDevice, gDevice, bDevice, wDevice};
+        for (size_t i = 0; i < OUTPUTS.size(); ++i)
+        {
+            devices.multi.devices[i] = createSingleChannelDevice(settings.deviceNames[i].data(), i);
+            if (devices.multi.devices[i]) espAlexaManager.addDevice(devices.multi.devices[i]);
+        }
     }
 
     [[nodiscard]] AsyncEspAlexaDimmableDevice* createSingleChannelDevice(
-        const char* name, Color color) const
+        const char* name, const size_t channel) const
     {
         if (name[0] == '\0')
         {
@@ -328,14 +368,14 @@ private:
             return nullptr;
         }
         ESP_LOGI(LOG_TAG, "Adding single device: %s", name);
-        const auto value = outputManager.getValue(color);
-        const auto on = outputManager.isOn(color);
+        const auto value = outputManager.getValue(OUTPUTS[channel].color, OUTPUTS[channel].zone);
+        const auto on = outputManager.isOn(OUTPUTS[channel].color, OUTPUTS[channel].zone);
         const auto device = new AsyncEspAlexaDimmableDevice(name, on, value);
 
 
-        device->setBrightnessCallback([this, name, color](const bool isOn, const uint8_t brightness)
+        device->setBrightnessCallback([this, name, channel](const bool isOn, const uint8_t brightness)
         {
-            this->handleSingleChannelCommand(name, color, isOn, brightness);
+            this->handleSingleChannelCommand(name, channel, isOn, brightness);
         });
         return device;
     }
@@ -343,11 +383,11 @@ private:
     void handleRgbwCommand(const bool isOn, const uint8_t brightness,
                            const uint16_t hue, const uint8_t saturation) const
     {
-        ESP_LOGI(LOG_TAG, "Received HS command: on=%d, brightness=%u, hue=%u, saturation=%u",
-                 isOn, brightness, hue, saturation);
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Received HS command: on=%d, brightness=%u, hue=%u, saturation=%u",
+                    isOn, brightness, hue, saturation);
         const auto [r, g, b,w]
             = AsyncEspAlexaColorUtils::hsvToRgbw(hue, saturation, brightness);
-        ESP_LOGI(LOG_TAG, "Converted RGBW: r=%u, g=%u, b=%u, w=%u", r, g, b, w);
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Converted RGBW: r=%u, g=%u, b=%u, w=%u", r, g, b, w);
         outputManager.setColor(r, g, b, w);
         outputManager.setOn(isOn, Color::Red);
         outputManager.setOn(isOn, Color::Green);
@@ -358,11 +398,11 @@ private:
     void handleRgbwCommand(const bool isOn, const uint8_t brightness,
                            const uint16_t colorTemperature) const
     {
-        ESP_LOGI(LOG_TAG, "Received CT command: on=%d, brightness=%u, colorTemperature=%u",
-                 isOn, brightness, colorTemperature);
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Received CT command: on=%d, brightness=%u, colorTemperature=%u",
+                    isOn, brightness, colorTemperature);
         const auto [r, g, b, w]
             = AsyncEspAlexaColorUtils::ctToRgbw(brightness, colorTemperature);
-        ESP_LOGI(LOG_TAG, "Converted RGBW: r=%u, g=%u, b=%u, w=%u", r, g, b, w);
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Converted RGBW: r=%u, g=%u, b=%u, w=%u", r, g, b, w);
         outputManager.setColor(r, g, b, w);
         outputManager.setOn(isOn, Color::Red);
         outputManager.setOn(isOn, Color::Green);
@@ -373,22 +413,25 @@ private:
     void handleRgbCommand(const bool isOn, const uint8_t brightness,
                           const uint16_t hue, const uint8_t saturation) const
     {
-        ESP_LOGI(LOG_TAG, "Received HS command: brightness=%u, hue=%u, saturation=%u",
-                 brightness, hue, saturation);
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Received HS command: brightness=%u, hue=%u, saturation=%u",
+                    brightness, hue, saturation);
         const auto [r, g, b] = AsyncEspAlexaColorUtils::hsvToRgb(hue, saturation, brightness);
-        ESP_LOGI(LOG_TAG, "Converted RGB: r=%u, g=%u, b=%u", r, g, b);
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Converted RGB: r=%u, g=%u, b=%u", r, g, b);
         outputManager.setColor(r, g, b);
         outputManager.setOn(isOn, Color::Red);
         outputManager.setOn(isOn, Color::Green);
         outputManager.setOn(isOn, Color::Blue);
     }
 
-    void handleSingleChannelCommand(__unused const char* name, const Color color,
+    void handleSingleChannelCommand(__unused const char* name, const size_t channel,
                                     const bool isOn, const uint8_t brightness) const
     {
-        ESP_LOGI(LOG_TAG, "Received %s command: on=%d, brightness=%u", name, isOn, brightness);
-        outputManager.setOn(isOn, color);
-        outputManager.setValue(brightness < 128 ? brightness : brightness + 1, color);
+        // The device name is not kept: it can be renamed before the entry is formatted.
+        BINARY_LOGI(BinaryLog::Tag::Alexa, "Received command for channel %u: on=%d, brightness=%u",
+                    static_cast<unsigned>(channel), isOn, brightness);
+        const auto& output = OUTPUTS[channel];
+        outputManager.setOn(isOn, output.color, output.zone);
+        outputManager.setValue(brightness < 128 ? brightness : brightness + 1, output.color, output.zone);
     }
 
     void updateRgbwDevice() const
@@ -421,25 +464,23 @@ private:
 
     void updateStandaloneDevice() const
     {
-        updateDevice(devices.rgb.standaloneDevice, Color::White);
+        updateDevice(devices.rgb.standaloneDevice, WHITE_OUTPUT);
     }
 
     void updateMultiDevices() const
     {
-        updateDevice(devices.multi.devices[0], Color::Red);
-        updateDevice(devices.multi.devices[1], Color::Green);
-        updateDevice(devices.multi.devices[2], Color::Blue);
-        updateDevice(devices.multi.devices[3], Color::White);
+        for (size_t i = 0; i < OUTPUTS.size(); ++i)
+            updateDevice(devices.multi.devices[i], i);
     }
 
-    void updateDevice(AsyncEspAlexaDimmableDevice* device, const Color color) const
+    void updateDevice(AsyncEspAlexaDimmableDevice* device, const size_t channel) const
     {
         if (!device) return;
-        const auto brightness = std::clamp(outputState.getValue(color),
+        const auto brightness = std::clamp(outputState.values[channel].value,
                                            AsyncEspAlexaColorUtils::ALEXA_MIN_BRI_VAL,
                                            AsyncEspAlexaColorUtils::ALEXA_MAX_BRI_VAL);
 
-        const auto on = outputState.isOn(color);
+        const auto on = outputState.values[channel].on;
         device->setOn(on);
         device->setBrightness(brightness);
     }
@@ -478,20 +519,26 @@ private:
 
         void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "AlexaCallback::onWrite");
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
             Settings settings;
-            if (pCharacteristic->getValue().size() != sizeof(Settings))
+            if (const auto value = pCharacteristic->getValue(); !Reflect::decode(value.data(), value.size(), settings))
             {
-                ESP_LOGE(LOG_TAG, "Received invalid Alexa settings length: %d", pCharacteristic->getValue().size());
+                ESP_LOGE(LOG_TAG, "Received invalid Alexa settings length: %d", value.size());
                 return;
             }
-            memcpy(&settings, pCharacteristic->getValue().data(), sizeof(Settings));
-            alexaIntegration->applySettings(settings);
+            alexaIntegration->requestSettings(settings);
         }
 
         void onRead(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
-            auto settings = alexaIntegration->getSettings();
-            pCharacteristic->setValue(reinterpret_cast<uint8_t*>(&settings), sizeof(Settings));
+            const auto payload = Reflect::encode(alexaIntegration->getSettings());
+            pCharacteristic->setValue(payload.data(), payload.size());
         }
     };
 };
+
+static_assert(Reflect::checkLayout<AlexaIntegration::Settings>(),
+              "Alexa settings are exchanged as is over BLE and WebSocket");
+static_assert(Reflect::wireSize<AlexaIntegration::Settings>() <= BLE::MAX_ATTRIBUTE_LENGTH,
+              "Alexa settings must fit in one BLE attribute");
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
 
-void async_call(std::function<void()> callback, uint32_t usStackDepth, uint32_t delayMs);
+#include "worker_pool.hh"
+
+/**
+ * Legacy entry point kept for compatibility: runs `callback` on the worker pool.
+ * `usStackDepth` is only checked against the worker stack size.
+ */
+void async_call(const Async::Job& callback, uint32_t usStackDepth, uint32_t delayMs);
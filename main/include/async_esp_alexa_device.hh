@@ -3,8 +3,12 @@
 #include <ArduinoJson.h>
 #include <WiFi.h>
 #include <array>
+#include <cstring>
 #include <utility>
 
+#include "async_esp_alexa_identity.hh"
+#include "delegate.hh"
+
 /**
  * @brief Base class for Alexa-compatible smart lighting devices.
  *
@@ -28,10 +32,10 @@ private:
     friend class AsyncEspAlexaWebHandler;
 
     uint8_t id;
-    const String name;
-    std::function<void(AsyncEspAlexaDevice* device)> beforeStateUpdateCallback = nullptr;
+    std::array<char, MAX_DEVICE_NAME_LENGTH + 1> name = {};
+    Delegate<void(AsyncEspAlexaDevice* device)> beforeStateUpdateCallback = nullptr;
 
-    mutable std::array<char, 27> uniqueIdCache = {};
+    mutable std::array<char, AsyncEspAlexaIdentity::UNIQUE_ID_LENGTH + 1> uniqueIdCache = {};
     bool on;
 
     virtual void callAfterStateUpdateCallback() = 0;
@@ -52,36 +56,19 @@ private:
     [[nodiscard]] const char* getUniqueId() const
     {
         if (uniqueIdCache[0] == '\0')
-        {
-            uint8_t mac[6];
-            WiFi.macAddress(mac);
-            snprintf(uniqueIdCache.data(), uniqueIdCache.size(),
-                     "%02X:%02X:%02X:%02X:%02X:%02X-%02X-00:11",
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], this->id);
-        }
+            AsyncEspAlexaIdentity::get().formatUniqueId(uniqueIdCache, this->id);
         return uniqueIdCache.data();
     }
 
-    static uint32_t getMac24()
-    {
-        String escapedMac = WiFi.macAddress();
-        escapedMac.replace(":", "");
-        escapedMac.toLowerCase();
-        const String macSubStr = escapedMac.substring(6, 12);
-        return strtol(macSubStr.c_str(), nullptr, 16);
-    }
-
     [[nodiscard]] static uint32_t encodeLightKey(const uint8_t idx)
     {
-        static uint32_t mac24 = getMac24();
-        return mac24 << 7 | idx;
+        return AsyncEspAlexaIdentity::get().mac24() << 7 | idx;
     }
 
     [[nodiscard]] static uint8_t decodeLightKey(const uint32_t key)
     {
-        static uint32_t mac24 = getMac24();
         static constexpr uint8_t INVALID_DEVICE_INDEX = 255U;
-        return key >> 7 == mac24 ? key & 127U : INVALID_DEVICE_INDEX;
+        return key >> 7 == AsyncEspAlexaIdentity::get().mac24() ? key & 127U : INVALID_DEVICE_INDEX;
     }
 
 protected:
@@ -92,14 +79,15 @@ protected:
     }
 
 public:
-    explicit AsyncEspAlexaDevice(String name, const bool on = false)
-        : id(0), name(std::move(name)), on(on)
+    explicit AsyncEspAlexaDevice(const char* name, const bool on = false)
+        : id(0), on(on)
     {
+        strncpy(this->name.data(), name, MAX_DEVICE_NAME_LENGTH);
     }
 
     virtual ~AsyncEspAlexaDevice() = default;
 
-    void setBeforeStateUpdateCallback(const std::function<void(AsyncEspAlexaDevice* device)>& callback)
+    void setBeforeStateUpdateCallback(const Delegate<void(AsyncEspAlexaDevice* device)>& callback)
     {
         this->beforeStateUpdateCallback = callback;
     }
@@ -129,9 +117,9 @@ public:
         return id;
     }
 
-    [[nodiscard]] String getName() const
+    [[nodiscard]] const char* getName() const
     {
-        return name;
+        return name.data();
     }
 
     [[nodiscard]] bool isOn() const
@@ -147,7 +135,7 @@ public:
 
 class AsyncEspAlexaOnOffDevice : public AsyncEspAlexaDevice
 {
-    std::function<void(bool on)> onOffCallback = nullptr;
+    Delegate<void(bool on)> onOffCallback = nullptr;
 
 protected:
     void callAfterStateUpdateCallback() override
@@ -157,13 +145,13 @@ protected:
     }
 
 public:
-    explicit AsyncEspAlexaOnOffDevice(const String& name,
+    explicit AsyncEspAlexaOnOffDevice(const char* name,
                                       const bool on = false)
         : AsyncEspAlexaDevice(name, on)
     {
     }
 
-    void setOnOffCallback(const std::function<void(bool on)>& callback)
+    void setOnOffCallback(const Delegate<void(bool on)>& callback)
     {
         this->onOffCallback = callback;
     }
@@ -188,7 +176,7 @@ class AsyncEspAlexaDimmableDevice : public AsyncEspAlexaOnOffDevice
 {
     uint8_t brightness;
 
-    std::function<void(bool on, uint8_t brightness)> brightnessCallback = nullptr;
+    Delegate<void(bool on, uint8_t brightness)> brightnessCallback = nullptr;
 
 protected:
     void callAfterStateUpdateCallback() override
@@ -212,13 +200,13 @@ protected:
     }
 
 public:
-    explicit AsyncEspAlexaDimmableDevice(const String& name,
+    explicit AsyncEspAlexaDimmableDevice(const char* name,
                                          const bool on = false, const uint8_t brightness = 0)
         : AsyncEspAlexaOnOffDevice(name, on), brightness(brightness)
     {
     }
 
-    void setBrightnessCallback(const std::function<void(bool on, uint8_t brightness)>& callback)
+    void setBrightnessCallback(const Delegate<void(bool on, uint8_t brightness)>& callback)
     {
         this->brightnessCallback = callback;
     }
@@ -261,7 +249,7 @@ class AsyncEspAlexaWhiteSpectrumDevice final : public AsyncEspAlexaDimmableDevic
 {
     uint16_t colorTemperature;
 
-    std::function<void(bool on, uint8_t brightness, uint16_t colorTemperature)> callback = nullptr;
+    Delegate<void(bool on, uint8_t brightness, uint16_t colorTemperature)> callback = nullptr;
 
 protected:
     void callAfterStateUpdateCallback() override
@@ -279,13 +267,13 @@ protected:
     }
 
 public:
-    explicit AsyncEspAlexaWhiteSpectrumDevice(const String& name, const bool on = false,
+    explicit AsyncEspAlexaWhiteSpectrumDevice(const char* name, const bool on = false,
                                               const uint8_t brightness = 0, const uint16_t colorTemperature = 500)
         : AsyncEspAlexaDimmableDevice(name, on, brightness), colorTemperature(colorTemperature)
     {
     }
 
-    void setCallback(const std::function<void(bool on, uint8_t brightness, uint16_t colorTemperature)>& callback)
+    void setCallback(const Delegate<void(bool on, uint8_t brightness, uint16_t colorTemperature)>& callback)
     {
         this->callback = callback;
     }
@@ -329,7 +317,7 @@ class AsyncEspAlexaColorDevice final : public AsyncEspAlexaDimmableDevice
     uint16_t hue;
     uint8_t saturation;
 
-    std::function<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)> colorCallback = nullptr;
+    Delegate<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)> colorCallback = nullptr;
 
 protected:
     void callAfterStateUpdateCallback() override
@@ -349,14 +337,14 @@ protected:
     }
 
 public:
-    explicit AsyncEspAlexaColorDevice(const String& name, const bool on = false, const uint8_t brightness = 0,
+    explicit AsyncEspAlexaColorDevice(const char* name, const bool on = false, const uint8_t brightness = 0,
                                       const uint16_t hue = 0, const uint8_t saturation = 0)
         : AsyncEspAlexaDimmableDevice(name, on, brightness), hue(hue), saturation(saturation)
     {
     }
 
     void setColorCallback(
-        const std::function<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)>& callback)
+        const Delegate<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)>& callback)
     {
         this->colorCallback = callback;
     }
@@ -424,8 +412,8 @@ private:
     uint16_t colorTemperature;
     ColorMode mode;
 
-    std::function<void(bool on, uint8_t brightness, uint16_t colorTemperature)> colorTemperatureCallback = nullptr;
-    std::function<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)> colorCallback = nullptr;
+    Delegate<void(bool on, uint8_t brightness, uint16_t colorTemperature)> colorTemperatureCallback = nullptr;
+    Delegate<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)> colorCallback = nullptr;
 
 protected:
     void callAfterStateUpdateCallback() override
@@ -451,7 +439,7 @@ protected:
     }
 
 public:
-    explicit AsyncEspAlexaExtendedColorDevice(const String& name, const bool on = false, const uint8_t brightness = 0,
+    explicit AsyncEspAlexaExtendedColorDevice(const char* name, const bool on = false, const uint8_t brightness = 0,
                                               const uint16_t hue = 0, const uint8_t saturation = 0,
                                               const uint16_t colorTemperature = 500,
                                               const ColorMode mode = ColorMode::ct)
@@ -461,13 +449,13 @@ public:
     }
 
     void setColorTemperatureCallback(
-        const std::function<void(bool on, uint8_t brightness, uint16_t colorTemperature)>& callback)
+        const Delegate<void(bool on, uint8_t brightness, uint16_t colorTemperature)>& callback)
     {
         this->colorTemperatureCallback = callback;
     }
 
     void setColorCallback(
-        const std::function<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)>& callback)
+        const Delegate<void(bool on, uint8_t brightness, uint16_t hue, uint8_t saturation)>& callback)
     {
         this->colorCallback = callback;
     }
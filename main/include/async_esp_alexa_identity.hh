@@ -0,0 +1,75 @@
+#pragma once
+
+#include <WiFi.h>
+#include <array>
+#include <cstdio>
+#include <string_view>
+
+/**
+ * @brief Bridge identity advertised to Alexa, derived once from the station MAC.
+ *
+ * Every string used by the Hue emulation (SSDP answers, description.xml,
+ * light keys and unique ids) is formatted into fixed buffers on first use,
+ * so serving Alexa never builds a String at runtime.
+ */
+class AsyncEspAlexaIdentity
+{
+public:
+    static const AsyncEspAlexaIdentity& get()
+    {
+        static const AsyncEspAlexaIdentity identity;
+        return identity;
+    }
+
+    // "aabbccddeeff", used as bridge id, serial number and UDN suffix.
+    [[nodiscard]] std::string_view escapedMac() const
+    {
+        return {escapedMacBuffer.data(), ESCAPED_MAC_LENGTH};
+    }
+
+    // "AA:BB:CC:DD:EE:FF", the prefix of every light unique id.
+    [[nodiscard]] std::string_view macAddress() const
+    {
+        return {macAddressBuffer.data(), MAC_ADDRESS_LENGTH};
+    }
+
+    // Lower three MAC bytes, mixed into the light keys.
+    [[nodiscard]] uint32_t mac24() const
+    {
+        return mac24Value;
+    }
+
+    [[nodiscard]] const char* escapedMacCStr() const
+    {
+        return escapedMacBuffer.data();
+    }
+
+    // Writes "<MAC>-<id>-00:11" into `buffer`, the unique id Hue expects for a light.
+    template <size_t N>
+    void formatUniqueId(std::array<char, N>& buffer, const uint8_t id) const
+    {
+        static_assert(N >= UNIQUE_ID_LENGTH + 1, "Unique id buffer too small");
+        snprintf(buffer.data(), buffer.size(), "%s-%02X-00:11", macAddressBuffer.data(), id);
+    }
+
+    static constexpr size_t UNIQUE_ID_LENGTH = 26;
+
+private:
+    static constexpr size_t ESCAPED_MAC_LENGTH = 12;
+    static constexpr size_t MAC_ADDRESS_LENGTH = 17;
+
+    std::array<char, ESCAPED_MAC_LENGTH + 1> escapedMacBuffer = {};
+    std::array<char, MAC_ADDRESS_LENGTH + 1> macAddressBuffer = {};
+    uint32_t mac24Value = 0;
+
+    AsyncEspAlexaIdentity()
+    {
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(escapedMacBuffer.data(), escapedMacBuffer.size(), "%02x%02x%02x%02x%02x%02x",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        snprintf(macAddressBuffer.data(), macAddressBuffer.size(), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        mac24Value = static_cast<uint32_t>(mac[3]) << 16 | static_cast<uint32_t>(mac[4]) << 8 | mac[5];
+    }
+};
@@ -13,14 +13,13 @@ class AsyncEspAlexaManager
     bool discoverable = true;
     bool udpConnected = false;
     WiFiUDP espAlexaUdp;
-    uint32_t mac24 = 0;
-    String escapedMac = "";
 
     void respondToSearch()
     {
         IPAddress localIP = WiFi.localIP();
         char s[16];
         sprintf(s, "%d.%d.%d.%d", localIP[0], localIP[1], localIP[2], localIP[3]);
+        const auto& identity = AsyncEspAlexaIdentity::get();
         char buf[1024];
         sprintf_P(buf,PSTR("HTTP/1.1 200 OK\r\n"
                       "EXT:\r\n"
@@ -30,7 +29,7 @@ class AsyncEspAlexaManager
                       "hue-bridgeid: %s\r\n"
                       "ST: urn:schemas-upnp-org:device:basic:1\r\n"
                       "USN: uuid:2f402f80-da50-11e1-9b23-%s::upnp:rootdevice\r\n"
-                      "\r\n"), s, escapedMac.c_str(), escapedMac.c_str());
+                      "\r\n"), s, identity.escapedMacCStr(), identity.escapedMacCStr());
         espAlexaUdp.beginPacket(espAlexaUdp.remoteIP(), espAlexaUdp.remotePort());
         espAlexaUdp.write(reinterpret_cast<uint8_t*>(buf), strlen(buf));
         espAlexaUdp.endPacket();
@@ -39,11 +38,8 @@ class AsyncEspAlexaManager
 public:
     bool begin()
     {
-        escapedMac = WiFi.macAddress();
-        escapedMac.replace(":", "");
-        escapedMac.toLowerCase();
-        const String macSubStr = escapedMac.substring(6, 12);
-        mac24 = strtol(macSubStr.c_str(), nullptr, 16);
+        // Formats the bridge identity now so no request has to.
+        AsyncEspAlexaIdentity::get();
         udpConnected = espAlexaUdp.beginMulticast(IPAddress(239, 255, 255, 250), 1900);
         if (udpConnected)
         {
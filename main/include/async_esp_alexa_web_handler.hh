@@ -4,28 +4,47 @@
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
+#include "json_pool.hh"
+#include <charconv>
+#include <array>
+#include <optional>
+#include <string_view>
 #include "async_esp_alexa_device.hh"
+#include "async_esp_alexa_identity.hh"
+#include "command_trace.hh"
+#include "heap_accounting.hh"
+#include "power.hh"
 
 class AsyncEspAlexaWebHandler final : public AsyncWebHandler
 {
     static constexpr auto LOG_TAG = "AsyncEspAlexaWebHandler";
+    // Hue state PUTs ({"on":true,"bri":254,"hue":...,"sat":...,"ct":...}) are far below this; larger bodies are refused.
+    static constexpr size_t MAX_BODY_LENGTH = 256;
 
     const std::vector<AsyncEspAlexaDevice*>& devices;
-    String escapedMac;
+
+    // async_tcp hands over one body at a time, so a single buffer serves every request; a body that starts
+    // while another is still being received takes it over, and the earlier request is refused.
+    std::array<char, MAX_BODY_LENGTH + 1> body = {};
+    const AsyncWebServerRequest* bodyOwner = nullptr;
+    size_t bodyLength = 0;
+
+    static std::string_view urlOf(const AsyncWebServerRequest* request)
+    {
+        const auto& url = request->url();
+        return {url.c_str(), url.length()};
+    }
 
 public:
     explicit AsyncEspAlexaWebHandler(const std::vector<AsyncEspAlexaDevice*>& devices)
         : devices(devices)
     {
-        escapedMac = WiFi.macAddress();
-        escapedMac.replace(":", "");
-        escapedMac.toLowerCase();
     }
 
     bool canHandle(AsyncWebServerRequest* request) const override
     {
-        const auto& url = request->url();
-        return url.startsWith("/description.xml") || url.startsWith("/api");
+        const auto url = urlOf(request);
+        return url.starts_with("/description.xml") || url.starts_with("/api");
     }
 
     void handleBody(AsyncWebServerRequest* request,
@@ -36,39 +55,52 @@ public:
     {
         if (index == 0)
         {
-            // this check allows request->_tempObject to be initialized from a middleware
-            if (request->_tempObject == nullptr)
-            {
-                request->_tempObject = calloc(total + 1, sizeof(uint8_t)); // null-terminated string
-                if (request->_tempObject == nullptr)
-                {
-                    ESP_LOGE(LOG_TAG, "Failed to allocate memory for request body");
-                    request->abort();
-                    return;
-                }
-            }
+            bodyOwner = total <= MAX_BODY_LENGTH ? request : nullptr;
+            bodyLength = 0;
         }
-
-        if (request->_tempObject != nullptr)
+        if (bodyOwner != request) return;
+        if (index != bodyLength || index + len > MAX_BODY_LENGTH)
         {
-            auto* buffer = static_cast<uint8_t*>(request->_tempObject);
-            memcpy(buffer + index, data, len);
+            bodyOwner = nullptr;
+            return;
         }
+        memcpy(body.data() + index, data, len);
+        bodyLength += len;
     }
 
     void handleRequest(AsyncWebServerRequest* request) override
     {
-        if (request->url() == "/description.xml")
+        HeapAccounting::Scope heapScope(HeapAccounting::Tag::Alexa);
+        if (urlOf(request) == "/description.xml")
             return serveDescription(request);
         handleAlexaApiCall(request);
     }
 
 private:
+    // Matches String::indexOf(...) > 0: the needle must not start the URL.
+    static bool contains(const std::string_view url, const std::string_view needle)
+    {
+        const auto pos = url.find(needle);
+        return pos != std::string_view::npos && pos > 0;
+    }
+
+    // Light key after the "lights/" found at `pos`; nullopt when the URL ends there or no number follows.
+    static std::optional<uint32_t> lightKeyAt(const std::string_view url, const size_t pos)
+    {
+        if (pos + 7 >= url.size()) return std::nullopt;
+        const auto digits = url.substr(pos + 7);
+        uint32_t key = 0;
+        const auto result = std::from_chars(digits.data(), digits.data() + digits.size(), key);
+        if (result.ec != std::errc()) return std::nullopt;
+        return key;
+    }
+
     void serveDescription(AsyncWebServerRequest* request) const
     {
         IPAddress localIP = WiFi.localIP();
         char s[16];
         sprintf(s, "%d.%d.%d.%d", localIP[0], localIP[1], localIP[2], localIP[3]);
+        const auto& identity = AsyncEspAlexaIdentity::get();
         char buf[1024];
         sprintf_P(buf,PSTR("<?xml version=\"1.0\" ?>"
                       "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
@@ -87,36 +119,44 @@ private:
                       "<UDN>uuid:2f402f80-da50-11e1-9b23-%s</UDN>"
                       "<presentationURL>index.html</presentationURL>"
                       "</device>"
-                      "</root>"), s, s, escapedMac.c_str(), escapedMac.c_str());
+                      "</root>"), s, s, identity.escapedMacCStr(), identity.escapedMacCStr());
         request->send(200, "text/xml", buf);
     }
 
-    void handleAlexaApiCall(AsyncWebServerRequest* request) const
+    void handleAlexaApiCall(AsyncWebServerRequest* request)
     {
-        const auto& url = request->url();
-        ESP_LOGD(LOG_TAG, "Received %s request: %s", request->methodToString(), url.c_str());
+        const auto url = urlOf(request);
+        ESP_LOGD(LOG_TAG, "Received %s request: %s", request->methodToString(), url.data());
 
-        if (request->_tempObject != nullptr)
+        if (const auto length = request->contentLength(); length > 0)
+        {
+            if (length > MAX_BODY_LENGTH)
+                return request->send(413, "application/json", R"({"error":"Body too large"})");
+            if (bodyOwner != request || bodyLength != length)
+                return request->send(503, "application/json", R"({"error":"Busy, try again"})");
             return handleRequestWithBody(request);
+        }
 
-        if (url.indexOf("/state") > 0 && request->_tempObject == nullptr)
+        if (contains(url, "/state"))
             return request->send(400, "application/json", R"({"error":"Empty or missing body"})");
 
-        if (const int pos = url.indexOf("lights"); pos > 0)
+        if (const auto pos = url.find("lights"); pos != std::string_view::npos && pos > 0)
             return handleLightsRequest(request, url, pos);
 
         request->send(404, "application/json", R"({"error":"Device not found"})");
     }
 
-    void handleRequestWithBody(AsyncWebServerRequest* request) const
+    // The body stays in the buffer until the state update is traced; nothing else runs on async_tcp meanwhile.
+    void handleRequestWithBody(AsyncWebServerRequest* request)
     {
-        const String& url = request->url();
-        ESP_LOGD(LOG_TAG, "Request body: %s", static_cast<char*>(request->_tempObject));
-
-        JsonDocument doc;
-        const auto error = deserializeJson(doc, request->_tempObject);
-        free(request->_tempObject);
-        request->_tempObject = nullptr;
+        const auto url = urlOf(request);
+        const size_t length = bodyLength;
+        body[length] = '\0';
+        bodyOwner = nullptr;
+        ESP_LOGD(LOG_TAG, "Request body: %s", body.data());
+
+        Json::PooledDocument doc;
+        const auto error = deserializeJson(doc, static_cast<const char*>(body.data()), length);
         if (error)
         {
             ESP_LOGW(LOG_TAG, "JSON parse error: %s", error.c_str());
@@ -131,10 +171,11 @@ private:
             return;
         }
 
-        if (url.indexOf("state") > 0)
+        const auto lights = url.find("lights");
+        if (contains(url, "state") && lights != std::string_view::npos)
         {
-            const uint32_t devId = url.substring(url.indexOf("lights") + 7).toInt();
-            const unsigned idx = AsyncEspAlexaDevice::decodeLightKey(devId);
+            const auto devId = lightKeyAt(url, lights);
+            const unsigned idx = devId ? AsyncEspAlexaDevice::decodeLightKey(*devId) : devices.size();
             if (idx >= devices.size())
             {
                 request->send(404, "application/json", R"({"error":"Device not found"})");
@@ -146,21 +187,25 @@ private:
                 request->send(404, "application/json", R"({"error":"Device null"})");
                 return;
             }
+            Power::CommandScope power;
+            Trace::Scope trace(Trace::Source::Hue, reinterpret_cast<const uint8_t*>(body.data()), length,
+                               static_cast<uint8_t>(idx));
             dev->callBeforeStateUpdateCallback();
             dev->handleStateUpdate(doc.as<JsonObject>());
             dev->callAfterStateUpdateCallback();
 
             char buf[64];
-            snprintf(buf, sizeof(buf), R"([{"success":{"/lights/%lu/state/": true}}])", devId);
+            snprintf(buf, sizeof(buf), R"([{"success":{"/lights/%lu/state/": true}}])", *devId);
             request->send(200, "application/json", buf);
         }
     }
 
-    void handleLightsRequest(AsyncWebServerRequest* request, const String& url, const int pos) const
+    void handleLightsRequest(AsyncWebServerRequest* request, const std::string_view url, const size_t pos) const
     {
-        const int devId = url.substring(pos + 7).toInt();
-        if (devId == 0) return handleListDeviceRequest(request);
-        const auto idx = AsyncEspAlexaDevice::decodeLightKey(devId);
+        if (pos + 7 >= url.size()) return handleListDeviceRequest(request);
+        const auto devId = lightKeyAt(url, pos);
+        if (devId == 0u) return handleListDeviceRequest(request);
+        const auto idx = devId ? AsyncEspAlexaDevice::decodeLightKey(*devId) : devices.size();
         return idx < devices.size()
                    ? handleGetDeviceStateRequest(request, idx)
                    : request->send(404, "application/json", R"({"error":"Device not found"})");
@@ -168,11 +213,13 @@ private:
 
     void handleListDeviceRequest(AsyncWebServerRequest* request) const
     {
-        const auto response = new AsyncJsonResponse();
+        const auto response = new Json::PooledResponse();
         const auto& obj = response->getRoot().as<JsonObject>();
+        char key[11];
         for (int i = 0; i < devices.size(); i++)
         {
-            devices[i]->toJson(obj[String(AsyncEspAlexaDevice::encodeLightKey(i))].to<JsonObject>());
+            snprintf(key, sizeof(key), "%lu", AsyncEspAlexaDevice::encodeLightKey(i));
+            devices[i]->toJson(obj[key].to<JsonObject>());
         }
 #if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_DEBUG
         char buf[1024];
@@ -185,7 +232,7 @@ private:
 
     void handleGetDeviceStateRequest(AsyncWebServerRequest* request, const uint8_t idx) const
     {
-        const auto response = new AsyncJsonResponse();
+        const auto response = new Json::PooledResponse();
         devices[idx]->toJson(response->getRoot().to<JsonObject>());
 #if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_DEBUG
         char buf[1024];
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <esp_cpu.h>
+
+#include "delegate.hh"
+
+/**
+ * Registry of small kernels timed with the CPU cycle counter, so cache,
+ * flash wait state and FPU costs can be measured on the device itself and
+ * compared with the same kernels built for the host (host/bench_host.cc).
+ * Only compiled in with CONFIG_RGBW_CTRL_BENCHMARKS.
+ */
+namespace Bench
+{
+    static constexpr uint8_t MAX_KERNELS = 16;
+
+    // Where a kernel runs; kernels touching state owned by the main loop (the outputs) must run on it.
+    enum class Context : uint8_t
+    {
+        Worker,
+        Loop,
+    };
+
+    using Kernel = Delegate<void()>;
+    using CycleCounter = Delegate<uint32_t()>;
+
+    struct Result
+    {
+        const char* name = nullptr;
+        uint16_t iterations = 0;
+        uint32_t minCycles = 0;
+        uint32_t meanCycles = 0;
+        uint32_t maxCycles = 0;
+    };
+
+    /**
+     * Registers a kernel run `iterations` times per benchmark run, after one
+     * untimed warm-up call. Returns false once MAX_KERNELS are registered.
+     */
+    bool add(const char* name, const Kernel& kernel, uint16_t iterations, Context context = Context::Worker);
+
+    /**
+     * Runs every kernel on the calling task, whatever its context, and stores
+     * the results. Only for the host, whose single thread is the loop; it
+     * passes its own counter since its esp_cpu_get_cycle_count() follows the
+     * virtual clock.
+     */
+    void runAll(const CycleCounter& counter = [] { return esp_cpu_get_cycle_count(); });
+
+    /**
+     * Runs the worker kernels on the worker pool, then the loop kernels from
+     * handle(). Returns false when a run is already in progress or the pool
+     * is full.
+     */
+    bool start();
+
+    // Runs the loop kernels once the worker kernels of a started run are done. Main loop only.
+    void handle();
+
+    [[nodiscard]] bool isRunning();
+    [[nodiscard]] uint32_t getRuns();
+
+    /**
+     * Copies the results of the last run in registration order and returns how many were copied.
+     */
+    uint8_t getResults(std::array<Result, MAX_KERNELS>& out);
+
+    // Keeps the compiler from discarding a kernel's result.
+    template <typename T>
+    void keep(const T& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "bench.hh"
+#include "http_manager.hh"
+
+namespace Bench
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::BENCH;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                bool started = false;
+                if (request->hasParam("run"))
+                    started = start();
+
+                const auto cpuMhz = static_cast<uint16_t>(getCpuFrequencyMhz());
+                std::array<Result, MAX_KERNELS> results;
+                const auto count = getResults(results);
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["running"] = isRunning();
+                if (request->hasParam("run")) root["started"] = started;
+                root["runs"] = getRuns();
+                root["cpuMhz"] = cpuMhz;
+                const auto kernels = root["kernels"].to<JsonArray>();
+                for (uint8_t i = 0; i < count; ++i)
+                {
+                    const auto& result = results[i];
+                    const auto entry = kernels.add<JsonObject>();
+                    entry["name"] = result.name;
+                    entry["iterations"] = result.iterations;
+                    entry["minCycles"] = result.minCycles;
+                    entry["meanCycles"] = result.meanCycles;
+                    entry["maxCycles"] = result.maxCycles;
+                    entry["meanUs"] = toMicros(result.meanCycles, cpuMhz);
+                }
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+
+        private:
+            static float toMicros(const uint32_t cycles, const uint16_t cpuMhz)
+            {
+                return cpuMhz > 0 ? static_cast<float>(cycles) / static_cast<float>(cpuMhz) : 0.0f;
+            }
+        };
+    };
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <type_traits>
+#include <esp_log.h>
+#include <sdkconfig.h>
+
+/**
+ * Deferred logger for hot paths. A call stores the timestamp, the address of
+ * the format string and up to MAX_ARGS arguments in a lock-free RAM ring and
+ * returns; nothing is formatted until the ring is read through /system/log
+ * or printed by the drain task. It can be called from any task or ISR.
+ *
+ * Arguments must be integers, characters or pointers. %s is only allowed for
+ * strings with static storage: the pointer is followed when the entry is
+ * formatted, possibly long after the call.
+ */
+namespace BinaryLog
+{
+    enum class Tag : uint8_t
+    {
+        Controller,
+        Light,
+        Alexa,
+        WebSocket,
+        COUNT
+    };
+
+    static constexpr auto TAG_COUNT = static_cast<uint8_t>(Tag::COUNT);
+    static constexpr uint16_t CAPACITY = CONFIG_RGBW_CTRL_BINARY_LOG_ENTRIES;
+    static constexpr uint8_t MAX_ARGS = 6;
+    static constexpr size_t MAX_MESSAGE_LENGTH = 128;
+
+    using Arg = uintptr_t;
+
+    // The timestamp leads, so the 64-bit field needs no padding in front of it.
+    struct Entry
+    {
+        int64_t timestampUs = 0;
+        uint32_t sequence = 0;
+        const char* format = nullptr;
+        Tag tag = Tag::Controller;
+        esp_log_level_t level = ESP_LOG_NONE;
+        std::array<Arg, MAX_ARGS> args = {};
+    };
+
+    struct Level
+    {
+        std::atomic<esp_log_level_t> value = ESP_LOG_INFO;
+    };
+
+    inline std::array<Level, TAG_COUNT> levels;
+
+    [[nodiscard]] inline bool isEnabled(const Tag tag, const esp_log_level_t level)
+    {
+        return level <= levels[static_cast<uint8_t>(tag)].value.load(std::memory_order_relaxed);
+    }
+
+    // Starts the drain task that prints new entries to the console, if it is enabled.
+    void begin();
+
+    void setLevel(Tag tag, esp_log_level_t level);
+    [[nodiscard]] esp_log_level_t getLevel(Tag tag);
+    [[nodiscard]] const char* tagName(Tag tag);
+    [[nodiscard]] std::optional<Tag> findTag(const char* name);
+
+    void write(Tag tag, esp_log_level_t level, const char* format, const Arg* args, uint8_t count);
+
+    template <typename... Args>
+    void log(const Tag tag, const esp_log_level_t level, const char* format, const Args... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Too many arguments for a binary log entry");
+        static_assert(((std::is_integral_v<Args> || std::is_enum_v<Args> || std::is_pointer_v<Args>) && ...),
+                      "Binary log arguments must be integers, enums or pointers");
+        static_assert(((sizeof(Args) <= sizeof(Arg)) && ...), "Binary log arguments must fit in a pointer");
+        if (!isEnabled(tag, level)) return;
+        const Arg packed[sizeof...(Args) + 1] = {(Arg)args..., 0}; // NOLINT: integers and pointers alike
+        write(tag, level, format, packed, sizeof...(Args));
+    }
+
+    /**
+     * Sequence number the next entry will get. Entries older than
+     * head - CAPACITY have been overwritten.
+     */
+    [[nodiscard]] uint32_t getHead();
+
+    /**
+     * Copies up to `max` entries starting at `cursor`, oldest first, and
+     * advances `cursor` past them. Entries overwritten before they could be
+     * read are skipped and added to `dropped`.
+     */
+    uint16_t read(uint32_t& cursor, Entry* out, uint16_t max, uint32_t& dropped);
+
+    size_t format(const Entry& entry, char* buffer, size_t size);
+
+    [[nodiscard]] char levelLetter(esp_log_level_t level);
+    [[nodiscard]] std::optional<esp_log_level_t> levelFromLetter(char letter);
+}
+
+// The dead printf call lets the compiler check the format against the arguments.
+#define BINARY_LOG(tag, level, format, ...)                                     \
+    do                                                                          \
+    {                                                                           \
+        if (false) printf(format __VA_OPT__(,) __VA_ARGS__);                    \
+        BinaryLog::log(tag, level, format __VA_OPT__(,) __VA_ARGS__);           \
+    } while (false)
+
+#define BINARY_LOGE(tag, format, ...) BINARY_LOG(tag, ESP_LOG_ERROR, format __VA_OPT__(,) __VA_ARGS__)
+#define BINARY_LOGW(tag, format, ...) BINARY_LOG(tag, ESP_LOG_WARN, format __VA_OPT__(,) __VA_ARGS__)
+#define BINARY_LOGI(tag, format, ...) BINARY_LOG(tag, ESP_LOG_INFO, format __VA_OPT__(,) __VA_ARGS__)
+#define BINARY_LOGD(tag, format, ...) BINARY_LOG(tag, ESP_LOG_DEBUG, format __VA_OPT__(,) __VA_ARGS__)
+#define BINARY_LOGV(tag, format, ...) BINARY_LOG(tag, ESP_LOG_VERBOSE, format __VA_OPT__(,) __VA_ARGS__)
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "binary_log.hh"
+#include "http_manager.hh"
+
+namespace BinaryLog
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+            // Keeps a response within a single pooled document; poll again with ?since=<next> for the rest.
+            static constexpr uint16_t MAX_ENTRIES = 16;
+
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_LOG;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                if (request->hasParam("tag") && request->hasParam("level"))
+                {
+                    const auto tag = findTag(request->getParam("tag")->value().c_str());
+                    const auto& letter = request->getParam("level")->value();
+                    const auto level = letter.length() == 1 ? levelFromLetter(letter[0]) : std::nullopt;
+                    if (!tag || !level)
+                    {
+                        request->send(400, "text/plain", "Unknown tag or level");
+                        return;
+                    }
+                    setLevel(*tag, *level);
+                }
+
+                const auto head = getHead();
+                uint32_t cursor = head > CAPACITY ? head - CAPACITY : 0;
+                if (request->hasParam("since"))
+                    cursor = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+                uint32_t dropped = 0;
+                std::array<Entry, MAX_ENTRIES> entries;
+                const auto count = read(cursor, entries.data(), MAX_ENTRIES, dropped);
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["head"] = head;
+                root["next"] = cursor;
+                root["dropped"] = dropped;
+
+                const auto levelsObject = root["levels"].to<JsonObject>();
+                for (uint8_t i = 0; i < TAG_COUNT; ++i)
+                {
+                    const auto tag = static_cast<Tag>(i);
+                    const char letter[2] = {levelLetter(getLevel(tag)), '\0'};
+                    levelsObject[tagName(tag)] = letter;
+                }
+
+                char message[MAX_MESSAGE_LENGTH];
+                const auto entriesArray = root["entries"].to<JsonArray>();
+                for (uint16_t i = 0; i < count; ++i)
+                {
+                    const auto& entry = entries[i];
+                    format(entry, message, sizeof(message));
+                    const char letter[2] = {levelLetter(entry.level), '\0'};
+                    const auto object = entriesArray.add<JsonObject>();
+                    object["seq"] = entry.sequence;
+                    object["us"] = entry.timestampUs;
+                    object["level"] = letter;
+                    object["tag"] = tagName(entry.tag);
+                    object["message"] = message;
+                }
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
+}
@@ -7,6 +7,7 @@
 #include "alexa_integration.hh"
 #include "device_manager.hh"
 #include "http_manager.hh"
+#include "load_shedding.hh"
 
 namespace BLE
 {
@@ -16,6 +17,8 @@ namespace BLE
         static constexpr auto BLE_TIMEOUT_MS = 30000;
 
         unsigned long bluetoothAdvertisementTimeout = 0;
+        // A start requested while the heap was critically low; picked up by handle() once it recovers.
+        bool startDeferred = false;
 
         const std::array<uint8_t, 4>& advertisementData;
         const DeviceManager& deviceManager;
@@ -37,6 +40,13 @@ namespace BLE
 
         void start()
         {
+            if (server == nullptr && LoadShedding::shed(LoadShedding::Load::BleStart))
+            {
+                if (!startDeferred) ESP_LOGW(LOG_TAG, "Heap too low, deferring bluetooth start");
+                startDeferred = true;
+                return;
+            }
+            startDeferred = false;
             bluetoothAdvertisementTimeout = millis() + BLE_TIMEOUT_MS;
             if (server != nullptr) return;
 
@@ -55,11 +65,14 @@ namespace BLE
 
         void handle(const unsigned long now)
         {
+            if (startDeferred && !LoadShedding::isShedding(LoadShedding::Load::BleStart))
+                start();
             handleAdvertisementTimeout(now);
         }
 
         void stop()
         {
+            startDeferred = false;
             if (server == nullptr) return;
             ESP_LOGI(LOG_TAG, "Disconnecting all BLE clients");
             for (const auto& connInfo : this->server->getPeerDevices())
@@ -4,6 +4,9 @@
 
 namespace BLE
 {
+    // The largest value an attribute can hold; longer characteristic values are rejected.
+    static constexpr size_t MAX_ATTRIBUTE_LENGTH = 512;
+
     enum class Status :uint8_t
     {
         OFF,
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * esp_timer timestamps of the startup phases, so time to first light and
+ * time to the first HTTP response can be read back from a running device.
+ * Each phase keeps the first time it was marked.
+ */
+namespace BootTimeline
+{
+    enum class Phase : uint8_t
+    {
+        Setup,
+        Tasks,
+        Outputs,
+        WiFi,
+        Connect,
+        Restore,
+        Alexa,
+        WebServer,
+        SetupDone,
+        FirstLoop,
+        GotIp,
+        FirstRequest,
+        FileSystem,
+        COUNT
+    };
+
+    static constexpr auto PHASE_COUNT = static_cast<uint8_t>(Phase::COUNT);
+    static constexpr int64_t NOT_REACHED = -1;
+
+    void mark(Phase phase);
+
+    // Microseconds since boot when the phase was first marked, or NOT_REACHED.
+    [[nodiscard]] int64_t get(Phase phase);
+
+    [[nodiscard]] const char* phaseName(Phase phase);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "boot_timeline.hh"
+#include "http_manager.hh"
+#include "warm_restart.hh"
+
+namespace BootTimeline
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_BOOT;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                const auto boot = WarmRestart::getBootTiming();
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["warm"] = boot.warm;
+                root["resetReason"] = static_cast<int>(boot.resetReason);
+                root["lightsOnUs"] = boot.lightsOnUs;
+
+                // Phases not reached yet, such as gotIp while still associating, are left out.
+                const auto phases = root["phases"].to<JsonArray>();
+                for (uint8_t i = 0; i < PHASE_COUNT; ++i)
+                {
+                    const auto phase = static_cast<Phase>(i);
+                    const auto timestamp = get(phase);
+                    if (timestamp == NOT_REACHED) continue;
+                    const auto entry = phases.add<JsonObject>();
+                    entry["name"] = phaseName(phase);
+                    entry["us"] = timestamp;
+                }
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+namespace CallbackBudget
+{
+    // Contexts owned by other stacks; work done there delays their own processing.
+    enum class Context : uint8_t
+    {
+        AsyncTcp,
+        NimBLE,
+        WiFiEvent,
+        // The ESP-NOW receive callback, which runs on the Wi-Fi task.
+        EspNow,
+        COUNT
+    };
+
+    static constexpr auto CONTEXT_COUNT = static_cast<uint8_t>(Context::COUNT);
+    static constexpr uint8_t MAX_VIOLATIONS = 16;
+    static constexpr int16_t NO_DETAIL = -1;
+
+    struct Violation
+    {
+        uint32_t timestampMs = 0;
+        uint32_t durationUs = 0;
+        const char* handler = nullptr;
+        int16_t detail = NO_DETAIL;
+        Context context = Context::AsyncTcp;
+    };
+
+    struct ContextStats
+    {
+        uint32_t calls = 0;
+        uint32_t violations = 0;
+        uint32_t maxUs = 0;
+        const char* maxHandler = nullptr;
+    };
+
+    inline std::atomic<uint32_t> budgetUs = CONFIG_RGBW_CTRL_CALLBACK_BUDGET_US;
+
+    // Safe from any task; only counts, logging is left to handle().
+    void record(Context context, const char* handler, int16_t detail, uint32_t durationUs);
+    void reset();
+
+    /**
+     * Logs the violations recorded since the last call. Call it from the main
+     * loop, so a slow callback is not made slower by writing to the console.
+     */
+    void handle();
+
+    [[nodiscard]] const char* contextName(Context context);
+    [[nodiscard]] ContextStats getStats(Context context);
+
+    /**
+     * Copies the recorded violations, newest first, and returns how many were copied.
+     */
+    uint8_t getViolations(std::array<Violation, MAX_VIOLATIONS>& out);
+
+    /**
+     * Times a handler running inside another stack's callback and records it
+     * as a violation when it exceeds the budget. `detail` is an optional
+     * handler-specific code such as a message type.
+     */
+    class Scope
+    {
+        const int64_t start = esp_timer_get_time();
+        const char* handler;
+        const int16_t detail;
+        const Context context;
+
+    public:
+        Scope(const Context context, const char* handler, const int16_t detail = NO_DETAIL)
+            : handler(handler), detail(detail), context(context)
+        {
+        }
+
+        ~Scope()
+        {
+            record(context, handler, detail, static_cast<uint32_t>(esp_timer_get_time() - start));
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+}
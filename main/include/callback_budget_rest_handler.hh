@@ -0,0 +1,72 @@
+#pragma once
+
+#include "callback_budget.hh"
+#include "http_manager.hh"
+
+namespace CallbackBudget
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_CALLBACKS;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                if (request->hasParam("budgetUs"))
+                {
+                    if (const auto value = request->getParam("budgetUs")->value().toInt(); value > 0)
+                        budgetUs = static_cast<uint32_t>(value);
+                }
+                if (request->hasParam("reset"))
+                    reset();
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["budgetUs"] = budgetUs.load();
+
+                const auto contexts = root["contexts"].to<JsonArray>();
+                for (uint8_t i = 0; i < CONTEXT_COUNT; ++i)
+                {
+                    const auto context = static_cast<Context>(i);
+                    const auto stats = getStats(context);
+                    const auto entry = contexts.add<JsonObject>();
+                    entry["name"] = contextName(context);
+                    entry["calls"] = stats.calls;
+                    entry["violations"] = stats.violations;
+                    entry["maxUs"] = stats.maxUs;
+                    if (stats.maxHandler) entry["maxHandler"] = stats.maxHandler;
+                }
+
+                std::array<Violation, MAX_VIOLATIONS> violations;
+                const auto count = getViolations(violations);
+                const auto recent = root["violations"].to<JsonArray>();
+                for (uint8_t i = 0; i < count; ++i)
+                {
+                    const auto& violation = violations[i];
+                    const auto entry = recent.add<JsonObject>();
+                    entry["timestamp"] = violation.timestampMs;
+                    entry["context"] = contextName(violation.context);
+                    entry["handler"] = violation.handler;
+                    if (violation.detail != NO_DETAIL) entry["detail"] = violation.detail;
+                    entry["durationUs"] = violation.durationUs;
+                }
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
+}
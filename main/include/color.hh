@@ -7,5 +7,6 @@ enum class Color : uint8_t
     Red,
     Green,
     Blue,
-    White
+    White,
+    WarmWhite
 };
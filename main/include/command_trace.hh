@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#include "delegate.hh"
+
+/**
+ * Record of the commands that reached the controller, kept in a RAM ring so a
+ * misbehaving sequence can be downloaded from /system/trace and replayed
+ * against the host build (host/trace_replay.cc).
+ */
+namespace Trace
+{
+    enum class Source : uint8_t
+    {
+        EspNow,
+        WebSocket,
+        // Writes to the output color characteristic.
+        Ble,
+        // Hue state PUTs from Alexa; the channel is the light index.
+        Hue,
+        COUNT
+    };
+
+    static constexpr auto SOURCE_COUNT = static_cast<uint8_t>(Source::COUNT);
+    static constexpr uint16_t CAPACITY = CONFIG_RGBW_CTRL_COMMAND_TRACE_RECORDS;
+    static constexpr uint8_t MAX_PAYLOAD = 96;
+    static constexpr uint32_t MAGIC = 0x43525452; // "RTRC"
+    static constexpr uint8_t FORMAT_VERSION = 1;
+
+    enum Flags : uint8_t
+    {
+        TRUNCATED = 0x01,
+    };
+
+#pragma pack(push, 1)
+    // Start of a download, followed by `count` records, oldest first.
+    struct FileHeader
+    {
+        uint32_t magic = MAGIC;
+        uint8_t version = FORMAT_VERSION;
+        uint8_t maxPayload = MAX_PAYLOAD;
+        uint16_t count = 0;
+        // Records overwritten or skipped since the trace was cleared.
+        uint32_t dropped = 0;
+    };
+
+    // On the wire a record is this header followed by `length` payload bytes.
+    struct RecordHeader
+    {
+        uint64_t timestampUs = 0;
+        uint32_t durationUs = 0;
+        // Output state version once the command was handled.
+        uint32_t stateVersion = 0;
+        Source source = Source::EspNow;
+        uint8_t channel = 0;
+        uint8_t flags = 0;
+        uint8_t length = 0;
+    };
+#pragma pack(pop)
+
+    struct Stats
+    {
+        uint16_t count = 0;
+        uint32_t recorded = 0;
+        uint32_t dropped = 0;
+        size_t downloadSize = 0;
+    };
+
+    // Off by default; the checks in Scope are a single relaxed load while off.
+    inline std::atomic<bool> recording = false;
+
+    void setStateVersionSource(const Delegate<uint32_t()>& source);
+
+    void record(Source source, uint8_t channel, const uint8_t* data, size_t len, uint32_t durationUs);
+    void clear();
+
+    [[nodiscard]] const char* sourceName(Source source);
+    [[nodiscard]] Stats getStats();
+
+    /**
+     * A download pauses recording until endDownload() so the bytes served by
+     * read() stay consistent. beginDownload() returns the download size.
+     */
+    size_t beginDownload();
+    size_t read(size_t offset, uint8_t* out, size_t len);
+    void endDownload();
+
+    /**
+     * Times a command handler and records the command once it returns, so the
+     * record carries the state the command produced. `data` must stay valid
+     * for the lifetime of the scope.
+     */
+    class Scope
+    {
+        const int64_t start;
+        const uint8_t* data;
+        const size_t len;
+        const Source source;
+        const uint8_t channel;
+
+    public:
+        Scope(const Source source, const uint8_t* data, const size_t len, const uint8_t channel = 0)
+            : start(recording.load(std::memory_order_relaxed) ? esp_timer_get_time() : -1),
+              data(data), len(len), source(source), channel(channel)
+        {
+        }
+
+        ~Scope()
+        {
+            if (start < 0) return;
+            record(source, channel, data, len, static_cast<uint32_t>(esp_timer_get_time() - start));
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+}
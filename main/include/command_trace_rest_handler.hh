@@ -0,0 +1,84 @@
+#pragma once
+
+#include "command_trace.hh"
+#include "http_manager.hh"
+
+namespace Trace
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        // Streams the ring straight out of RAM, one TCP window at a time.
+        class DownloadResponse final : public AsyncAbstractResponse
+        {
+        public:
+            DownloadResponse()
+            {
+                _code = 200;
+                setContentType("application/octet-stream");
+                _contentLength = beginDownload();
+            }
+
+            ~DownloadResponse() override
+            {
+                endDownload();
+            }
+
+            [[nodiscard]] bool _sourceValid() const override
+            {
+                return true;
+            }
+
+            size_t _fillBuffer(uint8_t* data, const size_t len) override
+            {
+                return read(_sentLength, data, len);
+            }
+        };
+
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_TRACE;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                if (request->hasParam("format") && request->getParam("format")->value() == "binary")
+                {
+                    const auto response = new DownloadResponse();
+                    response->addHeader("Content-Disposition", "attachment; filename=\"trace.bin\"");
+                    response->addHeader("Cache-Control", "no-store");
+                    request->send(response);
+                    return;
+                }
+                if (request->hasParam("recording"))
+                    recording = request->getParam("recording")->value().toInt() != 0;
+                if (request->hasParam("clear"))
+                    clear();
+
+                const auto stats = getStats();
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["recording"] = recording.load();
+                root["capacity"] = CAPACITY;
+                root["maxPayload"] = MAX_PAYLOAD;
+                root["count"] = stats.count;
+                root["recorded"] = stats.recorded;
+                root["dropped"] = stats.dropped;
+                root["downloadSize"] = stats.downloadSize;
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <Arduino.h>
+#include <array>
 #include <optional>
+#include <sdkconfig.h>
+
+#include "color.hh"
 
 namespace ControllerHardware
 {
@@ -48,20 +52,149 @@ namespace ControllerHardware
                 constexpr auto TX = GPIO_NUM_1;
             }
         }
+
+        // Bus of the PWM expanders on the expander board revision.
+        namespace I2c
+        {
+            constexpr auto SDA = GPIO_NUM_23;
+            constexpr auto SCL = GPIO_NUM_22;
+        }
+    }
+
+    struct OutputChannel
+    {
+        gpio_num_t pin;
+        uint8_t pwmChannel;
+        Color color;
+        uint8_t zone;
+        // Parameter name in /output/color and key of the channel's Alexa device name in NVS.
+        const char* key;
+        // 0 for LEDC; otherwise the 1-based PCA9685 expander, and pwmChannel is the expander's channel.
+        uint8_t expander = 0;
+    };
+
+    template <size_t Channels>
+    struct BoardProfile
+    {
+        const char* name;
+        uint8_t zones;
+        std::array<OutputChannel, Channels> outputs;
+    };
+
+    /**
+     * Output layouts the firmware can be built for. The profile is chosen in
+     * menuconfig; everything sized by the number of outputs takes it from
+     * OUTPUT_COUNT, so a layout has no cost at runtime.
+     */
+    namespace Profile
+    {
+        inline constexpr BoardProfile<4> RGBW{
+            "rgbw", 1, {{
+                {Pin::Output::RED, 3, Color::Red, 0, "r"},
+                {Pin::Output::GREEN, 4, Color::Green, 0, "g"},
+                {Pin::Output::BLUE, 5, Color::Blue, 0, "b"},
+                {Pin::Output::WHITE, 6, Color::White, 0, "w"},
+            }}
+        };
+
+        // Warm white is driven from the free pin of header H1; the rotary encoder keeps the others.
+        inline constexpr BoardProfile<5> RGBCCT{
+            "rgbcct", 1, {{
+                {Pin::Output::RED, 3, Color::Red, 0, "r"},
+                {Pin::Output::GREEN, 4, Color::Green, 0, "g"},
+                {Pin::Output::BLUE, 5, Color::Blue, 0, "b"},
+                {Pin::Output::WHITE, 6, Color::White, 0, "w"},
+                {Pin::Header::H1::P3, 7, Color::WarmWhite, 0, "ww"},
+            }}
+        };
+
+        // Board revision with a second RGBW driver stage on otherwise unused GPIOs.
+        inline constexpr BoardProfile<8> DUAL_RGBW{
+            "dual_rgbw", 2, {{
+                {Pin::Output::RED, 3, Color::Red, 0, "r"},
+                {Pin::Output::GREEN, 4, Color::Green, 0, "g"},
+                {Pin::Output::BLUE, 5, Color::Blue, 0, "b"},
+                {Pin::Output::WHITE, 6, Color::White, 0, "w"},
+                {GPIO_NUM_22, 7, Color::Red, 1, "r2"},
+                {GPIO_NUM_23, 8, Color::Green, 1, "g2"},
+                {GPIO_NUM_32, 9, Color::Blue, 1, "b2"},
+                {GPIO_NUM_14, 10, Color::White, 1, "w2"},
+            }}
+        };
+
+        // Board revision with a PCA9685 instead of the LEDC drivers: four RGBW zones on one expander.
+        inline constexpr BoardProfile<16> PCA9685{
+            "pca9685", 4, {{
+                {GPIO_NUM_NC, 0, Color::Red, 0, "r", 1},
+                {GPIO_NUM_NC, 1, Color::Green, 0, "g", 1},
+                {GPIO_NUM_NC, 2, Color::Blue, 0, "b", 1},
+                {GPIO_NUM_NC, 3, Color::White, 0, "w", 1},
+                {GPIO_NUM_NC, 4, Color::Red, 1, "r2", 1},
+                {GPIO_NUM_NC, 5, Color::Green, 1, "g2", 1},
+                {GPIO_NUM_NC, 6, Color::Blue, 1, "b2", 1},
+                {GPIO_NUM_NC, 7, Color::White, 1, "w2", 1},
+                {GPIO_NUM_NC, 8, Color::Red, 2, "r3", 1},
+                {GPIO_NUM_NC, 9, Color::Green, 2, "g3", 1},
+                {GPIO_NUM_NC, 10, Color::Blue, 2, "b3", 1},
+                {GPIO_NUM_NC, 11, Color::White, 2, "w3", 1},
+                {GPIO_NUM_NC, 12, Color::Red, 3, "r4", 1},
+                {GPIO_NUM_NC, 13, Color::Green, 3, "g4", 1},
+                {GPIO_NUM_NC, 14, Color::Blue, 3, "b4", 1},
+                {GPIO_NUM_NC, 15, Color::White, 3, "w4", 1},
+            }}
+        };
+    }
+
+#if defined(CONFIG_RGBW_CTRL_BOARD_RGBCCT)
+    inline constexpr auto& BOARD = Profile::RGBCCT;
+#elif defined(CONFIG_RGBW_CTRL_BOARD_DUAL_RGBW)
+    inline constexpr auto& BOARD = Profile::DUAL_RGBW;
+#elif defined(CONFIG_RGBW_CTRL_BOARD_PCA9685)
+    inline constexpr auto& BOARD = Profile::PCA9685;
+#else
+    inline constexpr auto& BOARD = Profile::RGBW;
+#endif
+
+    static constexpr size_t OUTPUT_COUNT = BOARD.outputs.size();
+    static constexpr uint8_t ZONE_COUNT = BOARD.zones;
+
+    constexpr uint8_t countExpanders()
+    {
+        uint8_t count = 0;
+        for (const auto& output : BOARD.outputs)
+            if (output.expander > count) count = output.expander;
+        return count;
+    }
+
+    static constexpr uint8_t EXPANDER_COUNT = countExpanders();
+
+    // Index of the output that drives `color` in `zone`, if the board has one.
+    constexpr std::optional<size_t> findOutput(const Color color, const uint8_t zone = 0)
+    {
+        for (size_t i = 0; i < OUTPUT_COUNT; ++i)
+            if (BOARD.outputs[i].color == color && BOARD.outputs[i].zone == zone) return i;
+        return std::nullopt;
+    }
+
+    // Index of the last output driven by LEDC; boards with every output on an expander have none.
+    constexpr std::optional<size_t> findLastLedcOutput()
+    {
+        for (size_t i = OUTPUT_COUNT; i > 0; --i)
+            if (BOARD.outputs[i - 1].expander == 0) return i - 1;
+        return std::nullopt;
     }
 
-    inline std::optional<uint8_t> getPwmChannel(const gpio_num_t pin)
+    constexpr std::optional<uint8_t> getPwmChannel(const gpio_num_t pin)
     {
         switch (pin)
         {
         case Pin::BoardLed::RED: return 0;
         case Pin::BoardLed::GREEN: return 1;
         case Pin::BoardLed::BLUE: return 2;
-        case Pin::Output::RED: return 3;
-        case Pin::Output::GREEN: return 4;
-        case Pin::Output::BLUE: return 5;
-        case Pin::Output::WHITE: return 6;
-        default: return std::nullopt;
+        default: break;
         }
+        for (const auto& output : BOARD.outputs)
+            if (output.expander == 0 && output.pin == pin) return output.pwmChannel;
+        return std::nullopt;
     }
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Three pointers of capture keep a Delegate as small as std::function on the ESP32 (16 bytes).
+template <typename Signature, size_t Capacity = 3 * sizeof(void*)>
+class Delegate;
+
+/**
+ * Fixed-capacity replacement for std::function.
+ * The callable is stored inline and must be trivially copyable (function
+ * pointers, lambdas capturing pointers and scalars), so a Delegate never
+ * allocates, can be copied byte by byte (e.g. through a FreeRTOS queue) and
+ * costs a single indirect call to invoke.
+ */
+template <typename R, typename... Args, size_t Capacity>
+class Delegate<R(Args...), Capacity>
+{
+public:
+    static constexpr size_t CAPACITY = Capacity;
+    static constexpr size_t ALIGNMENT = alignof(void*);
+
+    Delegate() = default;
+
+    Delegate(std::nullptr_t) // NOLINT(google-explicit-constructor)
+    {
+    }
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Delegate> &&
+                                                      !std::is_same_v<std::decay_t<F>, std::nullptr_t>>>
+    Delegate(F&& callable) // NOLINT(google-explicit-constructor)
+    {
+        using Callable = std::decay_t<F>;
+        static_assert(std::is_invocable_r_v<R, Callable&, Args...>, "Callable does not match the signature");
+        static_assert(sizeof(Callable) <= CAPACITY, "Delegate capture does not fit the inline storage");
+        static_assert(alignof(Callable) <= ALIGNMENT, "Delegate capture is over-aligned");
+        static_assert(std::is_trivially_copyable_v<Callable>, "Delegate captures must be trivially copyable");
+        static_assert(std::is_trivially_destructible_v<Callable>, "Delegate captures must be trivially destructible");
+        new(storage.data()) Callable(std::forward<F>(callable));
+        invoker = [](void* data, Args... args) -> R
+        {
+            return (*static_cast<Callable*>(data))(std::forward<Args>(args)...);
+        };
+    }
+
+    R operator()(Args... args) const
+    {
+        return invoker(storage.data(), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const
+    {
+        return invoker != nullptr;
+    }
+
+private:
+    alignas(ALIGNMENT) mutable std::array<uint8_t, CAPACITY> storage = {};
+    R (*invoker)(void*, Args...) = nullptr;
+};
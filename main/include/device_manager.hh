@@ -9,8 +9,12 @@
 #include "ble_service.hh"
 #include "http_manager.hh"
 #include "state_json_filler.hh"
-#include "async_call.hh"
+#include "worker_pool.hh"
+#include "callback_budget.hh"
+#include "heap_accounting.hh"
+#include "pending_value.hh"
 #include "sensor.hh"
+#include "warm_restart.hh"
 
 class DeviceManager final : public BLE::Service, public StateJsonFiller, public HTTP::AsyncWebHandlerCreator
 {
@@ -33,6 +37,7 @@ private:
 
     mutable std::array<char, DEVICE_NAME_TOTAL_LENGTH> deviceName = {};
     ThrottledValue<uint32_t> heapNotificationThrottle{500};
+    PendingValue<std::array<char, DEVICE_NAME_TOTAL_LENGTH>> pendingDeviceName;
 
     unsigned long lastVoltageNotification = 0;
 
@@ -50,6 +55,11 @@ public:
         sendInputVoltageNotification(now);
     }
 
+    [[nodiscard]] uint32_t getInputMillivolts() const
+    {
+        return sensor.getRawMillivolts();
+    }
+
     char* getDeviceName() const
     {
         std::lock_guard lock(getDeviceNameMutex());
@@ -70,6 +80,23 @@ public:
         return deviceName;
     }
 
+    /**
+     * Schedules setDeviceName() on a worker: it writes NVS and reconnects Wi-Fi,
+     * which must not run inside BLE or WebSocket callbacks.
+     */
+    void requestDeviceName(const char* name, const size_t length)
+    {
+        if (!name || length == 0) return;
+        std::array<char, DEVICE_NAME_TOTAL_LENGTH> safeName = {};
+        std::memcpy(safeName.data(), name, std::min(length, static_cast<size_t>(DEVICE_NAME_MAX_LENGTH)));
+        if (!pendingDeviceName.put(safeName)) return;
+        if (!Async::post([this] { applyPendingDeviceName(); }))
+        {
+            pendingDeviceName.take();
+            ESP_LOGW(LOG_TAG, "Failed to schedule the device name change");
+        }
+    }
+
     void setDeviceName(const char* name) // NOLINT
     {
         if (!name || name[0] == '\0') return;
@@ -166,6 +193,12 @@ public:
     }
 
 private:
+    void applyPendingDeviceName()
+    {
+        if (const auto name = pendingDeviceName.take())
+            setDeviceName(name->data());
+    }
+
     static const char* loadDeviceName(char* deviceName)
     {
         Preferences prefs;
@@ -223,13 +256,15 @@ private:
     public:
         void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "RestartCallback::onWrite");
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
             if (pCharacteristic->getValue() == "RESTART_NOW")
             {
                 ESP_LOGW(LOG_TAG, "Device restart requested via BLE.");
-                async_call([this]
+                Async::post([]
                 {
                     esp_restart();
-                }, 2048, 50);
+                }, 50);
             }
             else
             {
@@ -256,17 +291,20 @@ private:
 
         void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "DeviceNameCallback::onWrite");
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
             const auto value = pCharacteristic->getValue();
             const auto data = value.data();
             const auto deviceName = reinterpret_cast<const char*>(data);
 
-            if (const auto length = pCharacteristic->getLength(); length == 0 || length > DEVICE_NAME_MAX_LENGTH)
+            const auto length = pCharacteristic->getLength();
+            if (length == 0 || length > DEVICE_NAME_MAX_LENGTH)
             {
                 ESP_LOGE(LOG_TAG, "Invalid device name length: %d", static_cast<int>(length));
                 return;
             }
 
-            deviceManager->setDeviceName(deviceName);
+            deviceManager->requestDeviceName(deviceName, length);
         }
     };
 
@@ -296,6 +334,8 @@ private:
 
         void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "InputVoltageCallback::onWrite");
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
             if (pCharacteristic->getValue().size() != sizeof(float))
             {
                 ESP_LOGE(LOG_TAG, "Invalid calibration factor size");
@@ -338,10 +378,10 @@ private:
         {
             request->onDisconnect([this]
             {
-                async_call([]
+                Async::post([]
                 {
                     esp_restart();
-                }, 2048, 0);
+                });
             });
             return sendMessageJsonResponse(request, "Restarting...");
         }
@@ -350,11 +390,12 @@ private:
         {
             request->onDisconnect([this]
             {
-                async_call([]
+                Async::post([]
                 {
+                    WarmRestart::invalidate();
                     nvs_flash_erase();
                     esp_restart();
-                }, 4096, 0);
+                });
             });
             return sendMessageJsonResponse(request, "Resetting to factory defaults...");
         }
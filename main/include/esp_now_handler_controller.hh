@@ -7,6 +7,10 @@
 #include <Preferences.h>
 #include <NimBLEServer.h>
 
+#include "callback_budget.hh"
+#include "heap_accounting.hh"
+#include "reflect.hh"
+
 namespace EspNow
 {
 #pragma pack(push, 1)
@@ -28,10 +32,17 @@ namespace EspNow
         {
             return name != other.name && address != other.address;
         }
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("name", &Device::name),
+                Reflect::field("address", &Device::address, Reflect::Format::mac),
+            };
+        }
     };
 
-    static_assert(sizeof(Device) == Device::NAME_TOTAL_LENGTH + Device::MAC_SIZE,
-                  "Unexpected EspNowDevice size");
+    static_assert(Reflect::checkLayout<Device>(), "Unexpected EspNowDevice size");
 
     struct DeviceData
     {
@@ -49,6 +60,14 @@ namespace EspNow
         {
             return deviceCount != other.deviceCount || devices != other.devices;
         }
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("deviceCount", &DeviceData::deviceCount),
+                Reflect::field("devices", &DeviceData::devices),
+            };
+        }
     };
 #pragma pack(pop)
 
@@ -57,8 +76,10 @@ namespace EspNow
         static constexpr auto LOG_TAG = "ControllerEspNowHandler";
 
         static constexpr auto PREFERENCES_NAME = "esp-now";
-        static constexpr auto PREFERENCES_COUNT_KEY = "devCount";
-        static constexpr auto PREFERENCES_DATA_KEY = "devData";
+        static constexpr auto PREFERENCES_KEY = "devices";
+        // Count and raw device array written by earlier firmware; read once and replaced on the next save.
+        static constexpr auto LEGACY_COUNT_KEY = "devCount";
+        static constexpr auto LEGACY_DATA_KEY = "devData";
 
         DeviceData deviceData = {};
 
@@ -118,18 +139,13 @@ namespace EspNow
             return std::nullopt;
         }
 
-        [[nodiscard]] std::vector<uint8_t> getDevicesBuffer()
+        static constexpr size_t DEVICES_BUFFER_SIZE = Reflect::wireSize<DeviceData>();
+        static_assert(Reflect::checkLayout<DeviceData>(), "DeviceData must match the BLE buffer layout");
+
+        [[nodiscard]] Reflect::Buffer<DeviceData> getDevicesBuffer() const
         {
             std::lock_guard lock(getMutex());
-            std::vector<uint8_t> buffer;
-            buffer.reserve(1 + deviceData.deviceCount * sizeof(Device));
-            buffer.push_back(deviceData.deviceCount);
-            for (const auto& [name, address] : deviceData.devices)
-            {
-                buffer.insert(buffer.end(), name.begin(), name.end());
-                buffer.insert(buffer.end(), address.begin(), address.end());
-            }
-            return buffer;
+            return Reflect::encode(deviceData);
         }
 
         void setDevicesBuffer(const uint8_t* data, const size_t length)
@@ -137,7 +153,8 @@ namespace EspNow
             if (!data || length < 1) return;
 
             const uint8_t count = data[0];
-            if (const size_t expectedSize = 1 + count * sizeof(Device);
+            constexpr auto deviceSize = Reflect::wireSize<Device>();
+            if (const size_t expectedSize = 1 + count * deviceSize;
                 length < expectedSize)
                 return;
 
@@ -145,12 +162,7 @@ namespace EspNow
             newData.deviceCount = std::min(count, DeviceData::MAX_DEVICES_PER_MESSAGE);
 
             for (uint8_t i = 0; i < newData.deviceCount; ++i)
-            {
-                const size_t offset = 1 + i * sizeof(Device);
-                std::copy_n(&data[offset], Device::NAME_TOTAL_LENGTH, newData.devices[i].name.begin());
-                std::copy_n(&data[offset + Device::NAME_TOTAL_LENGTH], Device::MAC_SIZE,
-                            newData.devices[i].address.begin());
-            }
+                Reflect::decode(&data[1 + i * deviceSize], newData.devices[i]);
 
             setDeviceData(newData);
         }
@@ -177,14 +189,7 @@ namespace EspNow
             std::lock_guard lock(getMutex());
             for (uint8_t i = 0; i < deviceData.deviceCount && i < DeviceData::MAX_DEVICES_PER_MESSAGE; ++i)
             {
-                const auto& [name, mac] = deviceData.devices[i];
-                char macStr[18];
-                snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-                         mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-                macStr[sizeof(macStr) - 1] = '\0';
-                const auto& obj = arr.add<JsonObject>();
-                obj["name"] = name.data();
-                obj["address"] = macStr;
+                Reflect::toJson(deviceData.devices[i], arr.add<JsonVariant>());
             }
         }
 
@@ -199,9 +204,9 @@ namespace EspNow
         {
             if (Preferences prefs; prefs.begin(PREFERENCES_NAME, false))
             {
-                const auto dataSize = deviceData.deviceCount * sizeof(Device);
-                prefs.putUInt(PREFERENCES_COUNT_KEY, deviceData.deviceCount);
-                prefs.putBytes(PREFERENCES_DATA_KEY, deviceData.devices.data(), dataSize);
+                Reflect::save(prefs, PREFERENCES_KEY, deviceData);
+                if (prefs.isKey(LEGACY_COUNT_KEY)) prefs.remove(LEGACY_COUNT_KEY);
+                if (prefs.isKey(LEGACY_DATA_KEY)) prefs.remove(LEGACY_DATA_KEY);
                 prefs.end();
                 ESP_LOGI(LOG_TAG, "Devices saved to Preferences");
             }
@@ -215,14 +220,15 @@ namespace EspNow
         {
             if (Preferences prefs; prefs.begin(PREFERENCES_NAME, true))
             {
-                deviceData.deviceCount = prefs.getUInt(PREFERENCES_COUNT_KEY, 0);
-                if (const auto dataSize = deviceData.deviceCount * sizeof(Device);
-                    prefs.getBytesLength(PREFERENCES_DATA_KEY) == dataSize)
+                if (Reflect::load(prefs, PREFERENCES_KEY, deviceData))
                 {
-                    deviceData.devices = {};
-                    prefs.getBytes(PREFERENCES_DATA_KEY, deviceData.devices.data(), dataSize);
+                    deviceData.deviceCount = std::min(deviceData.deviceCount, DeviceData::MAX_DEVICES_PER_MESSAGE);
                     ESP_LOGI(LOG_TAG, "Devices restored from Preferences");
                 }
+                else
+                {
+                    restoreLegacyDevices(prefs);
+                }
                 prefs.end();
             }
             else
@@ -231,6 +237,18 @@ namespace EspNow
             }
         }
 
+        void restoreLegacyDevices(Preferences& prefs)
+        {
+            deviceData.deviceCount = prefs.getUInt(LEGACY_COUNT_KEY, 0);
+            if (const auto dataSize = deviceData.deviceCount * sizeof(Device);
+                prefs.getBytesLength(LEGACY_DATA_KEY) == dataSize)
+            {
+                deviceData.devices = {};
+                prefs.getBytes(LEGACY_DATA_KEY, deviceData.devices.data(), dataSize);
+                ESP_LOGI(LOG_TAG, "Devices restored from the previous Preferences format");
+            }
+        }
+
         class EspNowDevicesCallback final : public NimBLECharacteristicCallbacks
         {
             ControllerHandler* espNowHandler;
@@ -243,6 +261,8 @@ namespace EspNow
 
             void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
             {
+                CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "EspNowDevicesCallback::onWrite");
+                HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
                 const auto value = pCharacteristic->getValue();
                 espNowHandler->setDevicesBuffer(value.data(), value.size());
             }
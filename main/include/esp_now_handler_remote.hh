@@ -10,6 +10,8 @@
 #include "ble_service.hh"
 #include "esp_now_handler.hh"
 #include "state_json_filler.hh"
+#include "callback_budget.hh"
+#include "heap_accounting.hh"
 
 namespace EspNow
 {
@@ -204,6 +206,8 @@ namespace EspNow
 
             void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
             {
+                CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "EspNowControllerCallback::onWrite");
+                HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
                 std::array<uint8_t, MAC_LENGTH> controllerAddress = {};
                 const auto value = pCharacteristic->getValue();
                 std::copy_n(value.begin(), value.size(), controllerAddress.begin());
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <sdkconfig.h>
+
+#include "reflect.hh"
+
+namespace HeapAccounting
+{
+    // Subsystems whose allocations are attributed while a Scope is active on the allocating task.
+    enum class Tag : uint8_t
+    {
+        Untagged,
+        WebSocket,
+        Alexa,
+        Ble,
+        Http,
+        WiFi,
+        EspNow,
+        COUNT
+    };
+
+    static constexpr auto TAG_COUNT = static_cast<uint8_t>(Tag::COUNT);
+    static constexpr uint8_t HISTORY_LENGTH = 60;
+    static constexpr uint32_t SAMPLE_INTERVAL_MS = 10000;
+
+    struct TagStats
+    {
+        uint32_t liveBytes = 0;
+        uint32_t peakBytes = 0;
+        uint32_t allocations = 0;
+        uint32_t frees = 0;
+    };
+
+    // Telemetry section; Reflect packs it when it is sent.
+    struct Summary
+    {
+        uint32_t freeHeap = 0;
+        uint32_t minimumFreeHeap = 0;
+        uint32_t largestFreeBlock = 0;
+        uint16_t lowHeapEvents = 0;
+        uint8_t low = false;
+        std::array<uint32_t, TAG_COUNT> liveBytes = {};
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("freeHeap", &Summary::freeHeap),
+                Reflect::field("minimumFreeHeap", &Summary::minimumFreeHeap),
+                Reflect::field("largestFreeBlock", &Summary::largestFreeBlock),
+                Reflect::field("lowHeapEvents", &Summary::lowHeapEvents),
+                Reflect::field("low", &Summary::low),
+                Reflect::field("liveBytes", &Summary::liveBytes),
+            };
+        }
+    };
+
+    struct History
+    {
+        std::array<uint32_t, HISTORY_LENGTH> largestFreeBlock = {};
+        uint8_t count = 0;
+    };
+
+    [[nodiscard]] constexpr bool isEnabled()
+    {
+#if CONFIG_HEAP_USE_HOOKS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Samples the largest free block and raises the low-heap event when the
+     * configured thresholds are crossed. Call it from the main loop.
+     */
+    void handle(unsigned long now);
+
+    [[nodiscard]] const char* tagName(Tag tag);
+    [[nodiscard]] TagStats getStats(Tag tag);
+    [[nodiscard]] Summary getSummary();
+    [[nodiscard]] History getHistory();
+    [[nodiscard]] uint16_t getLowHeapEvents();
+    // Tagged allocations that could not be tracked because the pointer table was full.
+    [[nodiscard]] uint32_t getUntrackedAllocations();
+
+    Tag setCurrentTag(Tag tag);
+
+    // Number of heap allocations made so far by the calling task.
+    [[nodiscard]] uint32_t getTaskAllocations();
+
+    void reportSteadyStateAllocation(const char* path, uint32_t allocations);
+
+    struct NoAllocStats
+    {
+        uint32_t violations = 0;
+        const char* lastPath = nullptr;
+    };
+
+    [[nodiscard]] NoAllocStats getNoAllocStats();
+
+    /**
+     * Attributes heap allocations made by the current task to `tag` until the
+     * scope ends. Frees are credited to the tag that allocated the block,
+     * whichever task releases it.
+     */
+    class Scope
+    {
+        const Tag previous;
+
+    public:
+        explicit Scope(const Tag tag) : previous(setCurrentTag(tag))
+        {
+        }
+
+        ~Scope()
+        {
+            setCurrentTag(previous);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /**
+     * Marks a steady-state path that must not touch the heap. Allocations made
+     * by the current task while the guard is alive are reported as violations
+     * (and abort with CONFIG_RGBW_CTRL_NO_ALLOC_ABORT). Needs the heap hooks.
+     */
+    class NoAllocGuard
+    {
+        const char* path;
+        const uint32_t start;
+
+    public:
+        explicit NoAllocGuard(const char* path) : path(path), start(getTaskAllocations())
+        {
+        }
+
+        ~NoAllocGuard()
+        {
+            if (const auto allocations = getTaskAllocations() - start; allocations > 0)
+                reportSteadyStateAllocation(path, allocations);
+        }
+
+        NoAllocGuard(const NoAllocGuard&) = delete;
+        NoAllocGuard& operator=(const NoAllocGuard&) = delete;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "heap_accounting.hh"
+#include "http_manager.hh"
+#include "load_shedding.hh"
+
+namespace HeapAccounting
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_HEAP;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                const auto summary = getSummary();
+                const auto history = getHistory();
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["free"] = summary.freeHeap;
+                root["minimumFree"] = summary.minimumFreeHeap;
+                root["largestFreeBlock"] = summary.largestFreeBlock;
+                root["fragmentation"] = summary.freeHeap > 0
+                                            ? 100 - summary.largestFreeBlock * 100 / summary.freeHeap
+                                            : 0;
+                root["low"] = summary.low != 0;
+                root["lowHeapEvents"] = summary.lowHeapEvents;
+                root["accounting"] = isEnabled();
+                root["untrackedAllocations"] = getUntrackedAllocations();
+                const auto noAlloc = getNoAllocStats();
+                root["steadyStateAllocations"] = noAlloc.violations;
+                if (noAlloc.lastPath) root["lastSteadyStateAllocation"] = noAlloc.lastPath;
+
+                const auto tags = root["tags"].to<JsonArray>();
+                for (uint8_t i = 0; i < TAG_COUNT; ++i)
+                {
+                    const auto tag = static_cast<Tag>(i);
+                    const auto stats = getStats(tag);
+                    const auto entry = tags.add<JsonObject>();
+                    entry["name"] = tagName(tag);
+                    entry["liveBytes"] = stats.liveBytes;
+                    entry["peakBytes"] = stats.peakBytes;
+                    entry["allocations"] = stats.allocations;
+                    entry["frees"] = stats.frees;
+                }
+
+                root["sampleIntervalMs"] = SAMPLE_INTERVAL_MS;
+                const auto largestFreeBlock = root["largestFreeBlockHistory"].to<JsonArray>();
+                for (uint8_t i = 0; i < history.count; ++i)
+                    largestFreeBlock.add(history.largestFreeBlock[i]);
+
+                const auto shedding = LoadShedding::getCounters();
+                const auto sheddingObject = root["shedding"].to<JsonObject>();
+                sheddingObject["level"] = LoadShedding::levelName(shedding.level);
+                sheddingObject["transitions"] = shedding.transitions;
+                sheddingObject["lastTransitionMs"] = shedding.lastTransitionMs;
+                sheddingObject["freeHeapAtTransition"] = shedding.freeHeapAtTransition;
+                const auto watermarks = sheddingObject["watermarks"].to<JsonObject>();
+                for (uint8_t i = 1; i < LoadShedding::LEVEL_COUNT; ++i)
+                {
+                    const auto level = static_cast<LoadShedding::Level>(i);
+                    watermarks[LoadShedding::levelName(level)] = LoadShedding::watermark(level);
+                }
+                const auto shed = sheddingObject["shed"].to<JsonObject>();
+                for (uint8_t i = 0; i < LoadShedding::LOAD_COUNT; ++i)
+                    shed[LoadShedding::loadName(static_cast<LoadShedding::Load>(i))] = shedding.shed[i];
+
+                const auto pool = Json::getPoolStats();
+                const auto jsonArenas = root["jsonArenas"].to<JsonObject>();
+                jsonArenas["size"] = Json::ARENA_SIZE;
+                jsonArenas["exhausted"] = pool.exhausted;
+                jsonArenas["heapFallbacks"] = pool.heapFallbacks;
+                jsonArenas["responseFallbacks"] = pool.responseFallbacks;
+                const auto arenas = jsonArenas["arenas"].to<JsonArray>();
+                for (const auto& arena : pool.arenas)
+                {
+                    const auto entry = arenas.add<JsonObject>();
+                    entry["leases"] = arena.leases;
+                    entry["highWaterMark"] = arena.highWaterMark;
+                    entry["leased"] = arena.leased;
+                }
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
+}
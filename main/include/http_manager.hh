@@ -1,8 +1,17 @@
 #pragma once
 
 #include <AsyncJson.h>
+#include <LittleFS.h>
+#include <mutex>
+#include <Preferences.h>
 
 #include "ble_service.hh"
+#include "boot_timeline.hh"
+#include "callback_budget.hh"
+#include "heap_accounting.hh"
+#include "json_pool.hh"
+#include "load_shedding.hh"
+#include "worker_pool.hh"
 
 namespace HTTP
 {
@@ -13,6 +22,17 @@ namespace HTTP
         static constexpr auto BLUETOOTH = "/bluetooth";
         static constexpr auto SYSTEM_RESTART = "/system/restart";
         static constexpr auto SYSTEM_RESET = "/system/reset";
+        static constexpr auto SYSTEM_TASKS = "/system/tasks";
+        static constexpr auto SYSTEM_PROFILE = "/system/profile";
+        static constexpr auto SYSTEM_CALLBACKS = "/system/callbacks";
+        static constexpr auto SYSTEM_HEAP = "/system/heap";
+        static constexpr auto SYSTEM_TRACE = "/system/trace";
+        static constexpr auto SYSTEM_BOOT = "/system/boot";
+        static constexpr auto SYSTEM_POWER = "/system/power";
+        static constexpr auto SYSTEM_STALLS = "/system/stalls";
+        static constexpr auto SYSTEM_LOG = "/system/log";
+        static constexpr auto SYSTEM_HISTORY = "/system/history";
+        static constexpr auto BENCH = "/bench";
         static constexpr auto OUTPUT_COLOR = "/output/color";
         static constexpr auto OUTPUT_BRIGHTNESS = "/output/brightness";
     }
@@ -25,7 +45,7 @@ namespace HTTP
 
         static void sendMessageJsonResponse(AsyncWebServerRequest* request, const char* message)
         {
-            auto* response = new AsyncJsonResponse();
+            auto* response = new Json::PooledResponse();
             response->getRoot().to<JsonObject>()["message"] = message;
             response->addHeader("Cache-Control", "no-store");
             response->setLength();
@@ -59,11 +79,41 @@ namespace HTTP
         static constexpr auto PREFERENCES_NAME = "http";
         static constexpr auto PREFERENCES_USERNAME_KEY = "u";
         static constexpr auto PREFERENCES_PASSWORD_KEY = "p";
+        // Set on requests that arrived while LittleFS was being formatted.
+        static constexpr auto ATTR_FILE_SYSTEM_PENDING = "fileSystemPending";
+
+        enum class FileSystemState : uint8_t
+        {
+            Unmounted,
+            Formatting,
+            Mounted,
+            Failed
+        };
 
         AsyncWebServer webServer = AsyncWebServer(80);
 
         AsyncAuthenticationMiddleware authMiddleware;
 
+        // Times every request handler, which runs on the async_tcp task.
+        AsyncMiddlewareFunction budgetMiddleware{
+            [](AsyncWebServerRequest* request, const ArMiddlewareNext& next)
+            {
+                CallbackBudget::Scope budget(CallbackBudget::Context::AsyncTcp, "HTTP::onRequest",
+                                             static_cast<int16_t>(request->method()));
+                next();
+            }
+        };
+
+        AsyncMiddlewareFunction firstRequestMiddleware{
+            [](AsyncWebServerRequest*, const ArMiddlewareNext& next)
+            {
+                BootTimeline::mark(BootTimeline::Phase::FirstRequest);
+                next();
+            }
+        };
+
+        FileSystemState fileSystemState = FileSystemState::Unmounted;
+
     public:
         void begin(AsyncWebHandler* alexaHandler,
                    const std::vector<AsyncWebHandlerCreator*>&& httpHandlers)
@@ -78,14 +128,33 @@ namespace HTTP
                          .addMiddleware(&authMiddleware);
             }
 
+            // Static files are matched last, so the filter first runs for a request no other handler took.
             webServer.serveStatic("/", LittleFS, "/")
                      .setDefaultFile("index.html")
                      .setTryGzipFirst(true)
                      .setCacheControl("no-cache")
-                     .addMiddleware(&authMiddleware);
+                     .addMiddleware(&authMiddleware)
+                     .setFilter([this](AsyncWebServerRequest* request)
+                     {
+                         if (LoadShedding::isShedding(LoadShedding::Load::StaticAssets)) return false;
+                         switch (mountFileSystem())
+                         {
+                         case FileSystemState::Mounted:
+                             return true;
+                         case FileSystemState::Failed:
+                             return false;
+                         default:
+                             request->setAttribute(ATTR_FILE_SYSTEM_PENDING, true);
+                             return false;
+                         }
+                     });
+            webServer.onNotFound([this](AsyncWebServerRequest* request) { handleNotFound(request); });
 
+            webServer.addMiddleware(&budgetMiddleware);
+            webServer.addMiddleware(&firstRequestMiddleware);
             updateServerCredentials(getCredentials());
             webServer.begin();
+            BootTimeline::mark(BootTimeline::Phase::WebServer);
         }
 
         [[nodiscard]] const AsyncAuthenticationMiddleware& getAuthenticationMiddleware() const
@@ -142,6 +211,96 @@ namespace HTTP
         }
 
     private:
+        // Static files the filter turned away while shedding or formatting end up here as well. Shed requests are
+        // recognised by looking the file up again, so the filter does not have to tag them; only files we would have
+        // served are refused, other URLs still get a 404.
+        void handleNotFound(AsyncWebServerRequest* request)
+        {
+            if (LoadShedding::isShedding(LoadShedding::Load::StaticAssets) && isStaticAsset(request->url()) &&
+                LoadShedding::shed(LoadShedding::Load::StaticAssets))
+                sendRetryLater(request, "Low memory, try again later");
+            else if (request->getAttribute(ATTR_FILE_SYSTEM_PENDING))
+                sendRetryLater(request, "File system not ready, try again later");
+            else
+                request->send(404, "text/plain", "Not found");
+        }
+
+        static void sendRetryLater(AsyncWebServerRequest* request, const char* message)
+        {
+            const auto response = request->beginResponse(503, "text/plain", message);
+            response->addHeader("Retry-After", "5");
+            request->send(response);
+        }
+
+        static std::mutex& getFileSystemMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        /**
+         * Whether the static handler would serve `url`. The path is resolved the
+         * way the handler does it, in a stack buffer, so the check neither
+         * allocates nor probes every candidate. The file system is not mounted
+         * just for this while shedding, so nothing counts as an asset before
+         * the first mount.
+         */
+        [[nodiscard]] bool isStaticAsset(const String& url)
+        {
+            {
+                std::lock_guard lock(getFileSystemMutex());
+                if (fileSystemState != FileSystemState::Mounted) return false;
+            }
+            // Directories resolve to their index file; the gzipped copy is tried first, like the handler does.
+            const char* suffix = "";
+            if (url.endsWith("/")) suffix = "index.html";
+            else if (const char* name = strrchr(url.c_str(), '/'); !strchr(name ? name : url.c_str(), '.'))
+                suffix = "/index.html";
+            // Longer paths cannot name a LittleFS file.
+            std::array<char, 64> path;
+            const auto length = snprintf(path.data(), path.size(), "%s%s.gz", url.c_str(), suffix);
+            if (length < 0 || static_cast<size_t>(length) >= path.size()) return false;
+            if (LittleFS.exists(path.data())) return true;
+            path[length - 3] = '\0';
+            return LittleFS.exists(path.data());
+        }
+
+        /**
+         * Mounts LittleFS on the first request for a static file rather than
+         * during setup(), which only has to light the outputs and start the
+         * network. Formatting can block for seconds, far too long for the
+         * async_tcp task, so a failed mount is formatted and retried on a
+         * worker; requests get a 503 until it finishes. A mount that still
+         * fails after formatting is not retried.
+         */
+        FileSystemState mountFileSystem()
+        {
+            std::lock_guard lock(getFileSystemMutex());
+            if (fileSystemState != FileSystemState::Unmounted) return fileSystemState;
+            if (LittleFS.begin(false))
+            {
+                fileSystemState = FileSystemState::Mounted;
+                BootTimeline::mark(BootTimeline::Phase::FileSystem);
+            }
+            else if (Async::post([this] { formatFileSystem(); }))
+            {
+                ESP_LOGW(LOG_TAG, "Failed to mount LittleFS, formatting it");
+                fileSystemState = FileSystemState::Formatting;
+            }
+            // Otherwise the workers are busy, and the next request tries again.
+            return fileSystemState;
+        }
+
+        // Runs on a worker; the Formatting state keeps the filter from mounting meanwhile.
+        void formatFileSystem()
+        {
+            const bool mounted = LittleFS.begin(true);
+            std::lock_guard lock(getFileSystemMutex());
+            fileSystemState = mounted ? FileSystemState::Mounted : FileSystemState::Failed;
+            if (mounted) BootTimeline::mark(BootTimeline::Phase::FileSystem);
+            else ESP_LOGE(LOG_TAG, "Failed to mount LittleFS, static files are unavailable");
+        }
+
         void updateServerCredentials(const Credentials& credentials)
         {
             authMiddleware.setUsername(credentials.username.data());
@@ -175,6 +334,8 @@ namespace HTTP
 
             void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
             {
+                CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "CredentialsCallback::onWrite");
+                HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
                 Credentials credentials;
                 if (pCharacteristic->getValue().size() != sizeof(Credentials))
                 {
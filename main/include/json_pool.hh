@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+namespace Json
+{
+    static constexpr uint8_t ARENA_COUNT = 4;
+    static constexpr size_t ARENA_SIZE = 4096;
+
+    struct ArenaStats
+    {
+        uint32_t leases = 0;
+        uint32_t highWaterMark = 0;
+        bool leased = false;
+    };
+
+    struct PoolStats
+    {
+        std::array<ArenaStats, ARENA_COUNT> arenas = {};
+        // Documents created while every arena was leased; they use the heap only.
+        uint32_t exhausted = 0;
+        // Allocations that did not fit the leased arena and went to the heap.
+        uint32_t heapFallbacks = 0;
+        // Responses created while every response slot was taken; they use the heap.
+        uint32_t responseFallbacks = 0;
+    };
+
+    [[nodiscard]] PoolStats getPoolStats();
+
+    /**
+     * ArduinoJson allocator that leases one of the fixed arenas on the first
+     * allocation and bump-allocates from it. The arena is reset and returned
+     * when the allocator is destroyed, i.e. when the request is done.
+     * Allocations that don't fit fall back to the heap.
+     */
+    class ArenaAllocator : public ArduinoJson::Allocator
+    {
+        int8_t arena = -1;
+        bool leaseAttempted = false;
+
+    public:
+        ArenaAllocator() = default;
+        ~ArenaAllocator();
+
+        ArenaAllocator(const ArenaAllocator&) = delete;
+        ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+        void* allocate(size_t size) override;
+        void deallocate(void* ptr) override;
+        void* reallocate(void* ptr, size_t newSize) override;
+    };
+
+    /**
+     * JsonDocument whose memory comes from an arena for its whole lifetime.
+     */
+    class PooledDocument : ArenaAllocator, public JsonDocument
+    {
+    public:
+        PooledDocument() : JsonDocument(static_cast<ArenaAllocator*>(this))
+        {
+        }
+
+        PooledDocument(const PooledDocument&) = delete;
+        PooledDocument& operator=(const PooledDocument&) = delete;
+    };
+
+    // How a PooledResponse serializes its document.
+    enum class Format : uint8_t
+    {
+        Json,
+        MsgPack,
+    };
+
+    /**
+     * Drop-in replacement for AsyncJsonResponse backed by a PooledDocument.
+     * The arena stays leased until the response has been sent. With
+     * Format::MsgPack the same document is streamed as MessagePack. The
+     * response object itself comes from one of ARENA_COUNT preallocated
+     * slots, so `new PooledResponse()` does not touch the heap either while
+     * one is free.
+     */
+    class PooledResponse final : public AsyncAbstractResponse
+    {
+        PooledDocument document;
+        JsonVariant root;
+        Format format;
+        bool valid = false;
+
+    public:
+        explicit PooledResponse(bool isArray = false, Format format = Format::Json);
+
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr);
+
+        JsonVariant& getRoot()
+        {
+            return root;
+        }
+
+        size_t setLength();
+
+        [[nodiscard]] bool _sourceValid() const override
+        {
+            return valid;
+        }
+
+        size_t _fillBuffer(uint8_t* data, size_t len) override;
+    };
+}
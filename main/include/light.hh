@@ -1,10 +1,14 @@
 #pragma once
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 #include <Preferences.h>
 #include <cmath>
 
+#include "binary_log.hh"
 #include "controller_hardware.hh"
+#include "output_backend.hh"
+#include "reflect.hh"
 
 class Light
 {
@@ -25,10 +29,17 @@ public:
             return on != other.on || value != other.value;
         }
 
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("on", &State::on),
+                Reflect::field("value", &State::value),
+            };
+        }
+
         void toJson(const JsonObject &to) const
         {
-            to["on"] = on;
-            to["value"] = value;
+            Reflect::toJson(*this, to);
         }
     };
 #pragma pack(pop)
@@ -42,11 +53,26 @@ public:
     static constexpr uint8_t MIN_BRIGHTNESS = OFF_VALUE + 1;
     static constexpr uint8_t MAX_BRIGHTNESS = ON_VALUE;
 
+    // Drives the output from a state kept across a warm restart, before NVS is read.
+    void resume(const State& resumed)
+    {
+        backend.attach(channel, pin);
+        attached = true;
+        state = resumed;
+        update();
+    }
+
     void setup()
     {
         prefs.begin(PREFERENCES_NAME, false);
-        pinMode(pin, OUTPUT);
-        ledcAttach(pin, PWM_FREQUENCY, PWM_RESOLUTION);
+        if (attached)
+        {
+            // The resumed state is newer than NVS, which is only written after a debounce.
+            lastPersistedState = loadPersistedState();
+            return;
+        }
+        backend.attach(channel, pin);
+        attached = true;
         restore();
     }
 
@@ -62,13 +88,14 @@ public:
     }
 
 private:
-    static constexpr uint32_t PWM_FREQUENCY = 25000;
-    static constexpr uint8_t PWM_RESOLUTION = 8;
     static constexpr unsigned long PERSIST_DEBOUNCE_MS = 500;
 
     bool invert;
     gpio_num_t pin;
+    OutputBackend::Backend& backend;
+    uint8_t channel;
     State state;
+    bool attached = false;
 
     char onKey[5] = "";
     char valueKey[5] = "";
@@ -81,24 +108,28 @@ private:
 
     void update()
     {
-        const auto &channel = ControllerHardware::getPwmChannel(pin);
         const auto duty = state.on ? state.value : OFF_VALUE;
 
         if (uint8_t outputValue = invert ? MAX_BRIGHTNESS - duty : duty;
             lastWrittenValue != outputValue)
         {
-            ledcWrite(channel.value(), outputValue);
+            backend.write(channel, outputValue);
             lastWrittenValue = outputValue;
         }
     }
 
+    [[nodiscard]] State loadPersistedState()
+    {
+        return {prefs.getBool(onKey, false), prefs.getUChar(valueKey, OFF_VALUE)};
+    }
+
     void restore()
     {
-        state.on = prefs.getBool(onKey, false);
-        state.value = prefs.getUChar(valueKey, OFF_VALUE);
+        state = loadPersistedState();
         update();
     }
 
+public:
     static uint8_t perceptualBrightnessStep(const uint8_t currentValue, const bool increase)
     {
         constexpr float gamma = 2.2f;
@@ -112,11 +143,22 @@ private:
         return std::clamp(static_cast<uint8_t>(value), MIN_BRIGHTNESS, MAX_BRIGHTNESS);
     }
 
-public:
-    explicit Light(const gpio_num_t pin, const bool invert = false) : invert(invert), pin(pin)
+    /**
+     * Drives `channel` of `backend`. The persisted state is keyed by
+     * `persistId`, which is the GPIO number for outputs that have one.
+     */
+    Light(OutputBackend::Backend& backend, const uint8_t channel, const gpio_num_t pin, const uint8_t persistId,
+          const bool invert = false)
+        : invert(invert), pin(pin), backend(backend), channel(channel)
+    {
+        snprintf(onKey, sizeof(onKey), "%02uo", static_cast<unsigned>(persistId));
+        snprintf(valueKey, sizeof(valueKey), "%02uv", static_cast<unsigned>(persistId));
+    }
+
+    // An LEDC output on `pin`.
+    explicit Light(const gpio_num_t pin, const bool invert = false)
+        : Light(OutputBackend::ledc(), ControllerHardware::getPwmChannel(pin).value(), pin, pin, invert)
     {
-        snprintf(onKey, sizeof(onKey), "%02uo", static_cast<unsigned>(pin));
-        snprintf(valueKey, sizeof(valueKey), "%02uv", static_cast<unsigned>(pin));
     }
 
     ~Light()
@@ -151,7 +193,7 @@ public:
 
         const auto step = perceptualBrightnessStep(state.value, true);
 
-        ESP_LOGI(LOG_TAG, "Increasing brightness to %u", step);
+        BINARY_LOGI(BinaryLog::Tag::Light, "Increasing brightness to %u", step);
         state.value = step;
         update();
     }
@@ -163,7 +205,7 @@ public:
 
         const auto step = perceptualBrightnessStep(state.value, false);
 
-        ESP_LOGI(LOG_TAG, "Decreasing brightness to %u", step);
+        BINARY_LOGI(BinaryLog::Tag::Light, "Decreasing brightness to %u", step);
         state.value = step;
         update();
     }
@@ -174,6 +216,13 @@ public:
         update();
     }
 
+    // Writes the duty again even if it is unchanged, e.g. after the backend lost its registers.
+    void refresh()
+    {
+        lastWrittenValue = std::nullopt;
+        update();
+    }
+
     void makeVisible()
     {
         state.on = true;
@@ -192,3 +241,5 @@ public:
     [[nodiscard]] uint8_t getValue() const { return state.value; }
     [[nodiscard]] State getState() const { return state; }
 };
+
+static_assert(Reflect::checkLayout<Light::State>(), "Light::State must be fully described");
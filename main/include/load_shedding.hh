@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <sdkconfig.h>
+
+#include "reflect.hh"
+
+/**
+ * Central policy for running short of heap. The free heap is compared with
+ * three watermarks and each level gives up more optional work, keeping the
+ * measures of the levels below it. Output commands from any source are
+ * never shed. A level is left again only once the heap has recovered by
+ * HYSTERESIS_BYTES above its watermark, so the policy does not flap.
+ */
+namespace LoadShedding
+{
+    enum class Level : uint8_t
+    {
+        Normal,
+        Reduced,
+        Shedding,
+        Critical,
+        COUNT
+    };
+
+    // Work that is given up under memory pressure.
+    enum class Load : uint8_t
+    {
+        // Periodic heap and telemetry WebSocket frames.
+        Broadcasts,
+        // New WebSocket connections.
+        NewClients,
+        // Files from LittleFS; answered with 503 instead.
+        StaticAssets,
+        // Bringing up the BLE stack, which needs tens of kilobytes.
+        BleStart,
+        COUNT
+    };
+
+    static constexpr auto LEVEL_COUNT = static_cast<uint8_t>(Level::COUNT);
+    static constexpr auto LOAD_COUNT = static_cast<uint8_t>(Load::COUNT);
+    static constexpr uint32_t HYSTERESIS_BYTES = 4096;
+    static constexpr uint32_t EVALUATION_INTERVAL_MS = 250;
+
+    // Lowest level at which `load` is shed.
+    [[nodiscard]] constexpr Level threshold(const Load load)
+    {
+        switch (load)
+        {
+        case Load::Broadcasts: return Level::Reduced;
+        case Load::NewClients:
+        case Load::StaticAssets: return Level::Shedding;
+        case Load::BleStart:
+        default: return Level::Critical;
+        }
+    }
+
+    // The live counters, which are also the telemetry section; Reflect packs them when they are sent.
+    struct Counters
+    {
+        Level level = Level::Normal;
+        uint16_t transitions = 0;
+        uint32_t lastTransitionMs = 0;
+        uint32_t freeHeapAtTransition = 0;
+        // How often each load was refused since boot.
+        std::array<uint16_t, LOAD_COUNT> shed = {};
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("level", &Counters::level),
+                Reflect::field("transitions", &Counters::transitions),
+                Reflect::field("lastTransitionMs", &Counters::lastTransitionMs),
+                Reflect::field("freeHeapAtTransition", &Counters::freeHeapAtTransition),
+                Reflect::field("shed", &Counters::shed),
+            };
+        }
+    };
+
+    inline std::atomic<Level> level = Level::Normal;
+
+    [[nodiscard]] inline bool isShedding(const Load load)
+    {
+        return level.load(std::memory_order_relaxed) >= threshold(load);
+    }
+
+    /**
+     * Returns true when `load` has to be given up at the current level and
+     * counts the refusal. Safe from any task.
+     */
+    bool shed(Load load);
+
+    // Re-evaluates the level from the free heap. Call it from the main loop.
+    void handle(unsigned long now);
+
+    [[nodiscard]] const char* levelName(Level level);
+    [[nodiscard]] const char* loadName(Load load);
+    [[nodiscard]] uint32_t watermark(Level level);
+    [[nodiscard]] uint16_t getTransitions();
+    [[nodiscard]] Counters getCounters();
+}
@@ -5,6 +5,8 @@
 #include <array>
 #include <atomic>
 
+#include "reflect.hh"
+
 namespace OTA
 {
     enum class Status : uint8_t
@@ -22,11 +24,21 @@ namespace OTA
         uint32_t totalBytesExpected = 0;
         uint32_t totalBytesReceived = 0;
 
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("status", &State::status, [](JsonVariant to, const Status status)
+                {
+                    to.set(statusToString(status));
+                }),
+                Reflect::field("totalBytesExpected", &State::totalBytesExpected),
+                Reflect::field("totalBytesReceived", &State::totalBytesReceived),
+            };
+        }
+
         void toJson(const JsonObject& to) const
         {
-            to["status"] = statusToString(status);
-            to["totalBytesExpected"] = totalBytesExpected;
-            to["totalBytesReceived"] = totalBytesReceived;
+            Reflect::toJson(*this, to);
         }
 
         [[nodiscard]] static const char* statusToString(const Status status)
@@ -56,6 +68,7 @@ namespace OTA
         }
     };
 #pragma pack(pop)
+    static_assert(Reflect::checkLayout<State>(), "OTA::State is sent as is over WebSocket");
 
     class Handler final : public StateJsonFiller, public HTTP::AsyncWebHandlerCreator
     {
@@ -320,10 +333,10 @@ namespace OTA
             static void restartAfterUpdate()
             {
                 ESP_LOGI(LOG_TAG, "Restarting device after OTA update...");
-                async_call([]
+                Async::post([]
                 {
                     esp_restart();
-                }, 2048, 100);
+                }, 100);
             }
 
             static bool isRequestValidForUpload(const AsyncWebServerRequest* request)
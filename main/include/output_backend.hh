@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+
+/**
+ * What a Light writes its duty cycle to. LEDC takes a write immediately;
+ * backends behind a bus only record it and send the changed channels in one
+ * transfer from flush(), which the output manager calls once per loop pass.
+ */
+namespace OutputBackend
+{
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+
+        // Prepares `channel` for output; `pin` is only used by backends that drive GPIOs directly.
+        virtual void attach(uint8_t channel, gpio_num_t pin) = 0;
+
+        // Sets the 8-bit duty of `channel`. Safe from any task.
+        virtual void write(uint8_t channel, uint8_t duty) = 0;
+
+        // Sends the duties written since the last flush. Main loop only.
+        virtual void flush()
+        {
+        }
+
+        [[nodiscard]] virtual const char* name() const = 0;
+    };
+
+    class Ledc final : public Backend
+    {
+        static constexpr uint32_t PWM_FREQUENCY = 25000;
+        static constexpr uint8_t PWM_RESOLUTION = 8;
+
+    public:
+        void attach(uint8_t, const gpio_num_t pin) override
+        {
+            pinMode(pin, OUTPUT);
+            ledcAttach(pin, PWM_FREQUENCY, PWM_RESOLUTION);
+        }
+
+        void write(const uint8_t channel, const uint8_t duty) override
+        {
+            ledcWrite(channel, duty);
+        }
+
+        [[nodiscard]] const char* name() const override
+        {
+            return "ledc";
+        }
+    };
+
+    // Shared by the board LEDs and every LEDC output.
+    inline Ledc& ledc()
+    {
+        static Ledc backend;
+        return backend;
+    }
+}
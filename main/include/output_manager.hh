@@ -6,37 +6,51 @@
 #include <array>
 #include <Arduino.h>
 #include <algorithm>
+#include <utility>
 
 #include "ble_service.hh"
+#include "command_trace.hh"
+#include "controller_hardware.hh"
 #include "http_manager.hh"
+#include "heap_accounting.hh"
+#include "pca9685.hh"
+#include "power.hh"
+#include "reflect.hh"
 #include "state_json_filler.hh"
 #include "throttled_value.hh"
+#include "warm_restart.hh"
 
 namespace Output
 {
+    using ControllerHardware::OUTPUT_COUNT;
+
 #pragma pack(push, 1)
-    struct State
+    // One entry per output, in the order of the board profile.
+    template <size_t Channels>
+    struct BasicState
     {
-        std::array<Light::State, 4> values = {};
+        std::array<Light::State, Channels> values = {};
 
-        bool operator==(const State& other) const
+        bool operator==(const BasicState& other) const
         {
             return values == other.values;
         }
 
-        bool operator!=(const State& other) const
+        bool operator!=(const BasicState& other) const
         {
             return values != other.values;
         }
 
-        [[nodiscard]] bool isOn(Color color) const
+        [[nodiscard]] bool isOn(const Color color, const uint8_t zone = 0) const
         {
-            return values.at(static_cast<size_t>(color)).on;
+            const auto index = ControllerHardware::findOutput(color, zone);
+            return index && values[index.value()].on;
         }
 
-        [[nodiscard]] uint8_t getValue(Color color) const
+        [[nodiscard]] uint8_t getValue(const Color color, const uint8_t zone = 0) const
         {
-            return values.at(static_cast<size_t>(color)).value;
+            const auto index = ControllerHardware::findOutput(color, zone);
+            return index ? values[index.value()].value : Light::OFF_VALUE;
         }
 
         [[nodiscard]] bool anyOn() const
@@ -44,63 +58,110 @@ namespace Output
             return std::any_of(values.begin(), values.end(),
                                [](const Light::State& s) { return s.on; });
         }
+
+        static constexpr auto fields()
+        {
+            return std::tuple{Reflect::field("values", &BasicState::values)};
+        }
     };
 #pragma pack(pop)
 
+    using State = BasicState<OUTPUT_COUNT>;
+    static_assert(Reflect::checkLayout<State>(), "Output::State is sent as is over BLE and WebSocket");
+
     class Manager final : public BLE::Service, public StateJsonFiller, public HTTP::AsyncWebHandlerCreator
     {
         static constexpr auto LOG_TAG = "Output";
 
-        std::array<Light, 4> lights;
-        static_assert(static_cast<size_t>(Color::White) < 4, "Color enum out of bounds");
+        // Declared before the lights, which keep references to them.
+        std::array<OutputBackend::Pca9685, ControllerHardware::EXPANDER_COUNT> expanders;
+        std::array<Light, OUTPUT_COUNT> lights;
 
         NimBLECharacteristic* bleOutputColorCharacteristic = nullptr;
         ThrottledValue<State> colorNotificationThrottle{500};
+        State mirroredState = {};
+        State versionedState = {};
+        uint32_t stateVersion = 0;
 
     public:
-        explicit Manager(const gpio_num_t red,
-                         const gpio_num_t green,
-                         const gpio_num_t blue,
-                         const gpio_num_t white)
-            : lights{
-                Light(red, false),
-                Light(green, false),
-                Light(blue, false),
-                Light(white, false)
-            }
+        // One light per output of the board profile.
+        Manager()
+            : expanders(makeExpanders(std::make_index_sequence<ControllerHardware::EXPANDER_COUNT>())),
+              lights(makeLights(std::make_index_sequence<OUTPUT_COUNT>()))
+        {
+        }
+
+        /**
+         * Lights the outputs as early as possible: from the RTC mirror when the
+         * previous run ended in a warm restart, otherwise from NVS. Runs from
+         * initVariant(), before setup(); returns false on a cold boot.
+         */
+        bool resume()
         {
+            const auto mirrored = WarmRestart::load();
+            if (!mirrored)
+            {
+                for (auto& light : lights)
+                    light.setup();
+                WarmRestart::markLightsOn(false);
+                return false;
+            }
+            for (size_t i = 0; i < lights.size(); ++i)
+                lights[i].resume(mirrored->at(i));
+            flush();
+            mirroredState = {mirrored.value()};
+            WarmRestart::markLightsOn(true);
+            return true;
         }
 
+        // Lights that resume() already drives only load their persisted state as the NVS baseline.
         void begin()
         {
             for (auto& light : lights)
                 light.setup();
+            WarmRestart::markLightsOn(false);
         }
 
         void handle(const unsigned long now)
         {
             for (auto& light : lights)
                 light.handle(now);
+            flush();
+            if (const auto state = getState(); state != mirroredState)
+            {
+                WarmRestart::save(state.values);
+                mirroredState = state;
+            }
             sendColorNotification(now);
         }
 
-        void setValue(const uint8_t value, Color color)
+        // Colors the board does not have in `zone` are ignored.
+        void setValue(const uint8_t value, const Color color, const uint8_t zone = 0)
         {
-            return lights.at(static_cast<size_t>(color)).setValue(value);
+            if (const auto light = find(color, zone))
+                light->setValue(value);
         }
 
-        void setOn(const bool on, Color color)
+        void setOn(const bool on, const Color color, const uint8_t zone = 0)
         {
-            return lights.at(static_cast<size_t>(color)).setOn(on);
+            if (const auto light = find(color, zone))
+                light->setOn(on);
         }
 
-        void toggle(Color color)
+        // Toggles `color` in every zone together, so the zones stay in step.
+        void toggle(const Color color)
         {
-            auto& light = lights.at(static_cast<size_t>(color));
-            const bool on = !light.isVisible();
-            light.setOn(on);
-            if (on)
-                light.makeVisible();
+            bool visible = false;
+            for (size_t i = 0; i < OUTPUT_COUNT; ++i)
+                if (ControllerHardware::BOARD.outputs[i].color == color)
+                    visible = visible || lights[i].isVisible();
+            for (size_t i = 0; i < OUTPUT_COUNT; ++i)
+            {
+                if (ControllerHardware::BOARD.outputs[i].color != color) continue;
+                lights[i].setOn(!visible);
+                if (!visible)
+                    lights[i].makeVisible();
+            }
         }
 
         void toggleAll()
@@ -152,27 +213,18 @@ namespace Output
                     light.decreaseBrightness();
         }
 
+        // Colors of the first zone.
         void setColor(const uint8_t r, const uint8_t g, const uint8_t b)
         {
-            lights.at(static_cast<size_t>(Color::Red)).setValue(r);
-            lights.at(static_cast<size_t>(Color::Green)).setValue(g);
-            lights.at(static_cast<size_t>(Color::Blue)).setValue(b);
+            setValue(r, Color::Red);
+            setValue(g, Color::Green);
+            setValue(b, Color::Blue);
         }
 
         void setColor(const uint8_t r, const uint8_t g, const uint8_t b, const uint8_t w)
         {
-            lights.at(static_cast<size_t>(Color::Red)).setValue(r);
-            lights.at(static_cast<size_t>(Color::Green)).setValue(g);
-            lights.at(static_cast<size_t>(Color::Blue)).setValue(b);
-            lights.at(static_cast<size_t>(Color::White)).setValue(w);
-        }
-
-        void setOn(const bool r, const bool g, const bool b, const bool w)
-        {
-            lights.at(static_cast<size_t>(Color::Red)).setOn(r);
-            lights.at(static_cast<size_t>(Color::Green)).setOn(g);
-            lights.at(static_cast<size_t>(Color::Blue)).setOn(b);
-            lights.at(static_cast<size_t>(Color::White)).setOn(w);
+            setColor(r, g, b);
+            setValue(w, Color::White);
         }
 
         void setAll(const uint8_t value, const bool on)
@@ -190,6 +242,21 @@ namespace Output
                 lights.at(i).setState(state.values[i]);
         }
 
+        // Sends every duty again, whether it changed or not.
+        void refresh()
+        {
+            for (auto& light : lights)
+                light.refresh();
+            flush();
+        }
+
+        // Hands the duties written since the last call to the bus backends. Main loop only.
+        void flush()
+        {
+            for (auto& expander : expanders)
+                expander.flush();
+        }
+
         [[nodiscard]] bool anyOn() const
         {
             return std::any_of(lights.begin(), lights.end(),
@@ -202,36 +269,44 @@ namespace Output
                                [](const Light& light) { return light.isVisible(); });
         }
 
-        [[nodiscard]] uint8_t getValue(Color color) const
-        {
-            return lights.at(static_cast<size_t>(color)).getValue();
-        }
-
-        [[nodiscard]] bool isOn(Color color) const
+        [[nodiscard]] uint8_t getValue(const Color color, const uint8_t zone = 0) const
         {
-            return lights.at(static_cast<size_t>(color)).isOn();
+            const auto light = find(color, zone);
+            return light ? light->getValue() : Light::OFF_VALUE;
         }
 
-        [[nodiscard]] std::array<uint8_t, 4> getValues() const
+        [[nodiscard]] bool isOn(const Color color, const uint8_t zone = 0) const
         {
-            std::array<uint8_t, 4> output = {};
-            std::transform(lights.begin(), lights.end(), output.begin(), [](const auto& light)
-            {
-                return light.getValue();
-            });
-            return output;
+            const auto light = find(color, zone);
+            return light && light->isOn();
         }
 
         [[nodiscard]] State getState() const
         {
-            std::array<Light::State, 4> state;
+            std::array<Light::State, OUTPUT_COUNT> state;
             std::transform(lights.begin(), lights.end(), state.begin(),
                            [](const Light& light) { return light.getState(); });
             return {state};
         }
 
+        /**
+         * Number of distinct output states seen so far. The version moves when it
+         * is read after a change, so commands that leave the output as it was keep it.
+         */
+        [[nodiscard]] uint32_t getStateVersion()
+        {
+            std::lock_guard lock(getVersionMutex());
+            if (const auto state = getState(); state != versionedState)
+            {
+                versionedState = state;
+                stateVersion++;
+            }
+            return stateVersion;
+        }
+
         void fillState(const JsonObject& root) const override
         {
+            root["board"] = ControllerHardware::BOARD.name;
             const auto arr = root["output"].to<JsonArray>();
             for (const auto& light : lights)
                 light.toJson(arr.add<JsonObject>());
@@ -271,6 +346,48 @@ namespace Output
         }
 
     private:
+        template <size_t... Index>
+        static std::array<OutputBackend::Pca9685, sizeof...(Index)> makeExpanders(std::index_sequence<Index...>)
+        {
+            using ControllerHardware::Pin::I2c::SDA;
+            using ControllerHardware::Pin::I2c::SCL;
+            return {OutputBackend::Pca9685(Wire, OutputBackend::Pca9685::BASE_ADDRESS + Index, SDA, SCL)...};
+        }
+
+        template <size_t... Index>
+        std::array<Light, OUTPUT_COUNT> makeLights(std::index_sequence<Index...>)
+        {
+            return {makeLight(ControllerHardware::BOARD.outputs[Index])...};
+        }
+
+        Light makeLight(const ControllerHardware::OutputChannel& output)
+        {
+            if (output.expander == 0)
+                return Light(OutputBackend::ledc(), output.pwmChannel, output.pin, output.pin);
+            // GPIO numbers end at 39, so expander channels are persisted from 40 on.
+            const auto persistId = static_cast<uint8_t>(40 + (output.expander - 1) * OutputBackend::Pca9685::CHANNELS
+                                                        + output.pwmChannel);
+            return Light(expanders[output.expander - 1], output.pwmChannel, output.pin, persistId);
+        }
+
+        [[nodiscard]] Light* find(const Color color, const uint8_t zone)
+        {
+            const auto index = ControllerHardware::findOutput(color, zone);
+            return index ? &lights[index.value()] : nullptr;
+        }
+
+        [[nodiscard]] const Light* find(const Color color, const uint8_t zone) const
+        {
+            const auto index = ControllerHardware::findOutput(color, zone);
+            return index ? &lights[index.value()] : nullptr;
+        }
+
+        static std::mutex& getVersionMutex()
+        {
+            static std::mutex versionMutex;
+            return versionMutex;
+        }
+
         void sendColorNotification(const unsigned long now)
         {
             std::lock_guard bleLock(getBleMutex());
@@ -280,7 +397,8 @@ namespace Output
             if (!colorNotificationThrottle.shouldSend(now, state))
                 return;
 
-            bleOutputColorCharacteristic->setValue(reinterpret_cast<uint8_t*>(&state), sizeof(state));
+            const auto payload = Reflect::encode(state);
+            bleOutputColorCharacteristic->setValue(payload.data(), payload.size());
             if (bleOutputColorCharacteristic->notify())
             {
                 colorNotificationThrottle.setLastSent(now, state);
@@ -329,18 +447,16 @@ namespace Output
                 }
             }
 
+            // Each output is set by the parameter named after its key; outputs without one are turned off.
             void handleColorRequest(AsyncWebServerRequest* request) const
             {
-                const auto oldR = output->getValue(Color::Red);
-                const auto oldG = output->getValue(Color::Green);
-                const auto oldB = output->getValue(Color::Blue);
-                const auto oldW = output->getValue(Color::White);
-                const auto r = extractUint8Param(request, "r");
-                const auto g = extractUint8Param(request, "g");
-                const auto b = extractUint8Param(request, "b");
-                const auto w = extractUint8Param(request, "w");
-                output->setColor(r.value_or(oldR), g.value_or(oldG), b.value_or(oldB), w.value_or(oldW));
-                output->setOn(r.has_value(), g.has_value(), b.has_value(), w.has_value());
+                for (size_t i = 0; i < OUTPUT_COUNT; ++i)
+                {
+                    auto& light = output->lights[i];
+                    const auto value = extractUint8Param(request, ControllerHardware::BOARD.outputs[i].key);
+                    light.setValue(value.value_or(light.getValue()));
+                    light.setOn(value.has_value());
+                }
                 sendMessageJsonResponse(request, "Color updated");
             }
         };
@@ -356,23 +472,27 @@ namespace Output
 
             void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
             {
-                State state = {};
-                constexpr uint8_t size = sizeof(State);
-                if (pCharacteristic->getValue().size() != size)
+                CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "OutputColorCallback::onWrite");
+                HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
+                HeapAccounting::NoAllocGuard noAlloc("OutputColorCallback::onWrite");
+                if (const auto length = pCharacteristic->getLength(); length != Reflect::wireSize<State>())
                 {
-                    ESP_LOGE(LOG_TAG, "Received invalid Alexa color values length: %d",
-                             pCharacteristic->getValue().size());
+                    ESP_LOGE(LOG_TAG, "Received invalid Alexa color values length: %d", static_cast<int>(length));
                     return;
                 }
-                memcpy(&state, pCharacteristic->getValue().data(), size);
+                const auto payload = pCharacteristic->getValue<Reflect::Buffer<State>>();
+                State state;
+                Reflect::decode(payload.data(), state);
+                Power::CommandScope power;
+                Trace::Scope trace(Trace::Source::Ble, payload.data(), payload.size());
                 output->setState(state);
                 output->colorNotificationThrottle.setLastSent(millis(), state);
             }
 
             void onRead(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
             {
-                auto state = output->getState();
-                pCharacteristic->setValue(reinterpret_cast<uint8_t*>(&state), sizeof(state));
+                const auto payload = Reflect::encode(output->getState());
+                pCharacteristic->setValue(payload.data(), payload.size());
             }
         };
     };
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <Wire.h>
+
+#include "output_backend.hh"
+
+namespace OutputBackend
+{
+    /**
+     * PCA9685 16-channel, 12-bit I2C PWM expander. write() only updates a
+     * shadow of the LED registers; flush() sends the span from the first to
+     * the last changed channel as one auto-increment write, so changing a
+     * whole zone costs a single bus transaction instead of one per channel.
+     */
+    class Pca9685 final : public Backend
+    {
+    public:
+        static constexpr uint8_t CHANNELS = 16;
+        static constexpr uint8_t BASE_ADDRESS = 0x40;
+        static constexpr uint16_t PWM_FREQUENCY = 1000;
+        static constexpr uint32_t I2C_CLOCK = 400000;
+
+        struct Stats
+        {
+            uint32_t transactions = 0;
+            // Bytes after the address byte, i.e. register pointer and data.
+            uint32_t bytes = 0;
+            uint32_t errors = 0;
+        };
+
+        Pca9685(TwoWire& wire, uint8_t address, gpio_num_t sda, gpio_num_t scl);
+
+        void attach(uint8_t channel, gpio_num_t pin) override;
+        void write(uint8_t channel, uint8_t duty) override;
+        void flush() override;
+
+        [[nodiscard]] const char* name() const override
+        {
+            return "pca9685";
+        }
+
+        [[nodiscard]] uint8_t getAddress() const
+        {
+            return address;
+        }
+
+        [[nodiscard]] Stats getStats() const;
+
+    private:
+        TwoWire& wire;
+        const uint8_t address;
+        const gpio_num_t sda;
+        const gpio_num_t scl;
+
+        mutable std::mutex mutex;
+        std::array<uint8_t, CHANNELS> duties = {};
+        // Bit n is set while channel n has a duty that was not sent yet.
+        uint16_t dirty = 0;
+        Stats stats;
+
+        // Only touched by the task that attaches and flushes.
+        bool initialized = false;
+        unsigned long lastInitAttempt = 0;
+
+        bool initialize();
+        bool writeRegister(uint8_t reg, uint8_t value);
+        void countTransaction(size_t bytes, bool ok);
+    };
+}
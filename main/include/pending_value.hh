@@ -0,0 +1,36 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+
+/**
+ * Single-slot mailbox used to hand a value from a callback context to a
+ * deferred job. A newer value replaces one that has not been taken yet.
+ */
+template <typename T>
+class PendingValue
+{
+    std::optional<T> value;
+    std::mutex mutex;
+
+public:
+    /**
+     * Stores `newValue` and returns true when the slot was empty, i.e. when
+     * the caller has to schedule the job that will take it.
+     */
+    bool put(const T& newValue)
+    {
+        std::lock_guard lock(mutex);
+        const bool wasEmpty = !value.has_value();
+        value = newValue;
+        return wasEmpty;
+    }
+
+    std::optional<T> take()
+    {
+        std::lock_guard lock(mutex);
+        auto taken = value;
+        value.reset();
+        return taken;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#include "reflect.hh"
+
+/**
+ * Dynamic frequency scaling and automatic light sleep through esp_pm. The
+ * CPU runs at the minimum frequency (and may light-sleep) unless one of the
+ * locks below is held; Wi-Fi, BLE and any running task raise it on their own
+ * while they work. The main loop sleeps between passes so the idle task gets
+ * to run at all.
+ */
+namespace Power
+{
+    enum class Lock : uint8_t
+    {
+        // LEDC is clocked from APB, which must not change while an output is lit.
+        Pwm,
+        // A WebSocket client or BLE central is connected; keeps the chip out of light sleep.
+        Session,
+        // OTA upload in progress; keeps the CPU at full speed.
+        Transfer,
+        COUNT
+    };
+
+    /**
+     * The lowest frequency the locks held here allow. This is derived from
+     * our own locks, not measured: Wi-Fi and BLE hold locks of their own, so
+     * the CPU can run faster than its floor.
+     */
+    enum class Floor : uint8_t
+    {
+        CpuMax,
+        ApbMax,
+        Awake,
+        LightSleep,
+        COUNT
+    };
+
+    static constexpr auto LOCK_COUNT = static_cast<uint8_t>(Lock::COUNT);
+    static constexpr auto FLOOR_COUNT = static_cast<uint8_t>(Floor::COUNT);
+
+    struct Latency
+    {
+        uint32_t count = 0;
+        uint32_t meanUs = 0;
+        uint32_t maxUs = 0;
+    };
+
+    struct Stats
+    {
+        bool enabled = false;
+        uint16_t maxMhz = 0;
+        uint16_t minMhz = 0;
+        Floor floor = Floor::LightSleep;
+        // Bit per Lock.
+        uint8_t heldLocks = 0;
+        // How long each floor was in effect; not time actually spent at that frequency.
+        std::array<uint64_t, FLOOR_COUNT> lockFloorUs = {};
+        std::array<uint32_t, LOCK_COUNT> acquisitions = {};
+        // Handling time of commands that arrived while no lock was held, i.e. while the chip could idle.
+        Latency handlingAfterIdle;
+        // Handling time of commands that arrived while a lock was held.
+        Latency handlingWhileHeld;
+    };
+
+    // Telemetry section: milliseconds each lock floor was in effect since boot, and command handling times.
+    struct Summary
+    {
+        std::array<uint32_t, FLOOR_COUNT> lockFloorMs = {};
+        uint32_t idleHandlingMeanUs = 0;
+        uint32_t idleHandlingMaxUs = 0;
+        uint32_t heldHandlingMeanUs = 0;
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("lockFloorMs", &Summary::lockFloorMs),
+                Reflect::field("idleHandlingMeanUs", &Summary::idleHandlingMeanUs),
+                Reflect::field("idleHandlingMaxUs", &Summary::idleHandlingMaxUs),
+                Reflect::field("heldHandlingMeanUs", &Summary::heldHandlingMeanUs),
+            };
+        }
+    };
+
+    /**
+     * Configures esp_pm between the configured maximum and
+     * CONFIG_RGBW_CTRL_PM_MIN_CPU_MHZ and creates the locks. Without
+     * CONFIG_PM_ENABLE the locks are only accounted.
+     */
+    void begin();
+
+    // Acquires or releases the lock so that it ends up held exactly when `held` is true.
+    void hold(Lock lock, bool held);
+
+    [[nodiscard]] bool isIdle();
+
+    /**
+     * Sleeps between passes of the main loop: CONFIG_RGBW_CTRL_LOOP_DELAY_MS
+     * while a lock is held and CONFIG_RGBW_CTRL_IDLE_LOOP_DELAY_MS otherwise.
+     */
+    void yieldLoop();
+
+    void recordCommand(bool afterIdle, uint32_t durationUs);
+
+    [[nodiscard]] const char* floorName(Floor floor);
+    [[nodiscard]] const char* lockName(Lock lock);
+    [[nodiscard]] Stats getStats();
+    [[nodiscard]] Summary getSummary();
+
+    /**
+     * Times the handling of an inbound command, from the callback that
+     * received it until the outputs are updated, split by whether any lock
+     * was held when it arrived. This is not wake latency: waking from light
+     * sleep and the radio catching the next beacon happen before the
+     * callback and are not measured here.
+     */
+    class CommandScope
+    {
+        const int64_t start = esp_timer_get_time();
+        const bool idle = isIdle();
+
+    public:
+        CommandScope() = default;
+
+        ~CommandScope()
+        {
+            recordCommand(idle, static_cast<uint32_t>(esp_timer_get_time() - start));
+        }
+
+        CommandScope(const CommandScope&) = delete;
+        CommandScope& operator=(const CommandScope&) = delete;
+    };
+}
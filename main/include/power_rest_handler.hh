@@ -0,0 +1,73 @@
+#pragma once
+
+#include "http_manager.hh"
+#include "power.hh"
+
+namespace Power
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_POWER;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                const auto stats = getStats();
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["enabled"] = stats.enabled;
+                root["maxMhz"] = stats.maxMhz;
+                root["minMhz"] = stats.minMhz;
+                root["lockFloor"] = floorName(stats.floor);
+
+                // Derived from the locks held here; not measured residency at each frequency.
+                const auto floors = root["lockFloors"].to<JsonArray>();
+                for (uint8_t i = 0; i < FLOOR_COUNT; ++i)
+                {
+                    const auto entry = floors.add<JsonObject>();
+                    entry["name"] = floorName(static_cast<Floor>(i));
+                    entry["ms"] = stats.lockFloorUs[i] / 1000;
+                }
+
+                const auto locks = root["locks"].to<JsonArray>();
+                for (uint8_t i = 0; i < LOCK_COUNT; ++i)
+                {
+                    const auto entry = locks.add<JsonObject>();
+                    entry["name"] = lockName(static_cast<Lock>(i));
+                    entry["held"] = (stats.heldLocks & 1 << i) != 0;
+                    entry["acquisitions"] = stats.acquisitions[i];
+                }
+
+                // Time from the receiving callback to the outputs being updated; wake-up is not included.
+                const auto handling = root["commandHandling"].to<JsonObject>();
+                fillLatency(handling["afterIdle"].to<JsonObject>(), stats.handlingAfterIdle);
+                fillLatency(handling["whileHeld"].to<JsonObject>(), stats.handlingWhileHeld);
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+
+        private:
+            static void fillLatency(const JsonObject& to, const Latency& latency)
+            {
+                to["count"] = latency.count;
+                to["meanUs"] = latency.meanUs;
+                to["maxUs"] = latency.maxUs;
+            }
+        };
+    };
+}
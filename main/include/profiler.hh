@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <sdkconfig.h>
+
+#include "http_manager.hh"
+#include "reflect.hh"
+
+namespace Profiler
+{
+    enum class Component : uint8_t
+    {
+        BleManager,
+        BoardButton,
+        DeviceManager,
+        OutputManager,
+        WebSocketHandler,
+        AlexaIntegration,
+        BoardLed,
+        Loop,
+        COUNT
+    };
+
+    static constexpr auto COMPONENT_COUNT = static_cast<uint8_t>(Component::COUNT);
+    // Bucket n counts calls that took [2^n, 2^(n+1)) CPU cycles.
+    static constexpr uint8_t HISTOGRAM_BUCKETS = 32;
+    /**
+     * Frequency all cycle counts are expressed at. Dynamic frequency scaling
+     * changes the clock between samples, so each sample is scaled from the
+     * frequency it was taken at.
+     */
+    static constexpr uint16_t REFERENCE_MHZ = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+    using Histogram = std::array<uint32_t, HISTOGRAM_BUCKETS>;
+
+    struct ComponentSummary
+    {
+        uint32_t calls = 0;
+        uint32_t meanCycles = 0;
+        uint32_t maxCycles = 0;
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("calls", &ComponentSummary::calls),
+                Reflect::field("meanCycles", &ComponentSummary::meanCycles),
+                Reflect::field("maxCycles", &ComponentSummary::maxCycles),
+            };
+        }
+    };
+
+    // Telemetry section; Reflect packs it when it is sent.
+    struct Summary
+    {
+        uint8_t enabled = false;
+        // Always REFERENCE_MHZ; kept so the cycle counts can be converted without knowing the build.
+        uint16_t cpuMhz = 0;
+        std::array<ComponentSummary, COMPONENT_COUNT> components = {};
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("enabled", &Summary::enabled),
+                Reflect::field("cpuMhz", &Summary::cpuMhz),
+                Reflect::field("components", &Summary::components),
+            };
+        }
+    };
+
+    struct ComponentStats
+    {
+        uint32_t calls = 0;
+        uint64_t totalCycles = 0;
+        uint32_t maxCycles = 0;
+        Histogram histogram = {};
+    };
+
+    inline std::atomic_bool active = false;
+
+    // Component the main loop is in right now; read by the stall watchdog when the loop stops.
+    inline std::atomic<Component> current = Component::Loop;
+
+    [[nodiscard]] inline bool isEnabled()
+    {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline uint32_t meanCycles(const ComponentStats& stats)
+    {
+        return stats.calls > 0 ? static_cast<uint32_t>(stats.totalCycles / stats.calls) : 0;
+    }
+
+    void setEnabled(bool enabled);
+    void reset();
+    // Records `cycles` counted while the CPU ran at `mhz`.
+    void record(Component component, uint32_t cycles, uint32_t mhz);
+
+    [[nodiscard]] const char* componentName(Component component);
+    [[nodiscard]] ComponentStats getStats(Component component);
+    [[nodiscard]] Summary getSummary();
+
+    /**
+     * Measures the enclosing block in CPU cycles when profiling is enabled.
+     * When it is disabled the cost is a single relaxed load.
+     */
+    class Scope
+    {
+        const Component component;
+        const bool measuring;
+        const uint32_t mhz;
+        const uint32_t start;
+
+    public:
+        explicit Scope(const Component component)
+            : component(component),
+              measuring(isEnabled()),
+              mhz(measuring ? esp_rom_get_cpu_ticks_per_us() : 0),
+              start(measuring ? esp_cpu_get_cycle_count() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (measuring)
+                record(component, esp_cpu_get_cycle_count() - start, mhz);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    template <typename F>
+    void measure(const Component component, F&& function)
+    {
+        const auto previous = current.exchange(component, std::memory_order_relaxed);
+        {
+            Scope scope(component);
+            function();
+        }
+        current.store(previous, std::memory_order_relaxed);
+    }
+
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_PROFILE;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                if (request->hasParam("enabled"))
+                    setEnabled(request->getParam("enabled")->value().toInt() != 0);
+                if (request->hasParam("reset"))
+                    reset();
+
+                constexpr uint16_t cpuMhz = REFERENCE_MHZ;
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["enabled"] = isEnabled();
+                root["cpuMhz"] = cpuMhz;
+                const auto components = root["components"].to<JsonArray>();
+                for (uint8_t i = 0; i < COMPONENT_COUNT; ++i)
+                {
+                    const auto component = static_cast<Component>(i);
+                    // One copy per entry, so the mean, maximum and percentiles describe the same samples.
+                    const auto stats = getStats(component);
+                    const auto entry = components.add<JsonObject>();
+                    entry["name"] = componentName(component);
+                    entry["calls"] = stats.calls;
+                    entry["meanUs"] = toMicros(meanCycles(stats), cpuMhz);
+                    entry["maxUs"] = toMicros(stats.maxCycles, cpuMhz);
+                    entry["p50Us"] = toMicros(percentile(stats, 50), cpuMhz);
+                    entry["p99Us"] = toMicros(percentile(stats, 99), cpuMhz);
+                    const auto histogram = entry["histogram"].to<JsonArray>();
+                    uint8_t last = HISTOGRAM_BUCKETS;
+                    while (last > 0 && stats.histogram[last - 1] == 0) last--;
+                    for (uint8_t bucket = 0; bucket < last; ++bucket)
+                        histogram.add(stats.histogram[bucket]);
+                }
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+
+        private:
+            static float toMicros(const uint32_t cycles, const uint16_t cpuMhz)
+            {
+                return cpuMhz > 0 ? static_cast<float>(cycles) / static_cast<float>(cpuMhz) : 0.0f;
+            }
+
+            // Upper bound of the bucket holding the requested percentile.
+            static uint32_t percentile(const ComponentStats& stats, const uint8_t percent)
+            {
+                if (stats.calls == 0) return 0;
+                const auto target = (static_cast<uint64_t>(stats.calls) * percent + 99) / 100;
+                uint64_t seen = 0;
+                for (uint8_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket)
+                {
+                    seen += stats.histogram[bucket];
+                    if (seen < target) continue;
+                    const uint32_t upper = bucket == HISTOGRAM_BUCKETS - 1 ? UINT32_MAX : (2u << bucket) - 1;
+                    return std::min(upper, stats.maxCycles);
+                }
+                return stats.maxCycles;
+            }
+        };
+    };
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <Arduino.h>
-#include <functional>
+#include "delegate.hh"
 
 class PushButton
 {
@@ -15,10 +15,10 @@ class PushButton
     unsigned long longPressThresholdMs = 2500;
     unsigned long debounceDelayMs = 50;
 
-    std::function<void()> longPressCallback;
-    std::function<void()> shortPressCallback;
+    Delegate<void()> longPressCallback;
+    Delegate<void()> shortPressCallback;
 
-    static void maybeInvoke(const std::function<void()>& cb)
+    static void maybeInvoke(const Delegate<void()>& cb)
     {
         if (cb) cb();
     }
@@ -30,12 +30,12 @@ public:
         pinMode(this->pin, INPUT_PULLUP);
     }
 
-    void setLongPressCallback(const std::function<void()>& callback)
+    void setLongPressCallback(const Delegate<void()>& callback)
     {
         longPressCallback = callback;
     }
 
-    void setShortPressCallback(const std::function<void()>& callback)
+    void setShortPressCallback(const Delegate<void()>& callback)
     {
         shortPressCallback = callback;
     }
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <ArduinoJson.h>
+#include <IPAddress.h>
+#include <Preferences.h>
+
+/**
+ * Field descriptors for the structs that travel over BLE, WebSocket, REST
+ * and NVS. A struct lists its members once, in declaration order, from a
+ * static constexpr fields(); the binary codec, the JSON writer and the NVS
+ * blob are all expanded from that list at compile time. The codec is
+ * explicitly little-endian, and checkLayout() proves that the list covers
+ * the packed struct byte for byte, so the wire format cannot drift from
+ * the struct without a build error.
+ */
+namespace Reflect
+{
+    template <typename Owner, typename Member, typename Writer = std::nullptr_t>
+    struct Field
+    {
+        using Type = Member;
+
+        const char* name;
+        Member Owner::* member;
+        // Writes the member to JSON instead of the default for its type.
+        Writer writer;
+    };
+
+    template <typename Owner, typename Member>
+    constexpr auto field(const char* name, Member Owner::* member)
+    {
+        return Field<Owner, Member>{name, member, nullptr};
+    }
+
+    // `writer` is called as writer(JsonVariant, const Member&).
+    template <typename Owner, typename Member, typename Writer>
+    constexpr auto field(const char* name, Member Owner::* member, Writer writer)
+    {
+        return Field<Owner, Member, Writer>{name, member, writer};
+    }
+
+    template <typename T>
+    concept Described = requires { T::fields(); };
+
+    template <typename T>
+    struct IsArray : std::false_type
+    {
+    };
+
+    template <typename E, size_t N>
+    struct IsArray<std::array<E, N>> : std::true_type
+    {
+    };
+
+    template <typename T>
+    struct IsText : std::false_type
+    {
+    };
+
+    template <size_t N>
+    struct IsText<std::array<char, N>> : std::true_type
+    {
+    };
+
+    template <typename T>
+    concept Scalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+    // Bytes `T` takes on the wire.
+    template <typename T>
+    constexpr size_t wireSize()
+    {
+        if constexpr (Described<T>)
+            return std::apply([](const auto&... fields)
+            {
+                return (size_t{0} + ... + wireSize<typename std::remove_cvref_t<decltype(fields)>::Type>());
+            }, T::fields());
+        else if constexpr (IsArray<T>::value)
+            return std::tuple_size_v<T> * wireSize<typename T::value_type>();
+        else
+        {
+            static_assert(Scalar<T>, "Only numbers, enums, std::array and described structs can be reflected");
+            return sizeof(T);
+        }
+    }
+
+    /**
+     * True when the fields cover `T` without gaps, i.e. the struct is packed
+     * and none of its members is missing from fields().
+     */
+    template <typename T>
+    constexpr bool checkLayout()
+    {
+        return std::is_trivially_copyable_v<T> && wireSize<T>() == sizeof(T);
+    }
+
+    // FNV-1a over the field names and sizes: changes whenever the layout does.
+    template <typename T>
+    constexpr uint32_t signature(uint32_t hash = 2166136261u)
+    {
+        const auto mix = [&hash](const uint32_t byte) { hash = (hash ^ byte) * 16777619u; };
+        if constexpr (Described<T>)
+        {
+            std::apply([&](const auto&... fields)
+            {
+                ([&](const auto& field)
+                {
+                    for (auto name = field.name; *name; ++name) mix(static_cast<uint8_t>(*name));
+                    hash = signature<typename std::remove_cvref_t<decltype(field)>::Type>(hash);
+                }(fields), ...);
+            }, T::fields());
+        }
+        else
+        {
+            for (auto size = wireSize<T>(); size; size >>= 8) mix(size & 0xFF);
+        }
+        return hash;
+    }
+
+    template <typename T>
+    using Buffer = std::array<uint8_t, wireSize<T>()>;
+
+    namespace Detail
+    {
+        /*
+         * Members of packed structs can sit at any address, so the walkers
+         * below pass raw addresses around and only touch a scalar through an
+         * aligned copy; binding a uint32_t& to one of them would fault on
+         * Xtensa. Described structs are either packed (alignment 1) or
+         * naturally aligned, so only scalar members can be misaligned.
+         */
+        template <typename T>
+        using Bits = std::conditional_t<sizeof(T) == 1, uint8_t,
+                                        std::conditional_t<sizeof(T) == 2, uint16_t,
+                                                           std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+        // Address of `field` in the `Owner` at `owner`; the built-in & neither loads nor binds a reference.
+        template <typename Owner, typename Field>
+        const uint8_t* memberAt(const uint8_t* owner, const Field& field)
+        {
+            return reinterpret_cast<const uint8_t*>(&(reinterpret_cast<const Owner*>(owner)->*field.member));
+        }
+
+        template <typename Owner, typename Field>
+        uint8_t* memberAt(uint8_t* owner, const Field& field)
+        {
+            return reinterpret_cast<uint8_t*>(&(reinterpret_cast<Owner*>(owner)->*field.member));
+        }
+
+        template <typename T>
+        T load(const uint8_t* at)
+        {
+            T value;
+            memcpy(&value, at, sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        uint8_t* encode(const uint8_t* value, uint8_t* out)
+        {
+            if constexpr (Described<T>)
+            {
+                std::apply([&](const auto&... fields)
+                {
+                    ((out = encode<typename std::remove_cvref_t<decltype(fields)>::Type>(
+                        memberAt<T>(value, fields), out)), ...);
+                }, T::fields());
+                return out;
+            }
+            else if constexpr (IsArray<T>::value)
+            {
+                using Element = typename T::value_type;
+                for (size_t i = 0; i < std::tuple_size_v<T>; ++i)
+                    out = encode<Element>(value + i * sizeof(Element), out);
+                return out;
+            }
+            else
+            {
+                auto bits = std::bit_cast<Bits<T>>(load<T>(value));
+                for (size_t i = 0; i < sizeof(T); ++i, bits >>= 8) *out++ = static_cast<uint8_t>(bits);
+                return out;
+            }
+        }
+
+        template <typename T>
+        const uint8_t* decode(const uint8_t* in, uint8_t* value)
+        {
+            if constexpr (Described<T>)
+            {
+                std::apply([&](const auto&... fields)
+                {
+                    ((in = decode<typename std::remove_cvref_t<decltype(fields)>::Type>(
+                        in, memberAt<T>(value, fields))), ...);
+                }, T::fields());
+                return in;
+            }
+            else if constexpr (IsArray<T>::value)
+            {
+                using Element = typename T::value_type;
+                for (size_t i = 0; i < std::tuple_size_v<T>; ++i)
+                    in = decode<Element>(in, value + i * sizeof(Element));
+                return in;
+            }
+            else
+            {
+                T decoded;
+                if constexpr (std::is_same_v<T, bool>)
+                {
+                    decoded = *in != 0;
+                }
+                else
+                {
+                    Bits<T> bits = 0;
+                    for (size_t i = 0; i < sizeof(T); ++i) bits |= static_cast<Bits<T>>(in[i]) << (8 * i);
+                    decoded = std::bit_cast<T>(bits);
+                }
+                memcpy(value, &decoded, sizeof(T));
+                return in + sizeof(T);
+            }
+        }
+
+        template <typename T>
+        void toJson(const uint8_t* value, JsonVariant to)
+        {
+            if constexpr (Described<T>)
+            {
+                const auto object = to.to<JsonObject>();
+                std::apply([&](const auto&... fields)
+                {
+                    ([&](const auto& field)
+                    {
+                        using Member = typename std::remove_cvref_t<decltype(field)>::Type;
+                        const auto member = object[field.name].template to<JsonVariant>();
+                        if constexpr (std::is_null_pointer_v<decltype(field.writer)>)
+                            toJson<Member>(memberAt<T>(value, field), member);
+                        else
+                            field.writer(member, load<Member>(memberAt<T>(value, field)));
+                    }(fields), ...);
+                }, T::fields());
+            }
+            else if constexpr (IsText<T>::value)
+            {
+                // Text buffers need not be terminated when they are full.
+                char text[std::tuple_size_v<T> + 1];
+                const auto length = strnlen(reinterpret_cast<const char*>(value), std::tuple_size_v<T>);
+                memcpy(text, value, length);
+                text[length] = '\0';
+                to.set(static_cast<const char*>(text));
+            }
+            else if constexpr (IsArray<T>::value)
+            {
+                using Element = typename T::value_type;
+                const auto array = to.to<JsonArray>();
+                for (size_t i = 0; i < std::tuple_size_v<T>; ++i)
+                    toJson<Element>(value + i * sizeof(Element), array.add<JsonVariant>());
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                to.set(static_cast<std::underlying_type_t<T>>(load<T>(value)));
+            }
+            else
+            {
+                to.set(load<T>(value));
+            }
+        }
+    }
+
+    // Writes `value` to `out` and returns the end of what was written.
+    template <typename T>
+    uint8_t* encode(const T& value, uint8_t* out)
+    {
+        return Detail::encode<T>(reinterpret_cast<const uint8_t*>(&value), out);
+    }
+
+    // Reads `value` from `in` and returns the end of what was read.
+    template <typename T>
+    const uint8_t* decode(const uint8_t* in, T& value)
+    {
+        return Detail::decode<T>(in, reinterpret_cast<uint8_t*>(&value));
+    }
+
+    template <typename T>
+    Buffer<T> encode(const T& value)
+    {
+        Buffer<T> buffer;
+        encode(value, buffer.data());
+        return buffer;
+    }
+
+    // Leaves `value` untouched and returns false unless `length` is exactly the wire size.
+    template <typename T>
+    bool decode(const uint8_t* data, const size_t length, T& value)
+    {
+        if (data == nullptr || length != wireSize<T>()) return false;
+        decode(data, value);
+        return true;
+    }
+
+    template <typename T>
+    void toJson(const T& value, JsonVariant to)
+    {
+        Detail::toJson<T>(reinterpret_cast<const uint8_t*>(&value), to);
+    }
+
+    /**
+     * Stores `value` in NVS behind its layout signature, so a blob written by
+     * firmware with a different layout is never decoded into the new one.
+     */
+    template <typename T>
+    bool save(Preferences& prefs, const char* key, const T& value)
+    {
+        std::array<uint8_t, sizeof(uint32_t) + wireSize<T>()> blob;
+        encode(value, encode(signature<T>(), blob.data()));
+        return prefs.putBytes(key, blob.data(), blob.size()) == blob.size();
+    }
+
+    template <typename T>
+    bool load(Preferences& prefs, const char* key, T& value)
+    {
+        std::array<uint8_t, sizeof(uint32_t) + wireSize<T>()> blob;
+        if (prefs.getBytesLength(key) != blob.size()) return false;
+        if (prefs.getBytes(key, blob.data(), blob.size()) != blob.size()) return false;
+        uint32_t stored;
+        decode(blob.data(), stored);
+        if (stored != signature<T>()) return false;
+        decode(blob.data() + sizeof(uint32_t), value);
+        return true;
+    }
+
+    // JSON writers shared by several structs.
+    namespace Format
+    {
+        inline void mac(JsonVariant to, const std::array<uint8_t, 6>& address)
+        {
+            char text[18];
+            snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     address[0], address[1], address[2], address[3], address[4], address[5]);
+            to.set(static_cast<const char*>(text));
+        }
+
+        // An IPv4 address as stored from IPAddress, first octet in the lowest byte.
+        inline void ip(JsonVariant to, const uint32_t address)
+        {
+            to.set(IPAddress(address).toString());
+        }
+    }
+}
@@ -2,13 +2,15 @@
 
 #include <iot_knob.h>
 
+#include "delegate.hh"
+
 class RotaryEncoderManager
 {
     static constexpr const char* LOG_TAG = "RotaryEncoderManager";
     knob_handle_t knob;
 
-    std::function<void()> turnLeftCallback;
-    std::function<void()> turnRightCallback;
+    Delegate<void()> turnLeftCallback;
+    Delegate<void()> turnRightCallback;
 
     static void _knob_left_cb(void* arg, void* data)
     {
@@ -64,17 +66,17 @@ public:
         // think
     }
 
-    void onTurnLeft(const std::function<void()>& callback)
+    void onTurnLeft(const Delegate<void()>& callback)
     {
         this->turnLeftCallback = callback;
     }
 
-    void onTurnRight(const std::function<void()>& callback)
+    void onTurnRight(const Delegate<void()>& callback)
     {
         this->turnRightCallback = callback;
     }
 
-    // void onPressed(const std::function<void(unsigned long)>& callback)
+    // void onPressed(const Delegate<void(unsigned long)>& callback)
     // {
     //     this->rotaryEncoder.onPressed(callback);
     // }
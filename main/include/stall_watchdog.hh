@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <freertos/FreeRTOS.h> // NOLINT
+#include <freertos/task.h>
+
+/**
+ * Watches the main loop for passes that take longer than
+ * CONFIG_RGBW_CTRL_STALL_THRESHOLD_MS. A supervisor task on the loop's core,
+ * at a higher priority, checks the loop's heartbeat; once it is overdue the
+ * loop task is switched out, so its backtrace can be walked from the saved
+ * context. The component the loop was in (Profiler::current) and the
+ * backtrace go into a ring in RTC memory, which survives the software or
+ * watchdog reset that a long stall often ends in.
+ *
+ * A loop spinning with interrupts disabled keeps the supervisor from running
+ * as well; the interrupt watchdog covers that case.
+ */
+namespace StallWatchdog
+{
+    static constexpr uint8_t CAPACITY = 8;
+    static constexpr uint8_t MAX_DEPTH = 16;
+    static constexpr uint8_t NAME_LENGTH = 20;
+
+    // Naturally aligned, so the backtrace can be written and read in place; the ring lives in RTC memory as is.
+    struct Record
+    {
+        // Boot counter value of the boot the stall happened in.
+        uint32_t boot;
+        // Uptime when the loop's last pass started.
+        uint32_t startMs;
+        // Updated while the stall lasts; final once `recovered` is set.
+        uint32_t durationMs;
+        std::array<uint32_t, MAX_DEPTH> backtrace;
+        uint8_t recovered;
+        uint8_t depth;
+        std::array<char, NAME_LENGTH> component;
+        std::array<uint8_t, 2> reserved;
+    };
+
+    static_assert(offsetof(Record, backtrace) % alignof(uint32_t) == 0, "Record::backtrace must be aligned");
+    static_assert(sizeof(Record) % alignof(uint32_t) == 0, "Records must stay aligned in an array");
+    static_assert(sizeof(Record) == 12 + MAX_DEPTH * sizeof(uint32_t) + 2 + NAME_LENGTH + 2,
+                  "Record must not contain implicit padding");
+
+    /**
+     * Validates the ring kept from the previous boot, clearing it when the
+     * checksum fails (e.g. after power-on), and starts the supervisor watching
+     * `loopTask`.
+     */
+    void begin(TaskHandle_t loopTask);
+
+    // Called at the start of every pass of the main loop.
+    void beat();
+
+    void clear();
+
+    [[nodiscard]] uint32_t getBoot();
+
+    /**
+     * Copies the recorded stalls, newest first, and returns how many were copied.
+     */
+    uint8_t getRecords(std::array<Record, CAPACITY>& out);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "http_manager.hh"
+#include "stall_watchdog.hh"
+
+namespace StallWatchdog
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_STALLS;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                if (request->hasParam("clear"))
+                    clear();
+
+                const auto boot = getBoot();
+                std::array<Record, CAPACITY> records;
+                const auto count = getRecords(records);
+
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["thresholdMs"] = CONFIG_RGBW_CTRL_STALL_THRESHOLD_MS;
+                root["boot"] = boot;
+
+                const auto stalls = root["stalls"].to<JsonArray>();
+                for (uint8_t i = 0; i < count; ++i)
+                {
+                    const auto& record = records[i];
+                    const auto entry = stalls.add<JsonObject>();
+                    entry["boot"] = record.boot;
+                    entry["previousBoot"] = record.boot != boot;
+                    entry["startMs"] = record.startMs;
+                    entry["durationMs"] = record.durationMs;
+                    entry["recovered"] = record.recovered != 0;
+                    entry["component"] = record.component.data();
+
+                    // Same format as a panic backtrace, so it can be fed to addr2line.
+                    char address[11];
+                    const auto backtrace = entry["backtrace"].to<JsonArray>();
+                    for (uint8_t j = 0; j < record.depth; ++j)
+                    {
+                        snprintf(address, sizeof(address), "0x%08lx", static_cast<unsigned long>(record.backtrace[j]));
+                        backtrace.add(address);
+                    }
+                }
+
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
+}
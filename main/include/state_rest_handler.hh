@@ -4,6 +4,7 @@
 #include <AsyncJson.h>
 
 #include "wifi_manager.hh"
+#include "heap_accounting.hh"
 
 class StateRestHandler final : public HTTP::AsyncWebHandlerCreator
 {
@@ -20,9 +21,19 @@ public:
         return new AsyncRestWebHandler(this);
     }
 
+    void fillState(const JsonObject& root) const
+    {
+        for (const auto& filler : jsonStateFillers)
+        {
+            filler->fillState(root);
+        }
+    }
+
 private:
     class AsyncRestWebHandler final : public AsyncWebHandler
     {
+        static constexpr auto ACCEPT_HEADER = "Accept";
+
         StateRestHandler* restHandler;
 
     public:
@@ -38,15 +49,23 @@ private:
 
         void handleRequest(AsyncWebServerRequest* request) override
         {
-            const auto response = new AsyncJsonResponse();
-            const auto doc = response->getRoot().to<JsonObject>();
-            for (const auto& filler : restHandler->jsonStateFillers)
-            {
-                filler->fillState(doc);
-            }
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Http);
+            const auto response = new Json::PooledResponse(false, negotiateFormat(request));
+            restHandler->fillState(response->getRoot().to<JsonObject>());
             response->addHeader("Cache-Control", "no-store");
+            response->addHeader("Vary", ACCEPT_HEADER);
             response->setLength();
             request->send(response);
         }
+
+        // Pollers that ask for MessagePack get the same document without the cost of parsing JSON.
+        static Json::Format negotiateFormat(const AsyncWebServerRequest* request)
+        {
+            if (!request->hasHeader(ACCEPT_HEADER)) return Json::Format::Json;
+            const auto& accept = request->header(ACCEPT_HEADER);
+            if (accept.indexOf("application/msgpack") >= 0 || accept.indexOf("application/x-msgpack") >= 0)
+                return Json::Format::MsgPack;
+            return Json::Format::Json;
+        }
     };
 };
@@ -1,11 +1,286 @@
 #pragma once
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <freertos/FreeRTOS.h> // NOLINT
+#include <freertos/task.h>
 
-void print_task_stats(void);
+#include "http_manager.hh"
+#include "task_registry.hh"
 
-#ifdef __cplusplus
+namespace TaskMonitor
+{
+    static constexpr uint8_t MAX_TASKS = 24;
+    static constexpr uint8_t NAME_LENGTH = configMAX_TASK_NAME_LEN;
+
+#pragma pack(push, 1)
+    struct Entry
+    {
+        std::array<char, NAME_LENGTH> name = {};
+        int8_t core = -1;
+        uint8_t priority = 0;
+        uint8_t state = eInvalid;
+        // Share of the CPU time of all cores together, so the tasks add up to 1000.
+        uint16_t cpuPermille = 0;
+        uint32_t stackHighWaterMark = 0;
+    };
+
+    struct Snapshot
+    {
+        uint32_t sequence = 0;
+        uint32_t windowMs = 0;
+        uint8_t count = 0;
+        // Tasks the kernel reported; more than `count` when some did not fit into `entries`.
+        uint8_t total = 0;
+        std::array<Entry, MAX_TASKS> entries = {};
+
+        [[nodiscard]] bool isTruncated() const
+        {
+            return count < total;
+        }
+
+        // Bytes of the snapshot up to its last entry; the unused entries are not sent.
+        [[nodiscard]] size_t usedSize() const
+        {
+            return sizeof(Snapshot) - sizeof(entries) + count * sizeof(Entry);
+        }
+    };
+#pragma pack(pop)
+
+    /**
+     * Samples uxTaskGetSystemState() periodically and keeps per-task CPU usage over a
+     * sliding window, stack high-water marks and states in a fixed array.
+     * Nothing is formatted on the device unless a client asks for JSON.
+     *
+     * uxTaskGetSystemState() fills in nothing when its array is too small, so
+     * the status array grows with the task count. The snapshot keeps at most
+     * MAX_TASKS entries and reports the total, so a truncated list is visible.
+     */
+    class Sampler final : public HTTP::AsyncWebHandlerCreator
+    {
+        static constexpr auto LOG_TAG = "TaskMonitor";
+        static constexpr uint32_t SAMPLE_INTERVAL_MS = 1000;
+        static constexpr uint8_t WINDOW_SAMPLES = 5;
+        // Spare room in the status array for tasks created before the next sample.
+        static constexpr UBaseType_t STATUS_HEADROOM = 4;
+
+        struct Slot
+        {
+            TaskHandle_t handle = nullptr;
+            std::array<uint32_t, WINDOW_SAMPLES> runTime = {};
+            uint8_t filled = 0;
+        };
+
+        // Only touched by the sampler task; grows, never shrinks.
+        std::unique_ptr<TaskStatus_t[]> statuses;
+        UBaseType_t capacity = 0;
+        std::array<Slot, MAX_TASKS> slots = {};
+        std::array<uint32_t, WINDOW_SAMPLES> totalRunTime = {};
+        uint8_t head = 0;
+        uint8_t filled = 0;
+
+        mutable std::mutex snapshotMutex;
+        Snapshot snapshot;
+        // Declared spec of each snapshot entry, resolved from its handle while sampling; entries go on the wire as is.
+        std::array<const Tasks::Spec*, MAX_TASKS> specs = {};
+
+    public:
+        void begin()
+        {
+            Tasks::spawn(Tasks::Plan::TASK_MONITOR, taskLoop, this);
+        }
+
+        [[nodiscard]] Snapshot getSnapshot() const
+        {
+            std::lock_guard lock(snapshotMutex);
+            return snapshot;
+        }
+
+        // Also copies the spec of each entry, nullptr for tasks not created through the registry.
+        [[nodiscard]] Snapshot getSnapshot(std::array<const Tasks::Spec*, MAX_TASKS>& entrySpecs) const
+        {
+            std::lock_guard lock(snapshotMutex);
+            entrySpecs = specs;
+            return snapshot;
+        }
+
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler(this);
+        }
+
+        [[nodiscard]] static const char* stateString(const uint8_t state)
+        {
+            switch (state)
+            {
+            case eRunning: return "running";
+            case eReady: return "ready";
+            case eBlocked: return "blocked";
+            case eSuspended: return "suspended";
+            case eDeleted: return "deleted";
+            default: return "invalid";
+            }
+        }
+
+    private:
+        [[noreturn]] static void taskLoop(void* arg)
+        {
+            auto* self = static_cast<Sampler*>(arg);
+            while (true) // NOLINT
+            {
+                self->sample();
+                vTaskDelay(pdMS_TO_TICKS(SAMPLE_INTERVAL_MS));
+            }
+        }
+
+        void sample()
+        {
+            if (const auto tasks = uxTaskGetNumberOfTasks(); tasks > capacity)
+            {
+                capacity = tasks + STATUS_HEADROOM;
+                statuses.reset(new TaskStatus_t[capacity]);
+            }
+            uint32_t total = 0;
+            const auto count = uxTaskGetSystemState(statuses.get(), capacity, &total);
+            // More tasks were created since the count was taken than the headroom covers; the array grows next time.
+            if (count == 0) return;
+
+            head = (head + 1) % WINDOW_SAMPLES;
+            totalRunTime[head] = total;
+            if (filled < WINDOW_SAMPLES) filled++;
+
+            releaseVanishedSlots(count);
+
+            Snapshot next;
+            std::array<const Tasks::Spec*, MAX_TASKS> nextSpecs = {};
+            next.windowMs = (filled - 1) * SAMPLE_INTERVAL_MS;
+            next.total = static_cast<uint8_t>(std::min<UBaseType_t>(count, UINT8_MAX));
+            for (UBaseType_t i = 0; i < count && next.count < MAX_TASKS; ++i)
+            {
+                const auto& status = statuses[i];
+                auto* slot = acquireSlot(status.xHandle);
+                if (slot == nullptr) continue;
+
+                slot->runTime[head] = status.ulRunTimeCounter;
+                if (slot->filled < WINDOW_SAMPLES) slot->filled++;
+                const uint8_t window = std::min(slot->filled, filled);
+                const uint8_t first = (head + WINDOW_SAMPLES - window + 1) % WINDOW_SAMPLES;
+                const uint32_t slotDelta = status.ulRunTimeCounter - slot->runTime[first];
+                // The total is wall time, and every core adds up to it, so it is scaled to the capacity of all cores.
+                const uint64_t slotTotal = static_cast<uint64_t>(total - totalRunTime[first]) * portNUM_PROCESSORS;
+
+                nextSpecs[next.count] = Tasks::findSpec(status.xHandle);
+                auto& entry = next.entries[next.count++];
+                strncpy(entry.name.data(), status.pcTaskName, NAME_LENGTH - 1);
+                const auto core = xTaskGetCoreID(status.xHandle);
+                entry.core = core == tskNO_AFFINITY ? -1 : static_cast<int8_t>(core);
+                entry.priority = static_cast<uint8_t>(status.uxCurrentPriority);
+                entry.state = static_cast<uint8_t>(status.eCurrentState);
+                entry.stackHighWaterMark = status.usStackHighWaterMark;
+                entry.cpuPermille = slotTotal > 0 && window > 1
+                                        ? static_cast<uint16_t>(std::min<uint64_t>(
+                                            static_cast<uint64_t>(slotDelta) * 1000 / slotTotal, 1000))
+                                        : 0;
+            }
+
+            std::lock_guard lock(snapshotMutex);
+            next.sequence = snapshot.sequence + 1;
+            snapshot = next;
+            specs = nextSpecs;
+        }
+
+        Slot* acquireSlot(TaskHandle_t handle)
+        {
+            Slot* freeSlot = nullptr;
+            for (auto& slot : slots)
+            {
+                if (slot.handle == handle) return &slot;
+                if (slot.handle == nullptr && freeSlot == nullptr) freeSlot = &slot;
+            }
+            if (freeSlot == nullptr) return nullptr;
+            *freeSlot = {};
+            freeSlot->handle = handle;
+            return freeSlot;
+        }
+
+        void releaseVanishedSlots(const UBaseType_t count)
+        {
+            for (auto& slot : slots)
+            {
+                if (slot.handle == nullptr) continue;
+                bool alive = false;
+                for (UBaseType_t i = 0; i < count && !alive; ++i)
+                    alive = statuses[i].xHandle == slot.handle;
+                if (!alive) slot = {};
+            }
+        }
+
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+            Sampler* sampler;
+
+        public:
+            explicit AsyncRestWebHandler(Sampler* sampler) : sampler(sampler)
+            {
+            }
+
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_TASKS;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                std::array<const Tasks::Spec*, MAX_TASKS> specs;
+                const auto snapshot = sampler->getSnapshot(specs);
+                if (request->hasParam("format") && request->getParam("format")->value() == "binary")
+                    return sendBinary(request, snapshot);
+                sendJson(request, snapshot, specs);
+            }
+
+        private:
+            static void sendBinary(AsyncWebServerRequest* request, const Snapshot& snapshot)
+            {
+                const auto size = snapshot.usedSize();
+                const auto response = request->beginResponseStream("application/octet-stream", size);
+                response->write(reinterpret_cast<const uint8_t*>(&snapshot), size);
+                response->addHeader("Cache-Control", "no-store");
+                request->send(response);
+            }
+
+            static void sendJson(AsyncWebServerRequest* request, const Snapshot& snapshot,
+                                 const std::array<const Tasks::Spec*, MAX_TASKS>& specs)
+            {
+                const auto response = new Json::PooledResponse();
+                const auto root = response->getRoot().to<JsonObject>();
+                root["sequence"] = snapshot.sequence;
+                root["windowMs"] = snapshot.windowMs;
+                root["total"] = snapshot.total;
+                root["truncated"] = snapshot.isTruncated();
+                const auto tasks = root["tasks"].to<JsonArray>();
+                for (uint8_t i = 0; i < snapshot.count; ++i)
+                {
+                    const auto& entry = snapshot.entries[i];
+                    const auto task = tasks.add<JsonObject>();
+                    task["name"] = entry.name.data();
+                    task["core"] = entry.core;
+                    task["priority"] = entry.priority;
+                    task["state"] = stateString(entry.state);
+                    task["cpu"] = static_cast<float>(entry.cpuPermille) / 10.0f;
+                    task["stackHighWaterMark"] = entry.stackHighWaterMark;
+                    if (const auto* spec = specs[i])
+                    {
+                        task["declaredCore"] = spec->core;
+                        task["declaredPriority"] = spec->priority;
+                    }
+                }
+                response->addHeader("Cache-Control", "no-store");
+                response->setLength();
+                request->send(response);
+            }
+        };
+    };
 }
-#endif
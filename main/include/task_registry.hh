@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <sdkconfig.h>
+#include <freertos/FreeRTOS.h> // NOLINT
+#include <freertos/task.h>
+
+#include "worker_pool.hh"
+
+namespace Tasks
+{
+    struct Spec
+    {
+        const char* name;
+        BaseType_t core;
+        UBaseType_t priority;
+        uint32_t stackSize;
+    };
+
+    namespace Core
+    {
+        constexpr BaseType_t NETWORK = CONFIG_RGBW_CTRL_NETWORK_CORE;
+        constexpr BaseType_t LIGHTS = CONFIG_RGBW_CTRL_OUTPUT_CORE;
+    }
+
+    // Every task created by the firmware is declared here, next to its placement.
+    // Wi-Fi, lwIP, async_tcp and NimBLE are pinned to the network core through sdkconfig.
+    namespace Plan
+    {
+        constexpr Spec LOOP{"loopTask", Core::LIGHTS, 1, CONFIG_ARDUINO_LOOP_STACK_SIZE};
+        constexpr Spec TOGGLE_SWITCH{"ToggleSwitchTask", Core::LIGHTS, 1, 2048};
+        constexpr Spec ASYNC_WORKER{"AsyncWorker", Core::NETWORK, 1, Async::WORKER_STACK_SIZE};
+        constexpr Spec WIFI_SCAN_NOTIFIER{"WifiScanNotifier", Core::NETWORK, 1, 4096};
+        constexpr Spec TASK_MONITOR{"TaskMonitor", Core::NETWORK, 1, 3072};
+        // Well above the other firmware tasks on the output core, so it preempts a stuck loop.
+        constexpr Spec STALL_WATCHDOG{"StallWatchdog", Core::LIGHTS, 20, 3072};
+        constexpr Spec LOG_DRAIN{"LogDrain", Core::NETWORK, 1, 3072};
+    }
+
+    /**
+     * Creates a task pinned to the core declared in `spec` and records it in the registry.
+     */
+    bool spawn(const Spec& spec, TaskFunction_t function, void* arg, TaskHandle_t* handle = nullptr);
+
+    /**
+     * Records a task created elsewhere (e.g. the Arduino loop task) under `spec`.
+     */
+    void adopt(const Spec& spec, TaskHandle_t handle);
+
+    void remove(TaskHandle_t handle);
+
+    [[nodiscard]] const Spec* findSpec(TaskHandle_t handle);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <esp_system.h>
+
+#include "profiler.hh"
+#include "heap_accounting.hh"
+#include "load_shedding.hh"
+#include "power.hh"
+#include "reflect.hh"
+
+namespace Telemetry
+{
+    /**
+     * Fixed-layout frame pushed to WebSocket clients; sections are appended
+     * at the end so older clients can keep reading the fields they know.
+     * The sections stay naturally aligned here and are packed by Reflect.
+     */
+    struct Frame
+    {
+        uint32_t sequence = 0;
+        uint32_t uptimeMs = 0;
+        uint32_t freeHeap = 0;
+        Profiler::Summary profile;
+        HeapAccounting::Summary heap;
+        Power::Summary power;
+        LoadShedding::Counters shedding;
+
+        static constexpr auto fields()
+        {
+            return std::tuple{
+                Reflect::field("sequence", &Frame::sequence),
+                Reflect::field("uptimeMs", &Frame::uptimeMs),
+                Reflect::field("freeHeap", &Frame::freeHeap),
+                Reflect::field("profile", &Frame::profile),
+                Reflect::field("heap", &Frame::heap),
+                Reflect::field("power", &Frame::power),
+                Reflect::field("shedding", &Frame::shedding),
+            };
+        }
+    };
+
+    class Collector
+    {
+        uint32_t sequence = 0;
+
+    public:
+        [[nodiscard]] Frame collect(const unsigned long now)
+        {
+            Frame frame;
+            frame.sequence = ++sequence;
+            frame.uptimeMs = now;
+            frame.freeHeap = esp_get_free_heap_size();
+            frame.profile = Profiler::getSummary();
+            frame.heap = HeapAccounting::getSummary();
+            frame.power = Power::getSummary();
+            frame.shedding = LoadShedding::getCounters();
+            return frame;
+        }
+    };
+}
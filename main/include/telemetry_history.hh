@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#include "delegate.hh"
+
+/**
+ * Fixed-size history of the controller's vitals kept in RAM at two
+ * resolutions: one sample per second for the last few minutes and one per
+ * minute for the last few hours. Minute samples are folded from the second
+ * samples as they are taken, so nothing is stored twice at full rate.
+ * The dashboard downloads a tier once from /system/history and then only
+ * asks for the samples it has not seen yet.
+ */
+namespace TelemetryHistory
+{
+    enum class Tier : uint8_t
+    {
+        Seconds,
+        Minutes,
+        COUNT
+    };
+
+    static constexpr auto TIER_COUNT = static_cast<uint8_t>(Tier::COUNT);
+    static constexpr uint16_t SECONDS_CAPACITY = CONFIG_RGBW_CTRL_HISTORY_SECONDS;
+    static constexpr uint16_t MINUTES_CAPACITY = CONFIG_RGBW_CTRL_HISTORY_MINUTES;
+    static constexpr uint16_t HEAP_UNIT = 16;
+    static constexpr uint32_t MAGIC = 0x54534948; // "HIST"
+    static constexpr uint8_t FORMAT_VERSION = 1;
+
+#pragma pack(push, 1)
+    struct Sample
+    {
+        // Free heap and largest free block at the end of the interval (minimum for minutes), in HEAP_UNIT bytes.
+        // A free heap of 0 marks a sample that was overwritten while it was being downloaded.
+        uint16_t freeHeap = 0;
+        uint16_t largestBlock = 0;
+        // Input voltage before the calibration factor from the file header is applied.
+        uint16_t inputMilliVolts = 0;
+        // Mean over the connected part of the interval; 0 when Wi-Fi was not connected at all.
+        int8_t rssi = 0;
+        uint8_t connectedPercent = 0;
+        // 99th percentile of the main loop's pass durations, saturating.
+        uint16_t loopP99Us = 0;
+        // Output commands handled during the interval.
+        uint16_t commands = 0;
+    };
+
+    static_assert(sizeof(Sample) == 12, "The Kconfig help quotes 12 bytes per sample");
+
+    // Start of a download, followed by `count` samples, oldest first.
+    struct FileHeader
+    {
+        uint32_t magic = MAGIC;
+        uint8_t version = FORMAT_VERSION;
+        Tier tier = Tier::Seconds;
+        uint16_t intervalS = 0;
+        uint16_t heapUnit = HEAP_UNIT;
+        uint16_t count = 0;
+        // Sequence number of the first sample; pass first + count as ?since= to get only newer samples.
+        uint32_t firstSequence = 0;
+        // Uptime when the newest sample was taken.
+        uint32_t newestUptimeS = 0;
+        float calibrationFactor = 0.0f;
+    };
+#pragma pack(pop)
+
+    /**
+     * Sets the function that returns the raw input voltage in millivolts;
+     * called once per second from the main loop.
+     */
+    void setInputSource(const Delegate<uint32_t()>& source);
+
+    // Called by the main loop; takes a sample once per second.
+    void handle(unsigned long now);
+
+    // Adds one main loop pass to the current interval's percentile. Main loop only.
+    void recordLoop(uint32_t durationUs);
+
+    [[nodiscard]] uint16_t intervalS(Tier tier);
+
+    /**
+     * Returns the header of a download starting at `since`, or at the oldest
+     * sample still kept when `since` is older than that.
+     */
+    [[nodiscard]] FileHeader beginDownload(Tier tier, uint32_t since);
+
+    /**
+     * Copies the bytes of the download described by `header` from `offset`.
+     * The rings keep filling during a download; samples overwritten in the
+     * meantime are sent zeroed.
+     */
+    size_t read(const FileHeader& header, size_t offset, uint8_t* out, size_t len);
+
+    // Times a main loop pass.
+    class LoopScope
+    {
+        const int64_t start = esp_timer_get_time();
+
+    public:
+        LoopScope() = default;
+
+        ~LoopScope()
+        {
+            recordLoop(static_cast<uint32_t>(esp_timer_get_time() - start));
+        }
+
+        LoopScope(const LoopScope&) = delete;
+        LoopScope& operator=(const LoopScope&) = delete;
+    };
+}
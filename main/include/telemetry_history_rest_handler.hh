@@ -0,0 +1,72 @@
+#pragma once
+
+#include "http_manager.hh"
+#include "telemetry_history.hh"
+
+namespace TelemetryHistory
+{
+    class RestHandler final : public HTTP::AsyncWebHandlerCreator
+    {
+    public:
+        AsyncWebHandler* createAsyncWebHandler() override
+        {
+            return new AsyncRestWebHandler();
+        }
+
+    private:
+        // Streams the samples straight out of the ring, one TCP window at a time.
+        class DownloadResponse final : public AsyncAbstractResponse
+        {
+            const FileHeader header;
+
+        public:
+            DownloadResponse(const Tier tier, const uint32_t since) : header(beginDownload(tier, since))
+            {
+                _code = 200;
+                setContentType("application/octet-stream");
+                _contentLength = sizeof(FileHeader) + header.count * sizeof(Sample);
+            }
+
+            [[nodiscard]] bool _sourceValid() const override
+            {
+                return true;
+            }
+
+            size_t _fillBuffer(uint8_t* data, const size_t len) override
+            {
+                return read(header, _sentLength, data, len);
+            }
+        };
+
+        class AsyncRestWebHandler final : public AsyncWebHandler
+        {
+        public:
+            bool canHandle(AsyncWebServerRequest* request) const override
+            {
+                return request->method() == HTTP_GET && request->url() == HTTP::Endpoints::SYSTEM_HISTORY;
+            }
+
+            void handleRequest(AsyncWebServerRequest* request) override
+            {
+                auto tier = Tier::Seconds;
+                if (request->hasParam("tier"))
+                {
+                    const auto& value = request->getParam("tier")->value();
+                    if (value == "minutes") tier = Tier::Minutes;
+                    else if (value != "seconds")
+                    {
+                        request->send(400, "text/plain", "Unknown tier");
+                        return;
+                    }
+                }
+                uint32_t since = 0;
+                if (request->hasParam("since"))
+                    since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+
+                const auto response = new DownloadResponse(tier, since);
+                response->addHeader("Cache-Control", "no-store");
+                request->send(response);
+            }
+        };
+    };
+}
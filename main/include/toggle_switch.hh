@@ -1,8 +1,9 @@
 #pragma once
 
 #include <Arduino.h>
-#include <functional>
+#include "delegate.hh"
 #include "hardware.hh"
+#include "task_registry.hh"
 
 class ToggleSwitch
 {
@@ -15,7 +16,7 @@ class ToggleSwitch
     unsigned long lastChangeTime = 0;
 
     TaskHandle_t taskHandle = nullptr;
-    std::function<void(bool)> callback;
+    Delegate<void(bool)> callback;
 
     [[noreturn]] static void taskLoop(void* arg)
     {
@@ -39,7 +40,7 @@ public:
     {
         if (taskHandle == nullptr)
         {
-            xTaskCreate(taskLoop, "ToggleSwitchTask", 2048, this, 1, &taskHandle);
+            Tasks::spawn(Tasks::Plan::TOGGLE_SWITCH, taskLoop, this, &taskHandle);
         }
     }
 
@@ -64,7 +65,7 @@ public:
         }
     }
 
-    void onChanged(const std::function<void(bool)>& cb)
+    void onChanged(const Delegate<void(bool)>& cb)
     {
         this->callback = cb;
     }
@@ -78,6 +79,7 @@ public:
     {
         if (taskHandle)
         {
+            Tasks::remove(taskHandle);
             vTaskDelete(taskHandle);
             taskHandle = nullptr;
         }
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <esp_system.h>
+
+#include "light.hh"
+
+/**
+ * Output state mirrored into RTC slow memory, which survives software
+ * resets, panics and watchdog resets but not a power cycle. On a warm boot
+ * the outputs are driven from the mirror in initVariant(), long before
+ * setup() reads NVS and brings up networking.
+ */
+namespace WarmRestart
+{
+    using Outputs = std::array<Light::State, ControllerHardware::OUTPUT_COUNT>;
+
+    struct BootTiming
+    {
+        bool warm = false;
+        esp_reset_reason_t resetReason = ESP_RST_UNKNOWN;
+        // esp_timer time when the outputs were first driven; -1 until then.
+        int64_t lightsOnUs = -1;
+    };
+
+    /**
+     * Returns the mirrored outputs when the last reset kept RTC memory and the
+     * mirror's checksum matches.
+     */
+    [[nodiscard]] std::optional<Outputs> load();
+
+    void save(const Outputs& outputs);
+
+    // Makes the next boot cold, e.g. before a factory reset.
+    void invalidate();
+
+    // Records the first time the outputs were driven during this boot.
+    void markLightsOn(bool warm);
+
+    [[nodiscard]] BootTiming getBootTiming();
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <mutex>
 #include "websocket_message.hh"
+#include "binary_log.hh"
+#include "command_trace.hh"
+#include "load_shedding.hh"
+#include "power.hh"
 #include "esp_now_handler_remote.hh"
 #include "ble_manager.hh"
 #include "throttled_value.hh"
@@ -12,6 +18,7 @@ namespace WebSocket
     {
         static constexpr auto LOG_TAG = "WebSocketHandler";
         static constexpr auto HEAP_MESSAGE_INTERVAL_MS = 750;
+        static constexpr auto TELEMETRY_MESSAGE_INTERVAL_MS = 1000;
 
         Output::Manager* outputManager;
         OTA::Handler* otaHandler;
@@ -22,6 +29,8 @@ namespace WebSocket
         DeviceManager* deviceManager;
         EspNow::ControllerHandler* controllerEspNowHandler;
         EspNow::RemoteHandler* remoteEspNowHandler;
+        TaskMonitor::Sampler* taskMonitor;
+        Telemetry::Collector* telemetryCollector;
 
         AsyncWebSocket ws = AsyncWebSocket("/ws");
 
@@ -36,7 +45,15 @@ namespace WebSocket
         ThrottledValue<WiFiStatus> wifiStatusThrottle{200};
         ThrottledValue<AlexaIntegration::Settings> alexaSettingsThrottle{200};
 
+        // Clients that asked for ON_TASK_STATS frames; 0 marks a free entry, client ids start at 1.
+        std::mutex taskStatsMutex;
+        std::array<uint32_t, DEFAULT_MAX_WS_CLIENTS> taskStatsSubscribers = {};
+        uint32_t lastTaskStatsSequence = 0;
+
         unsigned long lastSentHeapInfo = 0;
+        unsigned long lastSentTelemetry = 0;
+        uint16_t lastLowHeapEvents = 0;
+        uint16_t lastSheddingTransitions = 0;
 
     public:
         Handler(
@@ -48,7 +65,9 @@ namespace WebSocket
             BLE::Manager* bleManager,
             DeviceManager* deviceManager,
             EspNow::ControllerHandler* controllerEspNowHandler,
-            EspNow::RemoteHandler* remoteEspNowHandler
+            EspNow::RemoteHandler* remoteEspNowHandler,
+            TaskMonitor::Sampler* taskMonitor,
+            Telemetry::Collector* telemetryCollector
         )
             :
             outputManager(outputManager),
@@ -59,7 +78,9 @@ namespace WebSocket
             bleManager(bleManager),
             deviceManager(deviceManager),
             controllerEspNowHandler(controllerEspNowHandler),
-            remoteEspNowHandler(remoteEspNowHandler)
+            remoteEspNowHandler(remoteEspNowHandler),
+            taskMonitor(taskMonitor),
+            telemetryCollector(telemetryCollector)
         {
             ws.onEvent([this](AsyncWebSocket*, AsyncWebSocketClient* client,
                               const AwsEventType type, void* arg, const uint8_t* data,
@@ -71,6 +92,7 @@ namespace WebSocket
 
         void handle(const unsigned long now)
         {
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::WebSocket);
             ws.cleanupClients();
             if (ws.count())
             {
@@ -83,6 +105,11 @@ namespace WebSocket
             return &ws;
         }
 
+        [[nodiscard]] bool hasClients() const
+        {
+            return ws.count() > 0;
+        }
+
     private:
         // --------------------  Message Sending --------------------
 
@@ -110,6 +137,8 @@ namespace WebSocket
         void sendAllMessages(const unsigned long now, AsyncWebSocketClient* client = nullptr)
         {
             sendHeapInfoMessage(now);
+            sendTelemetryMessage(now);
+            sendLowHeapMessage();
             sendOutputColorMessage(now, client);
             sendBleStatusMessage(now, client);
             sendDeviceNameMessage(now, client);
@@ -120,6 +149,7 @@ namespace WebSocket
             sendWiFiDetailsMessage(now, client);
             sendWiFiStatusMessage(now, client);
             sendAlexaIntegrationSettingsMessage(now, client);
+            if (!client) sendTaskStatsMessage();
         }
 
         void sendOutputColorMessage(const unsigned long now, AsyncWebSocketClient* client = nullptr)
@@ -156,11 +186,40 @@ namespace WebSocket
             if (now - lastSentHeapInfo < HEAP_MESSAGE_INTERVAL_MS)
                 return;
             lastSentHeapInfo = now;
+            if (LoadShedding::shed(LoadShedding::Load::Broadcasts))
+                return;
             const auto freeHeap = esp_get_free_heap_size();
             const HeapMessage message(freeHeap);
             ws.binaryAll(reinterpret_cast<const uint8_t*>(&message), sizeof(HeapMessage));
         }
 
+        void sendTelemetryMessage(const unsigned long now)
+        {
+            if (telemetryCollector == nullptr)
+                return;
+            // A change of shedding level is always sent, even while the periodic frames are paused.
+            const auto transitions = LoadShedding::getTransitions();
+            const bool transitioned = transitions != lastSheddingTransitions;
+            if (!transitioned && now - lastSentTelemetry < TELEMETRY_MESSAGE_INTERVAL_MS)
+                return;
+            lastSentTelemetry = now;
+            lastSheddingTransitions = transitions;
+            if (!transitioned && LoadShedding::shed(LoadShedding::Load::Broadcasts))
+                return;
+            const TelemetryMessage message(telemetryCollector->collect(now));
+            ws.binaryAll(reinterpret_cast<const uint8_t*>(&message), sizeof(TelemetryMessage));
+        }
+
+        void sendLowHeapMessage()
+        {
+            if (HeapAccounting::getLowHeapEvents() == lastLowHeapEvents) return;
+            const auto heap = HeapAccounting::getSummary();
+            const LowHeapMessage message(heap);
+            if (AsyncWebSocket::SendStatus::ENQUEUED ==
+                ws.binaryAll(reinterpret_cast<const uint8_t*>(&message), sizeof(LowHeapMessage)))
+                lastLowHeapEvents = heap.lowHeapEvents;
+        }
+
         void sendEspNowDevicesMessage(const unsigned long now, AsyncWebSocketClient* client = nullptr)
         {
             if (controllerEspNowHandler == nullptr) return;
@@ -205,6 +264,25 @@ namespace WebSocket
                 alexaIntegration->getSettings(), alexaSettingsThrottle, now, client);
         }
 
+        // Each new snapshot goes to the subscribed clients only; the frame is too large to send to all of them.
+        void sendTaskStatsMessage()
+        {
+            if (taskMonitor == nullptr) return;
+            std::lock_guard lock(taskStatsMutex);
+            if (std::ranges::all_of(taskStatsSubscribers, [](const uint32_t id) { return id == 0; })) return;
+            const TaskStatsMessage message(taskMonitor->getSnapshot());
+            if (message.snapshot.sequence == lastTaskStatsSequence) return;
+            lastTaskStatsSequence = message.snapshot.sequence;
+            for (auto& id : taskStatsSubscribers)
+            {
+                if (id == 0) continue;
+                if (auto* client = ws.client(id))
+                    client->binary(reinterpret_cast<const uint8_t*>(&message), message.size());
+                else
+                    id = 0;
+            }
+        }
+
         // --------------------  Message Handling --------------------
 
         void handleWebSocketEvent(AsyncWebSocketClient* client,
@@ -214,11 +292,18 @@ namespace WebSocket
             switch (type)
             {
             case WS_EVT_CONNECT:
+                if (LoadShedding::shed(LoadShedding::Load::NewClients))
+                {
+                    // 1013: try again later. Skips the initial burst of state frames queued for a new client.
+                    client->close(1013, "Low memory");
+                    break;
+                }
                 ESP_LOGD(LOG_TAG, "WebSocket client connected: %s", client->remoteIP().toString().c_str());
                 sendAllMessages(millis(), client);
                 break;
             case WS_EVT_DISCONNECT: // NOLINT
                 ESP_LOGD(LOG_TAG, "WebSocket client disconnected: %s", client->remoteIP().toString().c_str());
+                subscribeTaskStats(client, false);
                 break;
             case WS_EVT_PONG:
                 ESP_LOGD(LOG_TAG, "WebSocket pong received from client");
@@ -271,15 +356,22 @@ namespace WebSocket
             }
 
             const uint8_t messageTypeRaw = data[0];
-            if (messageTypeRaw > static_cast<uint8_t>(Message::Type::ON_ALEXA_INTEGRATION_SETTINGS))
+            CallbackBudget::Scope budget(CallbackBudget::Context::AsyncTcp, "WebSocket::onMessage", messageTypeRaw);
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::WebSocket);
+            if (messageTypeRaw > static_cast<uint8_t>(Message::Type::ON_LOW_HEAP))
             {
                 ESP_LOGD(LOG_TAG, "Received unknown  Message type: %d", messageTypeRaw);
                 return;
             }
 
             const auto messageType = static_cast<Message::Type>(messageTypeRaw);
-            ESP_LOGD(LOG_TAG, "Received  Message of type %d", static_cast<int>(messageType));
+            BINARY_LOGD(BinaryLog::Tag::WebSocket, "Received  Message of type %d", static_cast<int>(messageType));
 
+            // The trace can be downloaded, so only the type byte of a credentials message is kept.
+            const bool secret = messageType == Message::Type::ON_HTTP_CREDENTIALS ||
+                messageType == Message::Type::ON_WIFI_CONNECTION_DETAILS;
+            Power::CommandScope power;
+            Trace::Scope trace(Trace::Source::WebSocket, data, secret ? 1 : len);
             this->handleWebSocketMessage(messageType, client, data, len);
         }
 
@@ -332,6 +424,18 @@ namespace WebSocket
                 handleAlexaIntegrationSettingsMessage(data, len);
                 break;
 
+            case Message::Type::ON_TASK_STATS:
+                handleTaskStatsMessage(client, data, len);
+                break;
+
+            case Message::Type::ON_TELEMETRY:
+                ESP_LOGD(LOG_TAG, "Received TELEMETRY message (ignored).");
+                break;
+
+            case Message::Type::ON_LOW_HEAP:
+                ESP_LOGD(LOG_TAG, "Received LOW_HEAP message (ignored).");
+                break;
+
             default:
                 client->text("Unknown message type");
                 break;
@@ -342,11 +446,36 @@ namespace WebSocket
         {
             if (outputManager == nullptr) return;
             if (len < sizeof(ColorMessage)) return;
+            HeapAccounting::NoAllocGuard noAlloc("WebSocket::handleColorMessage");
             const auto* message = reinterpret_cast<const ColorMessage*>(data);
             outputThrottle.setLastSent(millis(), message->state);
             outputManager->setState(message->state);
         }
 
+        // [type] or [type, 1] subscribes the client to the task statistics, [type, 0] unsubscribes it.
+        void handleTaskStatsMessage(AsyncWebSocketClient* client, const uint8_t* data, const size_t len)
+        {
+            const bool subscribe = len < 2 || data[1] != 0;
+            subscribeTaskStats(client, subscribe);
+            if (!subscribe || taskMonitor == nullptr) return;
+            const TaskStatsMessage message(taskMonitor->getSnapshot());
+            client->binary(reinterpret_cast<const uint8_t*>(&message), message.size());
+        }
+
+        void subscribeTaskStats(const AsyncWebSocketClient* client, const bool subscribe)
+        {
+            std::lock_guard lock(taskStatsMutex);
+            auto entry = std::ranges::find(taskStatsSubscribers, client->id());
+            if (!subscribe)
+            {
+                if (entry != taskStatsSubscribers.end()) *entry = 0;
+                return;
+            }
+            if (entry == taskStatsSubscribers.end())
+                entry = std::ranges::find(taskStatsSubscribers, 0u);
+            if (entry != taskStatsSubscribers.end()) *entry = client->id();
+        }
+
         void handleHttpCredentialsMessage(const uint8_t* data, const size_t len) const
         {
             if (webServerHandler == nullptr) return;
@@ -360,7 +489,8 @@ namespace WebSocket
             if (deviceManager == nullptr) return;
             if (len < sizeof(DeviceNameMessage)) return;
             const auto* message = reinterpret_cast<const DeviceNameMessage*>(data);
-            deviceManager->setDeviceName(message->deviceName.data());
+            deviceManager->requestDeviceName(message->deviceName.data(),
+                                             strnlen(message->deviceName.data(), message->deviceName.size()));
         }
 
         void handleBleStatusMessage(const uint8_t* data, const size_t len) const
@@ -373,16 +503,16 @@ namespace WebSocket
             )
             {
             case BLE::Status::ADVERTISING:
-                async_call([this]
+                Async::post([this]
                 {
                     bleManager->start();
-                }, 4096, 0);
+                });
                 break;
             case BLE::Status::OFF:
-                async_call([this]
+                Async::post([this]
                 {
                     bleManager->stop();
-                }, 4096, 0);
+                });
                 break;
             default:
                 break;
@@ -394,7 +524,7 @@ namespace WebSocket
             if (wifiManager == nullptr) return;
             if (len < sizeof(WiFiConnectionDetailsMessage)) return;
             const auto* message = reinterpret_cast<const WiFiConnectionDetailsMessage*>(data);
-            wifiManager->connect(message->details);
+            wifiManager->requestConnect(message->details);
         }
 
         void handleOnWiFiScanStatus() const
@@ -409,7 +539,7 @@ namespace WebSocket
             if (alexaIntegration == nullptr) return;
             if (len < sizeof(AlexaIntegrationSettingsMessage)) return;
             const auto* message = reinterpret_cast<const AlexaIntegrationSettingsMessage*>(data);
-            alexaIntegration->applySettings(message->settings);
+            alexaIntegration->requestSettings(message->settings);
         }
     };
 }
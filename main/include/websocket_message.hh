@@ -4,6 +4,8 @@
 #include "device_manager.hh"
 #include "ota_handler.hh"
 #include "esp_now_handler_controller.hh"
+#include "task_monitor.hpp"
+#include "telemetry.hh"
 
 namespace WebSocket
 {
@@ -25,7 +27,10 @@ namespace WebSocket
             ON_OTA_PROGRESS,
             ON_ALEXA_INTEGRATION_SETTINGS,
             ON_ESP_NOW_DEVICES,
-            ON_ESP_NOW_CONTROLLER
+            ON_ESP_NOW_CONTROLLER,
+            ON_TASK_STATS,
+            ON_TELEMETRY,
+            ON_LOW_HEAP
         };
 
         Type type;
@@ -175,6 +180,41 @@ namespace WebSocket
         }
     };
 
+    struct TaskStatsMessage : Message
+    {
+        TaskMonitor::Snapshot snapshot;
+
+        explicit TaskStatsMessage(const TaskMonitor::Snapshot& snapshot)
+            : Message(Type::ON_TASK_STATS), snapshot(snapshot)
+        {
+        }
+
+        // Bytes to send: the unused entries are left off.
+        [[nodiscard]] size_t size() const
+        {
+            return sizeof(Message) + snapshot.usedSize();
+        }
+    };
+
+    struct TelemetryMessage : Message
+    {
+        Reflect::Buffer<Telemetry::Frame> frame;
+
+        explicit TelemetryMessage(const Telemetry::Frame& frame)
+            : Message(Type::ON_TELEMETRY), frame(Reflect::encode(frame))
+        {
+        }
+    };
+
+    struct LowHeapMessage : Message
+    {
+        Reflect::Buffer<HeapAccounting::Summary> heap;
+
+        explicit LowHeapMessage(const HeapAccounting::Summary& heap)
+            : Message(Type::ON_LOW_HEAP), heap(Reflect::encode(heap))
+        {
+        }
+    };
 
 #pragma pack(pop)
 }
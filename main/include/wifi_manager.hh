@@ -9,11 +9,16 @@
 #include <mutex>
 
 #include "ble_manager.hh"
+#include "delegate.hh"
 #include "state_json_filler.hh"
 #include "NimBLEServer.h"
 #include "NimBLEService.h"
 #include "NimBLECharacteristic.h"
 #include "wifi_model.hh"
+#include "task_registry.hh"
+#include "callback_budget.hh"
+#include "heap_accounting.hh"
+#include "pending_value.hh"
 
 
 class WiFiManager final : public BLE::Service, public StateJsonFiller
@@ -33,7 +38,8 @@ class WiFiManager final : public BLE::Service, public StateJsonFiller
     NimBLECharacteristic* bleScanStatusCharacteristic = nullptr;
     NimBLECharacteristic* bleScanResultCharacteristic = nullptr;
 
-    std::function<void()> gotIpChanged;
+    Delegate<void()> gotIpChanged;
+    PendingValue<WiFiConnectionDetails> pendingConnection;
 
 public:
     void begin()
@@ -43,6 +49,9 @@ public:
         fillWiFiDetails();
         WiFi.onEvent([this](const WiFiEvent_t event, const WiFiEventInfo_t& info)
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::WiFiEvent, "WiFiManager::onEvent",
+                                         static_cast<int16_t>(event));
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::WiFi);
             switch (event)
             {
             case ARDUINO_EVENT_WIFI_STA_CONNECTED:
@@ -154,9 +163,9 @@ public:
         return scanResult;
     }
 
-    void setGotIpCallback(std::function<void()> cb)
+    void setGotIpCallback(const Delegate<void()>& cb)
     {
-        gotIpChanged = std::move(cb);
+        gotIpChanged = cb;
     }
 
     [[nodiscard]] static std::optional<WiFiConnectionDetails> loadCredentials()
@@ -205,6 +214,20 @@ public:
         prefs.end();
     }
 
+    /**
+     * Schedules connect() on a worker so callers running in network callbacks
+     * don't wait for the NVS write and the Wi-Fi disconnect.
+     */
+    void requestConnect(const WiFiConnectionDetails& details)
+    {
+        if (!pendingConnection.put(details)) return;
+        if (!Async::post([this] { applyPendingConnection(); }))
+        {
+            pendingConnection.take();
+            ESP_LOGW(LOG_TAG, "Failed to schedule the Wi-Fi connection");
+        }
+    }
+
     void connect(const WiFiConnectionDetails& details) // NOLINT
     {
         if (details.ssid[0] == '\0')
@@ -226,6 +249,12 @@ public:
     }
 
 private:
+    void applyPendingConnection()
+    {
+        if (const auto details = pendingConnection.take())
+            connect(details.value());
+    }
+
     static bool isEap(const WiFiConnectionDetails& details)
     {
         return isEap(details.encryptionType);
@@ -289,7 +318,8 @@ private:
         if (bleDetailsCharacteristic)
         {
             ESP_LOGI(LOG_TAG, "Notifying WiFiDetails via BLE");
-            bleDetailsCharacteristic->setValue(reinterpret_cast<uint8_t*>(&wifiDetails), sizeof(wifiDetails));
+            const auto payload = Reflect::encode(wifiDetails);
+            bleDetailsCharacteristic->setValue(payload.data(), payload.size());
             bleDetailsCharacteristic->notify(); // NOLINT
             ESP_LOGI(LOG_TAG, "DONE notifying WiFiDetails via BLE");
         }
@@ -367,7 +397,7 @@ private:
                 ESP_LOGE(LOG_TAG, "Failed to create wifiScanQueue");
                 return;
             }
-            xTaskCreate(wifiScanNotifier, "WifiScanNotifier", 4096, this, 1, nullptr);
+            Tasks::spawn(Tasks::Plan::WIFI_SCAN_NOTIFIER, wifiScanNotifier, this);
         }
     }
 
@@ -404,7 +434,7 @@ private:
                     auto ssid = WiFi.SSID(i);
                     if (ssid.isEmpty()) continue;
 
-                    if (result.contains(ssid))
+                    if (result.contains(ssid.c_str()))
                         continue; // Skip duplicates
 
                     strncpy(result.networks[result.resultCount].ssid.data(), ssid.c_str(), WIFI_MAX_SSID_LENGTH);
@@ -425,7 +455,7 @@ public:
     void fillState(const JsonObject& obj) const override
     {
         const auto wifi = obj["wifi"].to<JsonObject>();
-        WiFiDetails::toJson(wifi["details"].to<JsonObject>());
+        getWifiDetails().toJson(wifi["details"].to<JsonObject>());
         wifi["status"] = wifiStatusString(wifiStatus);
     }
 
@@ -487,8 +517,8 @@ public:
 
         void onRead(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
-            WiFiDetails details = wifiManager->getWifiDetails();
-            pCharacteristic->setValue(reinterpret_cast<uint8_t*>(&details), sizeof(details));
+            const auto payload = Reflect::encode(wifiManager->getWifiDetails());
+            pCharacteristic->setValue(payload.data(), payload.size());
         }
     };
 
@@ -509,6 +539,8 @@ public:
 
         void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "WiFiStatusCallback::onWrite");
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
             WiFiConnectionDetails details = {};
             if (pCharacteristic->getValue().size() != sizeof(WiFiConnectionDetails))
             {
@@ -517,7 +549,7 @@ public:
                 return;
             }
             memcpy(&details, pCharacteristic->getValue().data(), sizeof(WiFiConnectionDetails));
-            wifiManager->connect(details);
+            wifiManager->requestConnect(details);
         }
     };
 
@@ -538,6 +570,8 @@ public:
 
         void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override
         {
+            CallbackBudget::Scope budget(CallbackBudget::Context::NimBLE, "WiFiScanStatusCallback::onWrite");
+            HeapAccounting::Scope heapScope(HeapAccounting::Tag::Ble);
             wifiManager->triggerScan();
         }
     };
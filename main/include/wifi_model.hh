@@ -1,9 +1,11 @@
 #pragma once
 
 #include <array>
+#include <cstring>
 #include <WiFi.h>
 
 #include "ArduinoJson.h"
+#include "reflect.hh"
 
 #define WIFI_MAX_SSID_LENGTH      32
 #define WIFI_MAX_PASSWORD_LENGTH  64
@@ -97,13 +99,13 @@ struct WiFiScanResult
         return false;
     }
 
-    [[nodiscard]] bool contains(const String& ssid) const
+    [[nodiscard]] bool contains(const char* ssid) const
     {
         for (uint8_t i = 0; i < resultCount; ++i)
         {
             if (networks[i].ssid[0] == '\0')
                 continue;
-            if (String(networks[i].ssid.data()) == ssid)
+            if (strncmp(networks[i].ssid.data(), ssid, WIFI_MAX_SSID_LENGTH) == 0)
                 return true;
         }
         return false;
@@ -146,17 +148,26 @@ struct WiFiDetails
         ssid[WIFI_MAX_SSID_LENGTH] = '\0';
     }
 
-    static void toJson(const JsonObject& to)
+    static constexpr auto fields()
     {
-        to["ssid"] = WiFi.SSID();
-        to["mac"] = WiFi.macAddress();
-        to["ip"] = WiFi.localIP().toString();
-        to["gateway"] = WiFi.gatewayIP().toString();
-        to["subnet"] = WiFi.subnetMask().toString();
-        to["dns"] = WiFi.dnsIP().toString();
+        return std::tuple{
+            Reflect::field("ssid", &WiFiDetails::ssid),
+            Reflect::field("mac", &WiFiDetails::mac, Reflect::Format::mac),
+            Reflect::field("ip", &WiFiDetails::ip, Reflect::Format::ip),
+            Reflect::field("gateway", &WiFiDetails::gateway, Reflect::Format::ip),
+            Reflect::field("subnet", &WiFiDetails::subnet, Reflect::Format::ip),
+            Reflect::field("dns", &WiFiDetails::dns, Reflect::Format::ip),
+        };
+    }
+
+    void toJson(const JsonObject& to) const
+    {
+        Reflect::toJson(*this, to);
     }
 };
 
+static_assert(Reflect::checkLayout<WiFiDetails>(), "WiFiDetails is sent as is over BLE and WebSocket");
+
 struct WiFiConnectionDetails
 {
     struct SimpleWiFiConnectionCredentials
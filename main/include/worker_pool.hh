@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "delegate.hh"
+
+namespace Async
+{
+    static constexpr uint32_t WORKER_STACK_SIZE = 4096;
+
+    /**
+     * Callable stored inline in the worker queue. A Delegate is trivially
+     * copyable, so the FreeRTOS queue copies it byte by byte and posting a
+     * job never touches the heap.
+     */
+    using Job = Delegate<void()>;
+
+    static_assert(std::is_trivially_copyable_v<Job>, "Job must be copyable by the FreeRTOS queue");
+
+    struct Stats
+    {
+        uint32_t submitted;
+        uint32_t completed;
+        uint32_t rejected;
+        uint8_t pendingDelayed;
+    };
+
+    /**
+     * Starts the fixed worker tasks and the timer wheel used for delayed jobs.
+     * Must be called once before the first post().
+     */
+    bool begin();
+
+    /**
+     * Queues a job for one of the workers, optionally after `delayMs`.
+     * Never blocks: returns false when the queue or the timer wheel is full.
+     * An accepted delayed job that comes due while the queue is full waits for
+     * the next wheel tick.
+     */
+    bool post(const Job& job, uint32_t delayMs = 0);
+
+    Stats getStats();
+}
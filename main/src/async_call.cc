@@ -1,36 +1,22 @@
 #include "async_call.hh"
 
-#include <esp32-hal.h>
-#include <esp_system.h>
-#include <freertos/FreeRTOS.h> // NOLINT
-#include <freertos/task.h>
+#include <esp_log.h>
 
 constexpr auto ASYNC_CALL_TAG = "AsyncCall";
 
-struct AsyncCallArgs
-{
-    std::function<void()> callback;
-    uint32_t delayMs;
-};
-
-void doCall(void* args)
-{
-    const auto* callArgs = static_cast<AsyncCallArgs*>(args);
-    delay(callArgs->delayMs);
-    callArgs->callback();
-    delete callArgs;
-    vTaskDelete(nullptr); // Delete this task
-}
-
 void async_call(
-    std::function<void()> callback,
+    const Async::Job& callback,
     const uint32_t usStackDepth,
     const uint32_t delayMs)
 {
-    if (auto* args = new AsyncCallArgs{std::move(callback), delayMs};
-        xTaskCreate(doCall, "AsyncCallTask", usStackDepth, args, 1, nullptr) != pdPASS)
+    if (usStackDepth > Async::WORKER_STACK_SIZE)
+    {
+        ESP_LOGW(ASYNC_CALL_TAG, "Requested stack of %lu bytes exceeds the worker stack of %lu bytes",
+                 usStackDepth, Async::WORKER_STACK_SIZE);
+    }
+
+    if (!Async::post(callback, delayMs))
     {
-        ESP_LOGE(ASYNC_CALL_TAG, "Failed to create task");
-        delete args;
+        ESP_LOGE(ASYNC_CALL_TAG, "Failed to post job");
     }
 }
@@ -0,0 +1,138 @@
+#include "bench.hh"
+
+#include <sdkconfig.h>
+
+#if CONFIG_RGBW_CTRL_BENCHMARKS
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <esp_log.h>
+
+#include "worker_pool.hh"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "Bench";
+
+        struct Entry
+        {
+            const char* name;
+            Kernel kernel;
+            uint16_t iterations;
+            Context context;
+        };
+
+        std::mutex benchMutex;
+        std::array<Entry, MAX_KERNELS> entries = {};
+        std::array<Result, MAX_KERNELS> results = {};
+        uint8_t entryCount = 0;
+        uint32_t runs = 0;
+        std::atomic<bool> running = false;
+        // Set once the worker kernels of a run are done and the loop kernels are due.
+        std::atomic<bool> loopPending = false;
+
+        Result measure(const Entry& entry, const CycleCounter& counter)
+        {
+            Result result = {entry.name, entry.iterations, UINT32_MAX, 0, 0};
+            uint64_t total = 0;
+            entry.kernel();
+            for (uint16_t i = 0; i < entry.iterations; ++i)
+            {
+                const auto start = counter();
+                entry.kernel();
+                const auto cycles = counter() - start;
+                total += cycles;
+                result.minCycles = std::min(result.minCycles, cycles);
+                result.maxCycles = std::max(result.maxCycles, cycles);
+            }
+            if (entry.iterations == 0) result.minCycles = 0;
+            else result.meanCycles = static_cast<uint32_t>(total / entry.iterations);
+            return result;
+        }
+
+        void run(const Context context, const CycleCounter& counter)
+        {
+            // Registration happens at boot, so the entries can be read without holding the lock while timing.
+            uint8_t count;
+            {
+                std::lock_guard lock(benchMutex);
+                count = entryCount;
+            }
+            for (uint8_t i = 0; i < count; ++i)
+            {
+                if (entries[i].context != context) continue;
+                const auto result = measure(entries[i], counter);
+                ESP_LOGI(LOG_TAG, "%s: min %lu, mean %lu, max %lu cycles", result.name, result.minCycles,
+                         result.meanCycles, result.maxCycles);
+                std::lock_guard lock(benchMutex);
+                results[i] = result;
+            }
+        }
+
+        void finish()
+        {
+            std::lock_guard lock(benchMutex);
+            runs++;
+        }
+    }
+
+    bool add(const char* name, const Kernel& kernel, const uint16_t iterations, const Context context)
+    {
+        std::lock_guard lock(benchMutex);
+        if (entryCount == MAX_KERNELS) return false;
+        entries[entryCount++] = {name, kernel, iterations, context};
+        return true;
+    }
+
+    void runAll(const CycleCounter& counter)
+    {
+        run(Context::Worker, counter);
+        run(Context::Loop, counter);
+        finish();
+    }
+
+    bool start()
+    {
+        if (running.exchange(true)) return false;
+        if (Async::post([]
+        {
+            run(Context::Worker, [] { return esp_cpu_get_cycle_count(); });
+            loopPending = true;
+        }))
+            return true;
+        running = false;
+        return false;
+    }
+
+    void handle()
+    {
+        if (!loopPending.exchange(false)) return;
+        run(Context::Loop, [] { return esp_cpu_get_cycle_count(); });
+        finish();
+        running = false;
+    }
+
+    bool isRunning()
+    {
+        return running.load();
+    }
+
+    uint32_t getRuns()
+    {
+        std::lock_guard lock(benchMutex);
+        return runs;
+    }
+
+    uint8_t getResults(std::array<Result, MAX_KERNELS>& out)
+    {
+        std::lock_guard lock(benchMutex);
+        const uint8_t count = runs > 0 ? entryCount : 0;
+        std::copy_n(results.begin(), count, out.begin());
+        return count;
+    }
+}
+
+#endif
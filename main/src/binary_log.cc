@@ -0,0 +1,176 @@
+#include "binary_log.hh"
+
+#include <cstring>
+#include <esp_timer.h>
+
+#include "task_registry.hh"
+
+namespace BinaryLog
+{
+    namespace
+    {
+        struct Slot
+        {
+            // sequence + 1 once the entry is complete, 0 while it is written.
+            std::atomic<uint32_t> published = 0;
+            Entry entry;
+        };
+
+        // 8 bytes of sequence and padding before the 48-byte entry on the 32-bit targets.
+        static_assert(sizeof(void*) != 4 || sizeof(Slot) == 56, "The Kconfig help quotes 56 bytes per entry");
+
+        std::array<Slot, CAPACITY> slots;
+        std::atomic<uint32_t> head = 0;
+
+#if CONFIG_RGBW_CTRL_BINARY_LOG_DRAIN
+        constexpr uint32_t DRAIN_INTERVAL_MS = 200;
+        constexpr uint16_t DRAIN_BATCH = 8;
+
+        [[noreturn]] void drain(void*)
+        {
+            uint32_t cursor = 0;
+            uint32_t dropped = 0;
+            std::array<Entry, DRAIN_BATCH> batch;
+            char message[MAX_MESSAGE_LENGTH];
+            for (;;)
+            {
+                vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+                uint16_t count;
+                while ((count = read(cursor, batch.data(), DRAIN_BATCH, dropped)) > 0)
+                {
+                    for (uint16_t i = 0; i < count; ++i)
+                    {
+                        const auto& entry = batch[i];
+                        format(entry, message, sizeof(message));
+                        const auto name = tagName(entry.tag);
+                        esp_log_write(entry.level, name, "%c (%lu) %s: %s\n", levelLetter(entry.level),
+                                      static_cast<unsigned long>(entry.timestampUs / 1000), name, message);
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    void begin()
+    {
+#if CONFIG_RGBW_CTRL_BINARY_LOG_DRAIN
+        // Prints from a low-priority task, so a slow console never delays the code that logged.
+        Tasks::spawn(Tasks::Plan::LOG_DRAIN, drain, nullptr);
+#endif
+    }
+
+    void setLevel(const Tag tag, const esp_log_level_t level)
+    {
+        levels[static_cast<uint8_t>(tag)].value.store(level, std::memory_order_relaxed);
+    }
+
+    esp_log_level_t getLevel(const Tag tag)
+    {
+        return levels[static_cast<uint8_t>(tag)].value.load(std::memory_order_relaxed);
+    }
+
+    const char* tagName(const Tag tag)
+    {
+        switch (tag)
+        {
+        case Tag::Controller: return "Controller";
+        case Tag::Light: return "Light";
+        case Tag::Alexa: return "AlexaIntegration";
+        case Tag::WebSocket: return "WebSocketHandler";
+        default: return "unknown";
+        }
+    }
+
+    std::optional<Tag> findTag(const char* name)
+    {
+        for (uint8_t i = 0; i < TAG_COUNT; ++i)
+        {
+            if (strcmp(tagName(static_cast<Tag>(i)), name) == 0)
+                return static_cast<Tag>(i);
+        }
+        return std::nullopt;
+    }
+
+    void write(const Tag tag, const esp_log_level_t level, const char* format, const Arg* args, const uint8_t count)
+    {
+        const auto sequence = head.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = slots[sequence % CAPACITY];
+        slot.published.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto& entry = slot.entry;
+        entry.sequence = sequence;
+        entry.timestampUs = esp_timer_get_time();
+        entry.format = format;
+        entry.tag = tag;
+        entry.level = level;
+        for (uint8_t i = 0; i < count; ++i)
+            entry.args[i] = args[i];
+        slot.published.store(sequence + 1, std::memory_order_release);
+    }
+
+    uint32_t getHead()
+    {
+        return head.load(std::memory_order_acquire);
+    }
+
+    uint16_t read(uint32_t& cursor, Entry* out, const uint16_t max, uint32_t& dropped)
+    {
+        const auto end = getHead();
+        if (end - cursor > CAPACITY)
+        {
+            dropped += end - CAPACITY - cursor;
+            cursor = end - CAPACITY;
+        }
+
+        uint16_t count = 0;
+        while (cursor != end && count < max)
+        {
+            const auto& slot = slots[cursor % CAPACITY];
+            const auto published = slot.published.load(std::memory_order_acquire);
+            // Reserved but not written yet: stop here and pick it up on the next read.
+            if (published == 0) break;
+            if (published == cursor + 1)
+            {
+                out[count] = slot.entry;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.published.load(std::memory_order_relaxed) == published)
+                {
+                    count++;
+                    cursor++;
+                    continue;
+                }
+            }
+            // Overwritten by a newer entry before or while it was copied.
+            dropped++;
+            cursor++;
+        }
+        return count;
+    }
+
+    size_t format(const Entry& entry, char* buffer, const size_t size)
+    {
+        const auto& args = entry.args;
+        const auto length = snprintf(buffer, size, entry.format, args[0], args[1], args[2], args[3], args[4],
+                                     args[5]);
+        if (length < 0) return 0;
+        return std::min(static_cast<size_t>(length), size - 1);
+    }
+
+    char levelLetter(const esp_log_level_t level)
+    {
+        static constexpr char LETTERS[] = "NEWIDV";
+        return level <= ESP_LOG_VERBOSE ? LETTERS[level] : '?';
+    }
+
+    std::optional<esp_log_level_t> levelFromLetter(const char letter)
+    {
+        static constexpr char LETTERS[] = "NEWIDV";
+        for (uint8_t i = 0; i <= ESP_LOG_VERBOSE; ++i)
+        {
+            if (LETTERS[i] == letter) return static_cast<esp_log_level_t>(i);
+        }
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,53 @@
+#include "boot_timeline.hh"
+
+#include <array>
+#include <atomic>
+#include <esp_timer.h>
+
+namespace BootTimeline
+{
+    namespace
+    {
+        struct Timestamp
+        {
+            std::atomic<int64_t> us = NOT_REACHED;
+        };
+
+        std::array<Timestamp, PHASE_COUNT> timestamps;
+    }
+
+    void mark(const Phase phase)
+    {
+        auto& timestamp = timestamps[static_cast<uint8_t>(phase)].us;
+        // Marks on hot paths such as loop() stop at this load once the phase is recorded.
+        if (timestamp.load(std::memory_order_relaxed) != NOT_REACHED) return;
+        int64_t expected = NOT_REACHED;
+        timestamp.compare_exchange_strong(expected, esp_timer_get_time());
+    }
+
+    int64_t get(const Phase phase)
+    {
+        return timestamps[static_cast<uint8_t>(phase)].us.load(std::memory_order_relaxed);
+    }
+
+    const char* phaseName(const Phase phase)
+    {
+        switch (phase)
+        {
+        case Phase::Setup: return "setup";
+        case Phase::Tasks: return "tasks";
+        case Phase::Outputs: return "outputs";
+        case Phase::WiFi: return "wifi";
+        case Phase::Connect: return "connect";
+        case Phase::Restore: return "restore";
+        case Phase::Alexa: return "alexa";
+        case Phase::WebServer: return "webServer";
+        case Phase::SetupDone: return "setupDone";
+        case Phase::FirstLoop: return "firstLoop";
+        case Phase::GotIp: return "gotIp";
+        case Phase::FirstRequest: return "firstRequest";
+        case Phase::FileSystem: return "fileSystem";
+        default: return "unknown";
+        }
+    }
+}
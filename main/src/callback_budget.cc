@@ -0,0 +1,110 @@
+#include "callback_budget.hh"
+
+#include <algorithm>
+#include <mutex>
+#include <esp_log.h>
+
+namespace CallbackBudget
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "CallbackBudget";
+
+        std::mutex budgetMutex;
+        std::array<ContextStats, CONTEXT_COUNT> stats = {};
+        std::array<Violation, MAX_VIOLATIONS> violations = {};
+        uint8_t violationHead = 0;
+        uint8_t violationCount = 0;
+        // Violations recorded since boot, and how many of them have been logged or cleared by reset(). Both are only
+        // written under budgetMutex; they are atomic so handle() can compare them without it.
+        std::atomic<uint32_t> recorded = 0;
+        std::atomic<uint32_t> logged = 0;
+    }
+
+    void record(const Context context, const char* handler, const int16_t detail, const uint32_t durationUs)
+    {
+        const bool violated = durationUs > budgetUs.load(std::memory_order_relaxed);
+        {
+            std::lock_guard lock(budgetMutex);
+            auto& entry = stats[static_cast<uint8_t>(context)];
+            entry.calls++;
+            if (durationUs > entry.maxUs)
+            {
+                entry.maxUs = durationUs;
+                entry.maxHandler = handler;
+            }
+            if (!violated) return;
+
+            entry.violations++;
+            violations[violationHead] = {
+                static_cast<uint32_t>(esp_timer_get_time() / 1000), durationUs, handler, detail, context
+            };
+            violationHead = (violationHead + 1) % MAX_VIOLATIONS;
+            if (violationCount < MAX_VIOLATIONS) violationCount++;
+            ++recorded;
+        }
+    }
+
+    void reset()
+    {
+        std::lock_guard lock(budgetMutex);
+        stats = {};
+        violationHead = 0;
+        violationCount = 0;
+        logged = recorded.load();
+    }
+
+    void handle()
+    {
+        if (recorded.load(std::memory_order_relaxed) == logged.load(std::memory_order_relaxed)) return;
+
+        std::array<Violation, MAX_VIOLATIONS> pending;
+        uint8_t count = 0;
+        uint32_t overwritten = 0;
+        {
+            std::lock_guard lock(budgetMutex);
+            const uint32_t unlogged = recorded - logged;
+            count = static_cast<uint8_t>(std::min<uint32_t>(unlogged, violationCount));
+            overwritten = unlogged - count;
+            // Oldest first, as they happened.
+            for (uint8_t i = 0; i < count; ++i)
+                pending[i] = violations[(violationHead + MAX_VIOLATIONS - count + i) % MAX_VIOLATIONS];
+            logged = recorded.load();
+        }
+
+        if (overwritten > 0)
+            ESP_LOGW(LOG_TAG, "%lu budget violations were overwritten before they were logged", overwritten);
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            const auto& violation = pending[i];
+            ESP_LOGW(LOG_TAG, "%s in %s took %lu us", violation.handler, contextName(violation.context),
+                     violation.durationUs);
+        }
+    }
+
+    const char* contextName(const Context context)
+    {
+        switch (context)
+        {
+        case Context::AsyncTcp: return "async_tcp";
+        case Context::NimBLE: return "nimble";
+        case Context::WiFiEvent: return "wifi_event";
+        case Context::EspNow: return "espnow";
+        default: return "unknown";
+        }
+    }
+
+    ContextStats getStats(const Context context)
+    {
+        std::lock_guard lock(budgetMutex);
+        return stats[static_cast<uint8_t>(context)];
+    }
+
+    uint8_t getViolations(std::array<Violation, MAX_VIOLATIONS>& out)
+    {
+        std::lock_guard lock(budgetMutex);
+        for (uint8_t i = 0; i < violationCount; ++i)
+            out[i] = violations[(violationHead + MAX_VIOLATIONS - 1 - i) % MAX_VIOLATIONS];
+        return violationCount;
+    }
+}
@@ -0,0 +1,149 @@
+#include "command_trace.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace Trace
+{
+    namespace
+    {
+        struct Record
+        {
+            RecordHeader header;
+            std::array<uint8_t, MAX_PAYLOAD> payload;
+        };
+
+        std::mutex traceMutex;
+        std::array<Record, CAPACITY> records = {};
+        uint16_t head = 0;
+        uint16_t count = 0;
+        uint32_t recorded = 0;
+        uint32_t dropped = 0;
+        uint8_t downloads = 0;
+        Delegate<uint32_t()> stateVersionSource;
+
+        const Record& oldest(const uint16_t i)
+        {
+            return records[(head + CAPACITY - count + i) % CAPACITY];
+        }
+
+        size_t downloadSize()
+        {
+            size_t size = sizeof(FileHeader);
+            for (uint16_t i = 0; i < count; ++i)
+                size += sizeof(RecordHeader) + oldest(i).header.length;
+            return size;
+        }
+
+        // Copies the part of [from, from + size) that overlaps the requested window.
+        size_t copyWindow(const size_t from, const void* source, const size_t size,
+                          const size_t offset, uint8_t* out, const size_t len)
+        {
+            const size_t begin = std::max(from, offset);
+            const size_t end = std::min(from + size, offset + len);
+            if (begin >= end) return 0;
+            memcpy(out + (begin - offset), static_cast<const uint8_t*>(source) + (begin - from), end - begin);
+            return end - begin;
+        }
+    }
+
+    void setStateVersionSource(const Delegate<uint32_t()>& source)
+    {
+        std::lock_guard lock(traceMutex);
+        stateVersionSource = source;
+    }
+
+    void record(const Source source, const uint8_t channel, const uint8_t* data, const size_t len,
+                const uint32_t durationUs)
+    {
+        const auto timestampUs = static_cast<uint64_t>(esp_timer_get_time());
+        std::lock_guard lock(traceMutex);
+        if (CAPACITY == 0 || downloads > 0)
+        {
+            dropped++;
+            return;
+        }
+
+        auto& entry = records[head];
+        const auto stored = static_cast<uint8_t>(std::min<size_t>(len, MAX_PAYLOAD));
+        entry.header = {
+            timestampUs,
+            durationUs,
+            stateVersionSource ? stateVersionSource() : 0,
+            source,
+            channel,
+            static_cast<uint8_t>(stored < len ? TRUNCATED : 0),
+            stored
+        };
+        memcpy(entry.payload.data(), data, stored);
+
+        head = (head + 1) % CAPACITY;
+        if (count < CAPACITY)
+            count++;
+        else
+            dropped++;
+        recorded++;
+    }
+
+    void clear()
+    {
+        std::lock_guard lock(traceMutex);
+        if (downloads > 0) return;
+        head = 0;
+        count = 0;
+        recorded = 0;
+        dropped = 0;
+    }
+
+    const char* sourceName(const Source source)
+    {
+        switch (source)
+        {
+        case Source::EspNow: return "espNow";
+        case Source::WebSocket: return "webSocket";
+        case Source::Ble: return "ble";
+        case Source::Hue: return "hue";
+        default: return "unknown";
+        }
+    }
+
+    Stats getStats()
+    {
+        std::lock_guard lock(traceMutex);
+        return {count, recorded, dropped, downloadSize()};
+    }
+
+    size_t beginDownload()
+    {
+        std::lock_guard lock(traceMutex);
+        downloads++;
+        return downloadSize();
+    }
+
+    size_t read(const size_t offset, uint8_t* out, const size_t len)
+    {
+        std::lock_guard lock(traceMutex);
+        FileHeader fileHeader;
+        fileHeader.count = count;
+        fileHeader.dropped = dropped;
+
+        size_t written = copyWindow(0, &fileHeader, sizeof(fileHeader), offset, out, len);
+        size_t position = sizeof(fileHeader);
+        for (uint16_t i = 0; i < count && position < offset + len; ++i)
+        {
+            const auto& entry = oldest(i);
+            written += copyWindow(position, &entry.header, sizeof(RecordHeader), offset, out, len);
+            position += sizeof(RecordHeader);
+            written += copyWindow(position, entry.payload.data(), entry.header.length, offset, out, len);
+            position += entry.header.length;
+        }
+        return written;
+    }
+
+    void endDownload()
+    {
+        std::lock_guard lock(traceMutex);
+        if (downloads > 0) downloads--;
+    }
+}
@@ -1,5 +1,4 @@
 #include <Arduino.h>
-#include <LittleFS.h>
 #include <esp_now.h>
 
 #include "wifi_manager.hh"
@@ -14,19 +13,25 @@
 #include "rotary_encoder_manager.hh"
 #include "websocket_handler.hh"
 #include "esp_now_handler.hh"
-
+#include "task_registry.hh"
 #include "task_monitor.hpp"
+#include "telemetry.hh"
+#include "callback_budget_rest_handler.hh"
+#include "heap_accounting_rest_handler.hh"
+#include "command_trace_rest_handler.hh"
+#include "boot_timeline_rest_handler.hh"
+#include "power_rest_handler.hh"
+#include "stall_watchdog_rest_handler.hh"
+#include "binary_log_rest_handler.hh"
+#include "telemetry_history_rest_handler.hh"
+#if CONFIG_RGBW_CTRL_BENCHMARKS
+#include "bench_rest_handler.hh"
+#include "async_esp_alexa_color_utils.hh"
+#endif
 
-void monitor_task(void *pvParameters)
-{
-    while (1)
-    {
-        print_task_stats();
-        vTaskDelay(pdMS_TO_TICKS(5000)); // a cada 5s
-    }
-}
-
-void beginAlexaAndWebServer();
+void beginWebServer();
+void onGotIp();
+void registerBenchmarks();
 void onDataReceived(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, int data_len);
 
 static constexpr auto LOG_TAG = "Controller";
@@ -37,10 +42,7 @@ BoardLED boardLED(ControllerHardware::Pin::BoardLed::RED,
 
 PushButton boardButton(ControllerHardware::Pin::Button::BUTTON1);
 
-Output::Manager outputManager(ControllerHardware::Pin::Output::RED,
-                              ControllerHardware::Pin::Output::GREEN,
-                              ControllerHardware::Pin::Output::BLUE,
-                              ControllerHardware::Pin::Output::WHITE);
+Output::Manager outputManager;
 
 RotaryEncoderManager rotaryEncoderManager(ControllerHardware::Pin::Header::H1::P1,
                                           ControllerHardware::Pin::Header::H1::P2,
@@ -52,6 +54,20 @@ DeviceManager deviceManager;
 EspNow::ControllerHandler espNowHandler;
 AlexaIntegration alexaIntegration(outputManager);
 OTA::Handler otaHandler(httpManager.getAuthenticationMiddleware());
+TaskMonitor::Sampler taskMonitor;
+Profiler::RestHandler profilerRestHandler;
+CallbackBudget::RestHandler callbackBudgetRestHandler;
+HeapAccounting::RestHandler heapRestHandler;
+Trace::RestHandler traceRestHandler;
+BootTimeline::RestHandler bootTimelineRestHandler;
+Power::RestHandler powerRestHandler;
+StallWatchdog::RestHandler stallRestHandler;
+BinaryLog::RestHandler binaryLogRestHandler;
+TelemetryHistory::RestHandler historyRestHandler;
+#if CONFIG_RGBW_CTRL_BENCHMARKS
+Bench::RestHandler benchRestHandler;
+#endif
+Telemetry::Collector telemetryCollector;
 
 std::array<uint8_t, 4> advertisementData =
     BLE::Manager::buildAdvertisementData(54321, 0xAA, 0xAA);
@@ -75,7 +91,9 @@ WebSocket::Handler webSocketHandler(&outputManager,
                                     &bleManager,
                                     &deviceManager,
                                     &espNowHandler,
-                                    nullptr);
+                                    nullptr,
+                                    &taskMonitor,
+                                    &telemetryCollector);
 
 StateRestHandler stateRestHandler({
     &deviceManager,
@@ -87,56 +105,120 @@ StateRestHandler stateRestHandler({
     &espNowHandler
 });
 
+// Called by the Arduino core before setup(), as early as a sketch can run code.
+extern "C" void initVariant()
+{
+    outputManager.resume();
+}
+
 void setup()
 {
     ESP_LOGI(LOG_TAG, "Starting controller");
+    BootTimeline::mark(BootTimeline::Phase::Setup);
+
+    Tasks::adopt(Tasks::Plan::LOOP, xTaskGetCurrentTaskHandle());
+    StallWatchdog::begin(xTaskGetCurrentTaskHandle());
+    Async::begin();
+    BinaryLog::begin();
+    taskMonitor.begin();
+    Power::begin();
+    BootTimeline::mark(BootTimeline::Phase::Tasks);
 
     boardLED.begin();
     outputManager.begin();
+    Trace::setStateVersionSource([] { return outputManager.getStateVersion(); });
+    BootTimeline::mark(BootTimeline::Phase::Outputs);
+
     rotaryEncoderManager.begin();
     wifiManager.begin();
+    wifiManager.setGotIpCallback(onGotIp);
+    BootTimeline::mark(BootTimeline::Phase::WiFi);
+
+    // Association takes seconds, so it starts before the remaining NVS restores instead of after them.
+    const auto credentials = WiFiManager::loadCredentials();
+    if (credentials)
+    {
+        wifiManager.connect(credentials.value());
+        BootTimeline::mark(BootTimeline::Phase::Connect);
+    }
+
     deviceManager.begin();
+    TelemetryHistory::setInputSource([] { return deviceManager.getInputMillivolts(); });
     esp_now_init();
     esp_now_register_recv_cb(onDataReceived);
     espNowHandler.begin();
-    wifiManager.setGotIpCallback(beginAlexaAndWebServer);
     boardButton.setLongPressCallback([] { bleManager.start(); });
     boardButton.setShortPressCallback([] { outputManager.toggleAll(); });
+    registerBenchmarks();
     rotaryEncoderManager.onTurnLeft([] { outputManager.increaseBrightness(); });
     rotaryEncoderManager.onTurnRight([] { outputManager.decreaseBrightness(); });
+    BootTimeline::mark(BootTimeline::Phase::Restore);
 
-    LittleFS.begin(true);
-    if (const auto credentials = WiFiManager::loadCredentials())
-        wifiManager.connect(credentials.value());
-    else
+    alexaIntegration.begin();
+    BootTimeline::mark(BootTimeline::Phase::Alexa);
+
+    // Listening before the IP arrives lets the first request be served as soon as the station is up.
+    beginWebServer();
+
+    if (!credentials)
         bleManager.start();
-    ESP_LOGI(LOG_TAG, "Startup complete");
-    xTaskCreate(monitor_task, "monitor_task", 2048, NULL, 5, NULL);
+    BootTimeline::mark(BootTimeline::Phase::SetupDone);
+    const auto boot = WarmRestart::getBootTiming();
+    ESP_LOGI(LOG_TAG, "Startup complete, lights on %lld us after start (%s boot, reset reason %d)",
+             boot.lightsOnUs, boot.warm ? "warm" : "cold", static_cast<int>(boot.resetReason));
 }
 
 void loop()
 {
+    // Sleeping here rather than at the end keeps the delay out of the loop's profile.
+    Power::yieldLoop();
+    StallWatchdog::beat();
+
+    using Profiler::Component;
+    Profiler::Scope loopScope(Component::Loop);
+    TelemetryHistory::LoopScope historyScope;
+    BootTimeline::mark(BootTimeline::Phase::FirstLoop);
     const auto now = millis();
 
-    bleManager.handle(now);
-    boardButton.handle(now);
-    deviceManager.handle(now);
-    outputManager.handle(now);
-    webSocketHandler.handle(now);
-    alexaIntegration.handle(now);
-
-    boardLED.handle(
-        now,
-        bleManager.getStatus(),
-        wifiManager.getScanStatus(),
-        wifiManager.getStatus(),
-        otaHandler.getStatus() == OTA::Status::Started
-    );
+    Profiler::measure(Component::BleManager, [now] { bleManager.handle(now); });
+    Profiler::measure(Component::BoardButton, [now] { boardButton.handle(now); });
+    Profiler::measure(Component::DeviceManager, [now] { deviceManager.handle(now); });
+    Profiler::measure(Component::OutputManager, [now] { outputManager.handle(now); });
+    Profiler::measure(Component::WebSocketHandler, [now] { webSocketHandler.handle(now); });
+    HeapAccounting::handle(now);
+    CallbackBudget::handle();
+    LoadShedding::handle(now);
+    TelemetryHistory::handle(now);
+    Profiler::measure(Component::AlexaIntegration, [now] { alexaIntegration.handle(now); });
+#if CONFIG_RGBW_CTRL_BENCHMARKS
+    Bench::handle();
+#endif
+
+    Profiler::measure(Component::BoardLed, [now]
+    {
+        boardLED.handle(
+            now,
+            bleManager.getStatus(),
+            wifiManager.getScanStatus(),
+            wifiManager.getStatus(),
+            otaHandler.getStatus() == OTA::Status::Started
+        );
+    });
+
+    Power::hold(Power::Lock::Pwm, outputManager.anyOn());
+    Power::hold(Power::Lock::Session,
+                webSocketHandler.hasClients() || bleManager.getStatus() == BLE::Status::CONNECTED);
+    Power::hold(Power::Lock::Transfer, otaHandler.getStatus() == OTA::Status::Started);
 }
 
-void beginAlexaAndWebServer()
+void onGotIp()
+{
+    BootTimeline::mark(BootTimeline::Phase::GotIp);
+    alexaIntegration.startDiscovery();
+}
+
+void beginWebServer()
 {
-    alexaIntegration.begin();
     httpManager.begin(
         alexaIntegration.createAsyncWebHandler(),
         {
@@ -145,13 +227,98 @@ void beginAlexaAndWebServer()
             &stateRestHandler,
             &bleManager,
             &deviceManager,
-            &outputManager
+            &outputManager,
+            &taskMonitor,
+            &profilerRestHandler,
+            &callbackBudgetRestHandler,
+            &heapRestHandler,
+            &traceRestHandler,
+            &bootTimelineRestHandler,
+            &powerRestHandler,
+            &stallRestHandler,
+            &binaryLogRestHandler,
+            &historyRestHandler,
+#if CONFIG_RGBW_CTRL_BENCHMARKS
+            &benchRestHandler,
+#endif
         }
     );
 }
 
+void registerBenchmarks()
+{
+#if CONFIG_RGBW_CTRL_BENCHMARKS
+    // Inputs vary between iterations so the kernels can't be folded into constants.
+    static uint16_t counter = 0;
+    using Utils = AsyncEspAlexaColorUtils;
+
+    Bench::add("color.hsvToRgbw", []
+    {
+        Bench::keep(Utils::hsvToRgbw(counter++ * 97, 200, 180));
+    }, 1000);
+    Bench::add("color.ctToRgbw", []
+    {
+        Bench::keep(Utils::ctToRgbw(180, Utils::CT_MIN_MIREDS + counter++ % 347));
+    }, 1000);
+    Bench::add("color.xyToHsv", []
+    {
+        Bench::keep(Utils::xyToHsv(0.2f + static_cast<float>(counter++ % 100) / 400.0f, 0.3f, 200));
+    }, 1000);
+    Bench::add("color.rgbwToHsv", []
+    {
+        const auto value = static_cast<uint8_t>(counter++);
+        Bench::keep(Utils::rgbwToHsv(value, 255 - value, 64, 32));
+    }, 1000);
+    Bench::add("light.perceptualBrightnessStep", []
+    {
+        const auto value = static_cast<uint8_t>(counter++);
+        Bench::keep(Light::perceptualBrightnessStep(value, value & 1));
+    }, 1000);
+    Bench::add("json.state", []
+    {
+        static char buffer[2048];
+        Json::PooledDocument document;
+        stateRestHandler.fillState(document.to<JsonObject>());
+        Bench::keep(serializeJson(document, buffer, sizeof(buffer)));
+    }, 50);
+    // Same document as json.state; the difference is the cost of the MessagePack encoder.
+    Bench::add("msgpack.state", []
+    {
+        static uint8_t buffer[2048];
+        Json::PooledDocument document;
+        stateRestHandler.fillState(document.to<JsonObject>());
+        Bench::keep(serializeMsgPack(document, buffer, sizeof(buffer)));
+    }, 50);
+    Bench::add("websocket.colorMessage", []
+    {
+        const WebSocket::ColorMessage message(outputManager.getState());
+        Bench::keep(message);
+    }, 1000);
+    // Alternating values make every put a real flash write; keep the count low.
+    Bench::add("nvs.write", []
+    {
+        static Preferences prefs;
+        static const bool opened = prefs.begin("bench", false);
+        if (opened) prefs.putUInt("counter", counter++);
+    }, 16);
+    // The output kernels share the lights' state with the main loop, so they run on it.
+    // Rewrites the duty the last LEDC output already has.
+    if constexpr (ControllerHardware::findLastLedcOutput().has_value())
+        Bench::add("ledc.write", []
+        {
+            constexpr auto index = ControllerHardware::findLastLedcOutput().value_or(0);
+            constexpr auto& output = ControllerHardware::BOARD.outputs[index];
+            const auto on = outputManager.isOn(output.color, output.zone);
+            ledcWrite(output.pwmChannel, on ? outputManager.getValue(output.color, output.zone) : 0);
+        }, 200, Bench::Context::Loop);
+    // Sends every output's unchanged duty again: one I2C burst per expander, one register write per LEDC channel.
+    Bench::add("output.refresh", [] { outputManager.refresh(); }, 100, Bench::Context::Loop);
+#endif
+}
+
 void onEspNowMessage(const EspNow::Message* message)
 {
+    HeapAccounting::NoAllocGuard noAlloc("onEspNowMessage");
     switch (message->type)
     {
     case EspNow::Message::Type::ToggleRed:
@@ -186,19 +353,28 @@ void onEspNowMessage(const EspNow::Message* message)
 
 void onDataReceived(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, int data_len)
 {
+    CallbackBudget::Scope budget(CallbackBudget::Context::EspNow, "onDataReceived",
+                                 data_len > 0 ? data[0] : CallbackBudget::NO_DETAIL);
+    HeapAccounting::Scope heapScope(HeapAccounting::Tag::EspNow);
     const auto& mac = esp_now_info->src_addr;
-    ESP_LOGI(LOG_TAG, "Data received from %02X:%02X:%02X:%02X:%02X:%02X, length: %d",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], data_len);
+    BINARY_LOGI(BinaryLog::Tag::Controller, "Data received from %02X:%02X:%02X:%02X:%02X:%02X",
+                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 
     if (!espNowHandler.isMacAllowed(mac))
     {
-        ESP_LOGW(LOG_TAG, "MAC address not allowed, ignoring packet");
+        BINARY_LOGW(BinaryLog::Tag::Controller, "MAC address not allowed, ignoring packet");
         return;
     }
 
-    if (data_len != sizeof(EspNow::Message)) return;
+    if (data_len != sizeof(EspNow::Message))
+    {
+        BINARY_LOGW(BinaryLog::Tag::Controller, "Unexpected ESP-NOW message length: %d", data_len);
+        return;
+    }
 
     const auto message = reinterpret_cast<EspNow::Message*>(const_cast<uint8_t*>(data));
 
+    Power::CommandScope power;
+    Trace::Scope trace(Trace::Source::EspNow, data, data_len);
     onEspNowMessage(message);
 }
@@ -0,0 +1,240 @@
+#include "heap_accounting.hh"
+
+#include <mutex>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h> // NOLINT
+
+namespace HeapAccounting
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "HeapAccounting";
+
+        // Open-addressing table mapping tagged blocks to their tag and size.
+        constexpr size_t TABLE_SIZE = 256;
+        constexpr size_t TABLE_MASK = TABLE_SIZE - 1;
+
+        struct Block
+        {
+            void* ptr;
+            uint32_t size : 24;
+            uint32_t tag : 8;
+        };
+
+        Block blocks[TABLE_SIZE] = {};
+        TagStats tagStats[TAG_COUNT] = {};
+        uint32_t untrackedAllocations = 0;
+        portMUX_TYPE blocksSpinlock = portMUX_INITIALIZER_UNLOCKED;
+
+        thread_local Tag currentTag = Tag::Untagged;
+        thread_local uint32_t taskAllocations = 0;
+
+        std::mutex historyMutex;
+        History history;
+        uint8_t historyHead = 0;
+        unsigned long lastSample = 0;
+        uint16_t lowHeapEvents = 0;
+        bool low = false;
+        NoAllocStats noAllocStats;
+
+        IRAM_ATTR size_t home(const void* ptr)
+        {
+            return ((reinterpret_cast<uintptr_t>(ptr) >> 3) * 2654435761u >> 24) & TABLE_MASK;
+        }
+
+        IRAM_ATTR bool isBetween(const size_t from, const size_t value, const size_t to)
+        {
+            return from <= to ? from < value && value <= to : from < value || value <= to;
+        }
+
+        // Backward-shift deletion keeps probe chains intact without tombstones.
+        IRAM_ATTR void erase(size_t hole)
+        {
+            size_t next = hole;
+            while (true)
+            {
+                blocks[hole].ptr = nullptr;
+                while (true)
+                {
+                    next = (next + 1) & TABLE_MASK;
+                    if (blocks[next].ptr == nullptr) return;
+                    if (!isBetween(hole, home(blocks[next].ptr), next)) break;
+                }
+                blocks[hole] = blocks[next];
+                hole = next;
+            }
+        }
+
+        void sample()
+        {
+            const auto largest = static_cast<uint32_t>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+            const auto freeHeap = static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+
+            std::lock_guard lock(historyMutex);
+            history.largestFreeBlock[historyHead] = largest;
+            historyHead = (historyHead + 1) % HISTORY_LENGTH;
+            if (history.count < HISTORY_LENGTH) history.count++;
+
+            const bool belowThreshold = freeHeap < CONFIG_RGBW_CTRL_LOW_HEAP_BYTES ||
+                largest < CONFIG_RGBW_CTRL_LOW_HEAP_LARGEST_BLOCK_BYTES;
+            if (belowThreshold && !low)
+            {
+                lowHeapEvents++;
+                ESP_LOGW(LOG_TAG, "Low heap: %lu bytes free, largest block %lu bytes", freeHeap, largest);
+            }
+            low = belowThreshold;
+        }
+    }
+
+    void handle(const unsigned long now)
+    {
+        if (lastSample != 0 && now - lastSample < SAMPLE_INTERVAL_MS) return;
+        lastSample = now;
+        sample();
+    }
+
+    const char* tagName(const Tag tag)
+    {
+        switch (tag)
+        {
+        case Tag::Untagged: return "untagged";
+        case Tag::WebSocket: return "webSocket";
+        case Tag::Alexa: return "alexa";
+        case Tag::Ble: return "ble";
+        case Tag::Http: return "http";
+        case Tag::WiFi: return "wifi";
+        case Tag::EspNow: return "espNow";
+        default: return "unknown";
+        }
+    }
+
+    TagStats getStats(const Tag tag)
+    {
+        portENTER_CRITICAL(&blocksSpinlock);
+        const auto stats = tagStats[static_cast<uint8_t>(tag)];
+        portEXIT_CRITICAL(&blocksSpinlock);
+        return stats;
+    }
+
+    Summary getSummary()
+    {
+        Summary summary;
+        summary.freeHeap = static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+        summary.minimumFreeHeap = static_cast<uint32_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+        summary.largestFreeBlock = static_cast<uint32_t>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+        {
+            std::lock_guard lock(historyMutex);
+            summary.lowHeapEvents = lowHeapEvents;
+            summary.low = low;
+        }
+        portENTER_CRITICAL(&blocksSpinlock);
+        for (uint8_t i = 0; i < TAG_COUNT; ++i)
+            summary.liveBytes[i] = tagStats[i].liveBytes;
+        portEXIT_CRITICAL(&blocksSpinlock);
+        return summary;
+    }
+
+    History getHistory()
+    {
+        std::lock_guard lock(historyMutex);
+        History ordered;
+        ordered.count = history.count;
+        const uint8_t first = (historyHead + HISTORY_LENGTH - history.count) % HISTORY_LENGTH;
+        for (uint8_t i = 0; i < history.count; ++i)
+            ordered.largestFreeBlock[i] = history.largestFreeBlock[(first + i) % HISTORY_LENGTH];
+        return ordered;
+    }
+
+    uint16_t getLowHeapEvents()
+    {
+        std::lock_guard lock(historyMutex);
+        return lowHeapEvents;
+    }
+
+    uint32_t getUntrackedAllocations()
+    {
+        portENTER_CRITICAL(&blocksSpinlock);
+        const auto untracked = untrackedAllocations;
+        portEXIT_CRITICAL(&blocksSpinlock);
+        return untracked;
+    }
+
+    Tag setCurrentTag(const Tag tag)
+    {
+        const auto previous = currentTag;
+        currentTag = tag;
+        return previous;
+    }
+
+    uint32_t getTaskAllocations()
+    {
+        return taskAllocations;
+    }
+
+    void reportSteadyStateAllocation(const char* path, const uint32_t allocations)
+    {
+        {
+            std::lock_guard lock(historyMutex);
+            noAllocStats.violations++;
+            noAllocStats.lastPath = path;
+        }
+        ESP_LOGE(LOG_TAG, "%s allocated %lu time(s) on a steady-state path", path, allocations);
+#if CONFIG_RGBW_CTRL_NO_ALLOC_ABORT
+        abort();
+#endif
+    }
+
+    NoAllocStats getNoAllocStats()
+    {
+        std::lock_guard lock(historyMutex);
+        return noAllocStats;
+    }
+
+#if CONFIG_HEAP_USE_HOOKS
+    extern "C" IRAM_ATTR void esp_heap_trace_alloc_hook(void* ptr, const size_t size, uint32_t /*caps*/)
+    {
+        if (ptr == nullptr || xPortInIsrContext()) return;
+        taskAllocations++;
+        const auto tag = currentTag;
+        if (tag == Tag::Untagged) return;
+
+        portENTER_CRITICAL_SAFE(&blocksSpinlock);
+        auto& stats = tagStats[static_cast<uint8_t>(tag)];
+        stats.allocations++;
+        size_t slot = home(ptr);
+        for (size_t probes = 0; probes < TABLE_SIZE; ++probes, slot = (slot + 1) & TABLE_MASK)
+        {
+            if (blocks[slot].ptr != nullptr) continue;
+            blocks[slot] = {ptr, static_cast<uint32_t>(size), static_cast<uint32_t>(tag)};
+            stats.liveBytes += size;
+            if (stats.liveBytes > stats.peakBytes) stats.peakBytes = stats.liveBytes;
+            portEXIT_CRITICAL_SAFE(&blocksSpinlock);
+            return;
+        }
+        untrackedAllocations++;
+        portEXIT_CRITICAL_SAFE(&blocksSpinlock);
+    }
+
+    extern "C" IRAM_ATTR void esp_heap_trace_free_hook(void* ptr)
+    {
+        if (ptr == nullptr) return;
+
+        portENTER_CRITICAL_SAFE(&blocksSpinlock);
+        size_t slot = home(ptr);
+        for (size_t probes = 0; probes < TABLE_SIZE && blocks[slot].ptr != nullptr;
+             ++probes, slot = (slot + 1) & TABLE_MASK)
+        {
+            if (blocks[slot].ptr != ptr) continue;
+            auto& stats = tagStats[blocks[slot].tag];
+            stats.liveBytes -= blocks[slot].size;
+            stats.frees++;
+            erase(slot);
+            break;
+        }
+        portEXIT_CRITICAL_SAFE(&blocksSpinlock);
+    }
+
+#endif
+}
@@ -0,0 +1,227 @@
+#include "json_pool.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <ChunkPrint.h>
+
+namespace Json
+{
+    namespace
+    {
+        // Every block is preceded by its size, padded so payloads stay 8-byte aligned.
+        constexpr size_t HEADER_SIZE = 8;
+        constexpr size_t ALIGNMENT = 8;
+        constexpr size_t NO_BLOCK = SIZE_MAX;
+
+        struct Arena
+        {
+            alignas(ALIGNMENT) std::array<uint8_t, ARENA_SIZE> memory;
+            size_t used = 0;
+            size_t peak = 0;
+            size_t lastBlock = NO_BLOCK;
+
+            [[nodiscard]] bool owns(const void* ptr) const
+            {
+                const auto address = static_cast<const uint8_t*>(ptr);
+                return address >= memory.data() && address < memory.data() + memory.size();
+            }
+
+            static size_t& sizeOf(void* ptr)
+            {
+                return *reinterpret_cast<size_t*>(static_cast<uint8_t*>(ptr) - HEADER_SIZE);
+            }
+
+            [[nodiscard]] size_t offsetOf(const void* ptr) const
+            {
+                return static_cast<const uint8_t*>(ptr) - memory.data() - HEADER_SIZE;
+            }
+
+            void* allocate(const size_t size)
+            {
+                const size_t total = HEADER_SIZE + (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+                if (total > memory.size() - used) return nullptr;
+                void* ptr = memory.data() + used + HEADER_SIZE;
+                sizeOf(ptr) = size;
+                lastBlock = used;
+                used += total;
+                peak = std::max(peak, used);
+                return ptr;
+            }
+
+            // Only the most recent block can be given back; others are reclaimed on reset.
+            void release(void* ptr)
+            {
+                if (offsetOf(ptr) != lastBlock) return;
+                used = lastBlock;
+                lastBlock = NO_BLOCK;
+            }
+
+            // Resizes in place when the block is the most recent one or when shrinking.
+            void* resize(void* ptr, const size_t newSize)
+            {
+                if (newSize <= sizeOf(ptr))
+                {
+                    sizeOf(ptr) = newSize;
+                    return ptr;
+                }
+                const auto offset = offsetOf(ptr);
+                if (offset != lastBlock) return nullptr;
+                const size_t total = HEADER_SIZE + (newSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+                if (total > memory.size() - offset) return nullptr;
+                sizeOf(ptr) = newSize;
+                used = offset + total;
+                peak = std::max(peak, used);
+                return ptr;
+            }
+        };
+
+        std::mutex poolMutex;
+        std::array<Arena, ARENA_COUNT> arenas;
+        PoolStats stats;
+
+        struct alignas(PooledResponse) ResponseSlot
+        {
+            std::array<uint8_t, sizeof(PooledResponse)> memory;
+        };
+
+        std::array<ResponseSlot, ARENA_COUNT> responseSlots;
+        std::array<bool, ARENA_COUNT> responseSlotUsed = {};
+
+        int8_t leaseArena()
+        {
+            std::lock_guard lock(poolMutex);
+            for (uint8_t i = 0; i < ARENA_COUNT; ++i)
+            {
+                if (stats.arenas[i].leased) continue;
+                stats.arenas[i].leased = true;
+                stats.arenas[i].leases++;
+                return static_cast<int8_t>(i);
+            }
+            stats.exhausted++;
+            return -1;
+        }
+
+        void returnArena(const int8_t index)
+        {
+            std::lock_guard lock(poolMutex);
+            auto& arena = arenas[index];
+            auto& arenaStats = stats.arenas[index];
+            arenaStats.highWaterMark = std::max(arenaStats.highWaterMark, static_cast<uint32_t>(arena.peak));
+            arenaStats.leased = false;
+            arena.used = 0;
+            arena.peak = 0;
+            arena.lastBlock = NO_BLOCK;
+        }
+
+        void countHeapFallback()
+        {
+            std::lock_guard lock(poolMutex);
+            stats.heapFallbacks++;
+        }
+    }
+
+    PoolStats getPoolStats()
+    {
+        std::lock_guard lock(poolMutex);
+        return stats;
+    }
+
+    ArenaAllocator::~ArenaAllocator()
+    {
+        if (arena >= 0) returnArena(arena);
+    }
+
+    void* ArenaAllocator::allocate(const size_t size)
+    {
+        if (!leaseAttempted)
+        {
+            leaseAttempted = true;
+            arena = leaseArena();
+        }
+        if (arena >= 0)
+        {
+            if (void* ptr = arenas[arena].allocate(size)) return ptr;
+            countHeapFallback();
+        }
+        return malloc(size);
+    }
+
+    void ArenaAllocator::deallocate(void* ptr)
+    {
+        if (ptr == nullptr) return;
+        if (arena >= 0 && arenas[arena].owns(ptr))
+            return arenas[arena].release(ptr);
+        free(ptr);
+    }
+
+    void* ArenaAllocator::reallocate(void* ptr, const size_t newSize)
+    {
+        if (ptr == nullptr) return allocate(newSize);
+        if (arena < 0 || !arenas[arena].owns(ptr)) return realloc(ptr, newSize);
+
+        auto& owner = arenas[arena];
+        if (void* resized = owner.resize(ptr, newSize)) return resized;
+
+        void* moved = allocate(newSize);
+        if (moved == nullptr) return nullptr;
+        memcpy(moved, ptr, Arena::sizeOf(ptr));
+        owner.release(ptr);
+        return moved;
+    }
+
+    void* PooledResponse::operator new(const size_t size)
+    {
+        {
+            std::lock_guard lock(poolMutex);
+            for (uint8_t i = 0; i < ARENA_COUNT; ++i)
+            {
+                if (responseSlotUsed[i]) continue;
+                responseSlotUsed[i] = true;
+                return responseSlots[i].memory.data();
+            }
+            stats.responseFallbacks++;
+        }
+        return ::operator new(size);
+    }
+
+    void PooledResponse::operator delete(void* ptr)
+    {
+        if (ptr == nullptr) return;
+        const auto* slot = static_cast<const ResponseSlot*>(ptr);
+        if (slot >= responseSlots.data() && slot < responseSlots.data() + ARENA_COUNT)
+        {
+            std::lock_guard lock(poolMutex);
+            responseSlotUsed[slot - responseSlots.data()] = false;
+            return;
+        }
+        ::operator delete(ptr);
+    }
+
+    PooledResponse::PooledResponse(const bool isArray, const Format format) : format(format)
+    {
+        _code = 200;
+        setContentType(format == Format::MsgPack ? "application/msgpack" : "application/json");
+        if (isArray)
+            root = document.add<JsonArray>();
+        else
+            root = document.add<JsonObject>();
+    }
+
+    size_t PooledResponse::setLength()
+    {
+        _contentLength = format == Format::MsgPack ? measureMsgPack(root) : measureJson(root);
+        if (_contentLength) valid = true;
+        return _contentLength;
+    }
+
+    size_t PooledResponse::_fillBuffer(uint8_t* data, const size_t len)
+    {
+        ChunkPrint destination(data, _sentLength, len);
+        if (format == Format::MsgPack)
+            serializeMsgPack(root, destination);
+        else
+            serializeJson(root, destination);
+        return len;
+    }
+}
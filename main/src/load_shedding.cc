@@ -0,0 +1,109 @@
+#include "load_shedding.hh"
+
+#include <mutex>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+namespace LoadShedding
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "LoadShedding";
+
+        std::mutex countersMutex;
+        Counters counters;
+        unsigned long lastEvaluation = 0;
+
+        Level levelFor(const uint32_t freeHeap)
+        {
+            for (auto i = static_cast<uint8_t>(LEVEL_COUNT - 1); i > 0; --i)
+            {
+                const auto candidate = static_cast<Level>(i);
+                if (freeHeap < watermark(candidate)) return candidate;
+            }
+            return Level::Normal;
+        }
+    }
+
+    bool shed(const Load load)
+    {
+        if (!isShedding(load)) return false;
+        std::lock_guard lock(countersMutex);
+        auto& count = counters.shed[static_cast<uint8_t>(load)];
+        if (count < UINT16_MAX) count++;
+        return true;
+    }
+
+    void handle(const unsigned long now)
+    {
+        if (now - lastEvaluation < EVALUATION_INTERVAL_MS) return;
+        lastEvaluation = now;
+
+        const auto freeHeap = static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+        const auto current = level.load(std::memory_order_relaxed);
+        const auto pressured = levelFor(freeHeap);
+        const auto relieved = levelFor(freeHeap > HYSTERESIS_BYTES ? freeHeap - HYSTERESIS_BYTES : 0);
+        const auto next = pressured > current ? pressured : relieved < current ? relieved : current;
+        if (next == current) return;
+
+        level.store(next, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(countersMutex);
+            counters.level = next;
+            counters.transitions++;
+            counters.lastTransitionMs = now;
+            counters.freeHeapAtTransition = freeHeap;
+        }
+        if (next > current)
+            ESP_LOGW(LOG_TAG, "Heap at %lu bytes, shedding level %s", freeHeap, levelName(next));
+        else
+            ESP_LOGI(LOG_TAG, "Heap recovered to %lu bytes, shedding level %s", freeHeap, levelName(next));
+    }
+
+    const char* levelName(const Level level)
+    {
+        switch (level)
+        {
+        case Level::Normal: return "normal";
+        case Level::Reduced: return "reduced";
+        case Level::Shedding: return "shedding";
+        case Level::Critical: return "critical";
+        default: return "unknown";
+        }
+    }
+
+    const char* loadName(const Load load)
+    {
+        switch (load)
+        {
+        case Load::Broadcasts: return "broadcasts";
+        case Load::NewClients: return "newClients";
+        case Load::StaticAssets: return "staticAssets";
+        case Load::BleStart: return "bleStart";
+        default: return "unknown";
+        }
+    }
+
+    uint32_t watermark(const Level level)
+    {
+        switch (level)
+        {
+        case Level::Reduced: return CONFIG_RGBW_CTRL_SHED_REDUCED_BYTES;
+        case Level::Shedding: return CONFIG_RGBW_CTRL_SHED_BYTES;
+        case Level::Critical: return CONFIG_RGBW_CTRL_SHED_CRITICAL_BYTES;
+        default: return 0;
+        }
+    }
+
+    uint16_t getTransitions()
+    {
+        std::lock_guard lock(countersMutex);
+        return counters.transitions;
+    }
+
+    Counters getCounters()
+    {
+        std::lock_guard lock(countersMutex);
+        return counters;
+    }
+}
@@ -0,0 +1,149 @@
+#include "pca9685.hh"
+
+#include <esp_log.h>
+
+namespace OutputBackend
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "Pca9685";
+
+        constexpr uint8_t MODE1 = 0x00;
+        constexpr uint8_t MODE2 = 0x01;
+        constexpr uint8_t LED0_ON_L = 0x06;
+        constexpr uint8_t PRE_SCALE = 0xFE;
+        constexpr uint8_t REGISTERS_PER_CHANNEL = 4;
+
+        constexpr uint8_t MODE1_AUTO_INCREMENT = 0x20;
+        constexpr uint8_t MODE1_SLEEP = 0x10;
+        constexpr uint8_t MODE2_TOTEM_POLE = 0x04;
+        // Bit 4 of LEDn_ON_H and LEDn_OFF_H holds the output fully on or off.
+        constexpr uint8_t FULL = 0x10;
+
+        constexpr uint32_t OSCILLATOR_HZ = 25000000;
+        constexpr uint32_t STEPS = 4096;
+        constexpr uint8_t PRESCALE = (OSCILLATOR_HZ + STEPS * Pca9685::PWM_FREQUENCY / 2)
+            / (STEPS * Pca9685::PWM_FREQUENCY) - 1;
+        constexpr unsigned long INIT_RETRY_MS = 1000;
+        // The oscillator needs 500 us after leaving sleep.
+        constexpr uint32_t WAKE_UP_US = 500;
+
+        // LEDn_ON_L..LEDn_OFF_H for an 8-bit duty; every cycle starts at step 0.
+        void encode(const uint8_t duty, uint8_t* out)
+        {
+            const uint16_t off = duty * (STEPS - 1) / UINT8_MAX;
+            out[0] = 0;
+            out[1] = duty == UINT8_MAX ? FULL : 0;
+            out[2] = duty == 0 ? 0 : off & 0xFF;
+            out[3] = duty == 0 ? FULL : duty == UINT8_MAX ? 0 : off >> 8;
+        }
+    }
+
+    Pca9685::Pca9685(TwoWire& wire, const uint8_t address, const gpio_num_t sda, const gpio_num_t scl)
+        : wire(wire), address(address), sda(sda), scl(scl)
+    {
+    }
+
+    void Pca9685::attach(const uint8_t channel, gpio_num_t)
+    {
+        if (channel >= CHANNELS)
+        {
+            ESP_LOGE(LOG_TAG, "Channel %u out of range on 0x%02x", channel, address);
+            return;
+        }
+        if (!initialized) initialize();
+    }
+
+    void Pca9685::write(const uint8_t channel, const uint8_t duty)
+    {
+        if (channel >= CHANNELS) return;
+        std::lock_guard lock(mutex);
+        duties[channel] = duty;
+        dirty |= 1u << channel;
+    }
+
+    void Pca9685::flush()
+    {
+        uint16_t changed;
+        std::array<uint8_t, CHANNELS> snapshot;
+        {
+            std::lock_guard lock(mutex);
+            changed = dirty;
+            dirty = 0;
+            snapshot = duties;
+        }
+        if (changed == 0) return;
+
+        const auto restore = [this, changed]
+        {
+            std::lock_guard lock(mutex);
+            dirty |= changed;
+        };
+        if (!initialized && !initialize()) return restore();
+
+        // One write from the first to the last changed channel; unchanged ones in between are resent.
+        const auto first = static_cast<uint8_t>(__builtin_ctz(changed));
+        const auto last = static_cast<uint8_t>(31 - __builtin_clz(changed));
+        wire.beginTransmission(address);
+        wire.write(LED0_ON_L + first * REGISTERS_PER_CHANNEL);
+        for (auto channel = first; channel <= last; ++channel)
+        {
+            uint8_t registers[REGISTERS_PER_CHANNEL];
+            encode(snapshot[channel], registers);
+            wire.write(registers, sizeof(registers));
+        }
+        const bool ok = wire.endTransmission() == 0;
+        countTransaction(1 + (last - first + 1) * REGISTERS_PER_CHANNEL, ok);
+        if (ok) return;
+
+        ESP_LOGW(LOG_TAG, "Write to 0x%02x failed, reinitializing", address);
+        initialized = false;
+        restore();
+    }
+
+    Pca9685::Stats Pca9685::getStats() const
+    {
+        std::lock_guard lock(mutex);
+        return stats;
+    }
+
+    bool Pca9685::initialize()
+    {
+        const auto now = millis();
+        if (lastInitAttempt != 0 && now - lastInitAttempt < INIT_RETRY_MS) return false;
+        lastInitAttempt = now == 0 ? 1 : now;
+
+        wire.begin(sda, scl, I2C_CLOCK);
+        // The prescaler can only be written while the oscillator sleeps.
+        initialized = writeRegister(MODE1, MODE1_SLEEP | MODE1_AUTO_INCREMENT)
+            && writeRegister(PRE_SCALE, PRESCALE)
+            && writeRegister(MODE2, MODE2_TOTEM_POLE)
+            && writeRegister(MODE1, MODE1_AUTO_INCREMENT);
+        if (!initialized)
+        {
+            ESP_LOGE(LOG_TAG, "No PCA9685 answering at 0x%02x", address);
+            return false;
+        }
+        delayMicroseconds(WAKE_UP_US);
+        ESP_LOGI(LOG_TAG, "PCA9685 at 0x%02x running at %u Hz", address, PWM_FREQUENCY);
+        return true;
+    }
+
+    bool Pca9685::writeRegister(const uint8_t reg, const uint8_t value)
+    {
+        wire.beginTransmission(address);
+        wire.write(reg);
+        wire.write(value);
+        const bool ok = wire.endTransmission() == 0;
+        countTransaction(2, ok);
+        return ok;
+    }
+
+    void Pca9685::countTransaction(const size_t bytes, const bool ok)
+    {
+        std::lock_guard lock(mutex);
+        stats.transactions++;
+        stats.bytes += bytes;
+        if (!ok) stats.errors++;
+    }
+}
@@ -0,0 +1,213 @@
+#include "power.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <esp_log.h>
+#include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace Power
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "Power";
+
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE && CONFIG_RGBW_CTRL_LIGHT_SLEEP
+        constexpr bool LIGHT_SLEEP = true;
+#else
+        constexpr bool LIGHT_SLEEP = false;
+#endif
+
+        struct LatencyTotal
+        {
+            uint32_t count = 0;
+            uint64_t totalUs = 0;
+            uint32_t maxUs = 0;
+
+            void add(const uint32_t durationUs)
+            {
+                count++;
+                totalUs += durationUs;
+                maxUs = std::max(maxUs, durationUs);
+            }
+
+            [[nodiscard]] Latency get() const
+            {
+                return {count, count ? static_cast<uint32_t>(totalUs / count) : 0, maxUs};
+            }
+        };
+
+        std::mutex powerMutex;
+        bool enabled = false;
+#if CONFIG_PM_ENABLE
+        std::array<esp_pm_lock_handle_t, LOCK_COUNT> handles = {};
+#endif
+        // Bit per Lock; read without the mutex by CommandScope.
+        std::atomic<uint8_t> heldLocks = 0;
+        std::array<uint32_t, LOCK_COUNT> acquisitions = {};
+        std::array<uint64_t, FLOOR_COUNT> lockFloorUs = {};
+        Floor currentFloor = LIGHT_SLEEP ? Floor::LightSleep : Floor::Awake;
+        int64_t floorSince = 0;
+        LatencyTotal handlingAfterIdle;
+        LatencyTotal handlingWhileHeld;
+
+        bool isHeld(const uint8_t mask, const Lock lock)
+        {
+            return mask & 1 << static_cast<uint8_t>(lock);
+        }
+
+        Floor floorOf(const uint8_t mask)
+        {
+            if (isHeld(mask, Lock::Transfer)) return Floor::CpuMax;
+            if (isHeld(mask, Lock::Pwm)) return Floor::ApbMax;
+            if (isHeld(mask, Lock::Session) || !LIGHT_SLEEP) return Floor::Awake;
+            return Floor::LightSleep;
+        }
+
+        // Called with powerMutex held.
+        void accountFloor(const int64_t now)
+        {
+            lockFloorUs[static_cast<uint8_t>(currentFloor)] += now - floorSince;
+            floorSince = now;
+        }
+
+#if CONFIG_PM_ENABLE
+        esp_pm_lock_type_t lockType(const Lock lock)
+        {
+            switch (lock)
+            {
+            case Lock::Pwm: return ESP_PM_APB_FREQ_MAX;
+            case Lock::Transfer: return ESP_PM_CPU_FREQ_MAX;
+            default: return ESP_PM_NO_LIGHT_SLEEP;
+            }
+        }
+#endif
+    }
+
+    void begin()
+    {
+        std::lock_guard lock(powerMutex);
+        floorSince = esp_timer_get_time();
+#if CONFIG_PM_ENABLE
+        const esp_pm_config_t config = {
+            .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+            .min_freq_mhz = CONFIG_RGBW_CTRL_PM_MIN_CPU_MHZ,
+            .light_sleep_enable = LIGHT_SLEEP,
+        };
+        if (const auto err = esp_pm_configure(&config); err != ESP_OK)
+        {
+            ESP_LOGE(LOG_TAG, "esp_pm_configure failed: %d", err);
+            return;
+        }
+        for (uint8_t i = 0; i < LOCK_COUNT; ++i)
+        {
+            const auto powerLock = static_cast<Lock>(i);
+            if (esp_pm_lock_create(lockType(powerLock), 0, lockName(powerLock), &handles[i]) != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to create the %s lock", lockName(powerLock));
+                return;
+            }
+        }
+        enabled = true;
+        ESP_LOGI(LOG_TAG, "Power management on: %d-%d MHz, light sleep %s", CONFIG_RGBW_CTRL_PM_MIN_CPU_MHZ,
+                 CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, LIGHT_SLEEP ? "on" : "off");
+#else
+        ESP_LOGI(LOG_TAG, "CONFIG_PM_ENABLE is off; the CPU stays at full speed");
+#endif
+    }
+
+    void hold(const Lock lock, const bool held)
+    {
+        const auto bit = static_cast<uint8_t>(1 << static_cast<uint8_t>(lock));
+        // Called on every loop pass; most calls change nothing and stop here.
+        if (((heldLocks.load(std::memory_order_relaxed) & bit) != 0) == held) return;
+
+        std::lock_guard guard(powerMutex);
+        const uint8_t previous = heldLocks.load();
+        if (((previous & bit) != 0) == held) return;
+#if CONFIG_PM_ENABLE
+        if (enabled)
+        {
+            const auto handle = handles[static_cast<uint8_t>(lock)];
+            if (held) esp_pm_lock_acquire(handle);
+            else esp_pm_lock_release(handle);
+        }
+#endif
+        const auto mask = static_cast<uint8_t>(held ? previous | bit : previous & ~bit);
+        heldLocks = mask;
+        if (held) acquisitions[static_cast<uint8_t>(lock)]++;
+        accountFloor(esp_timer_get_time());
+        currentFloor = floorOf(mask);
+    }
+
+    bool isIdle()
+    {
+        return heldLocks.load(std::memory_order_relaxed) == 0;
+    }
+
+    void yieldLoop()
+    {
+        const uint32_t delayMs = isIdle() ? CONFIG_RGBW_CTRL_IDLE_LOOP_DELAY_MS : CONFIG_RGBW_CTRL_LOOP_DELAY_MS;
+        if (delayMs > 0) vTaskDelay(pdMS_TO_TICKS(delayMs));
+    }
+
+    void recordCommand(const bool afterIdle, const uint32_t durationUs)
+    {
+        std::lock_guard lock(powerMutex);
+        (afterIdle ? handlingAfterIdle : handlingWhileHeld).add(durationUs);
+    }
+
+    const char* floorName(const Floor floor)
+    {
+        switch (floor)
+        {
+        case Floor::CpuMax: return "cpuMax";
+        case Floor::ApbMax: return "apbMax";
+        case Floor::Awake: return "awake";
+        case Floor::LightSleep: return "lightSleep";
+        default: return "unknown";
+        }
+    }
+
+    const char* lockName(const Lock lock)
+    {
+        switch (lock)
+        {
+        case Lock::Pwm: return "pwm";
+        case Lock::Session: return "session";
+        case Lock::Transfer: return "transfer";
+        default: return "unknown";
+        }
+    }
+
+    Stats getStats()
+    {
+        std::lock_guard lock(powerMutex);
+        accountFloor(esp_timer_get_time());
+        Stats stats;
+        stats.enabled = enabled;
+        stats.maxMhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        stats.minMhz = CONFIG_RGBW_CTRL_PM_MIN_CPU_MHZ;
+        stats.floor = currentFloor;
+        stats.heldLocks = heldLocks.load();
+        stats.lockFloorUs = lockFloorUs;
+        stats.acquisitions = acquisitions;
+        stats.handlingAfterIdle = handlingAfterIdle.get();
+        stats.handlingWhileHeld = handlingWhileHeld.get();
+        return stats;
+    }
+
+    Summary getSummary()
+    {
+        const auto stats = getStats();
+        Summary summary;
+        for (uint8_t i = 0; i < FLOOR_COUNT; ++i)
+            summary.lockFloorMs[i] = static_cast<uint32_t>(stats.lockFloorUs[i] / 1000);
+        summary.idleHandlingMeanUs = stats.handlingAfterIdle.meanUs;
+        summary.idleHandlingMaxUs = stats.handlingAfterIdle.maxUs;
+        summary.heldHandlingMeanUs = stats.handlingWhileHeld.meanUs;
+        return summary;
+    }
+}
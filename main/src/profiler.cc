@@ -0,0 +1,84 @@
+#include "profiler.hh"
+
+#include <mutex>
+#include <esp_log.h>
+
+namespace Profiler
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "Profiler";
+
+        std::mutex statsMutex;
+        std::array<ComponentStats, COMPONENT_COUNT> stats = {};
+
+        uint8_t bucketOf(const uint32_t cycles)
+        {
+            return static_cast<uint8_t>(31 - __builtin_clz(cycles | 1));
+        }
+    }
+
+    void setEnabled(const bool enabled)
+    {
+        if (active.exchange(enabled) != enabled)
+            ESP_LOGI(LOG_TAG, "Loop profiling %s", enabled ? "enabled" : "disabled");
+    }
+
+    void reset()
+    {
+        std::lock_guard lock(statsMutex);
+        stats = {};
+    }
+
+    void record(const Component component, uint32_t cycles, const uint32_t mhz)
+    {
+        if (mhz != 0 && mhz != REFERENCE_MHZ)
+            cycles = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(cycles) * REFERENCE_MHZ / mhz,
+                                                              UINT32_MAX));
+        std::lock_guard lock(statsMutex);
+        auto& entry = stats[static_cast<uint8_t>(component)];
+        entry.calls++;
+        entry.totalCycles += cycles;
+        entry.maxCycles = std::max(entry.maxCycles, cycles);
+        entry.histogram[bucketOf(cycles)]++;
+    }
+
+    const char* componentName(const Component component)
+    {
+        switch (component)
+        {
+        case Component::BleManager: return "bleManager";
+        case Component::BoardButton: return "boardButton";
+        case Component::DeviceManager: return "deviceManager";
+        case Component::OutputManager: return "outputManager";
+        case Component::WebSocketHandler: return "webSocketHandler";
+        case Component::AlexaIntegration: return "alexaIntegration";
+        case Component::BoardLed: return "boardLed";
+        case Component::Loop: return "loop";
+        default: return "unknown";
+        }
+    }
+
+    ComponentStats getStats(const Component component)
+    {
+        std::lock_guard lock(statsMutex);
+        return stats[static_cast<uint8_t>(component)];
+    }
+
+    Summary getSummary()
+    {
+        Summary summary;
+        summary.enabled = isEnabled();
+        summary.cpuMhz = REFERENCE_MHZ;
+        std::lock_guard lock(statsMutex);
+        for (uint8_t i = 0; i < COMPONENT_COUNT; ++i)
+        {
+            const auto& entry = stats[i];
+            auto& component = summary.components[i];
+            component.calls = entry.calls;
+            component.meanCycles = meanCycles(entry);
+            component.maxCycles = entry.maxCycles;
+        }
+        return summary;
+    }
+}
@@ -10,6 +10,9 @@
 #include "state_rest_handler.hh"
 #include "rotary_encoder_manager.hh"
 #include "websocket_handler.hh"
+#include "telemetry.hh"
+#include "callback_budget_rest_handler.hh"
+#include "heap_accounting_rest_handler.hh"
 
 void startBle();
 void toggleOutput();
@@ -44,6 +47,11 @@ BLE::Manager bleManager(advertisementData,
                             &remoteEspNowHandler,
                         });
 
+Profiler::RestHandler profilerRestHandler;
+CallbackBudget::RestHandler callbackBudgetRestHandler;
+HeapAccounting::RestHandler heapRestHandler;
+Telemetry::Collector telemetryCollector;
+
 WebSocket::Handler webSocketHandler(nullptr,
                                     &otaHandler,
                                     &wifiManager,
@@ -52,7 +60,9 @@ WebSocket::Handler webSocketHandler(nullptr,
                                     &bleManager,
                                     &deviceManager,
                                     nullptr,
-                                    &remoteEspNowHandler);
+                                    &remoteEspNowHandler,
+                                    nullptr,
+                                    &telemetryCollector);
 
 StateRestHandler stateRestHandler({
     &deviceManager,
@@ -65,6 +75,8 @@ StateRestHandler stateRestHandler({
 void setup()
 {
     ESP_LOGI(LOG_TAG, "Starting controller");
+
+    Async::begin();
     rotaryEncoderManager.begin();
     wifiManager.begin();
     deviceManager.begin();
@@ -85,12 +97,16 @@ void setup()
 
 void loop()
 {
+    using Profiler::Component;
+    Profiler::Scope loopScope(Component::Loop);
     const auto now = millis();
 
-    bleManager.handle(now);
-    boardButton.handle(now);
-    deviceManager.handle(now);
-    webSocketHandler.handle(now);
+    Profiler::measure(Component::BleManager, [now] { bleManager.handle(now); });
+    Profiler::measure(Component::BoardButton, [now] { boardButton.handle(now); });
+    Profiler::measure(Component::DeviceManager, [now] { deviceManager.handle(now); });
+    Profiler::measure(Component::WebSocketHandler, [now] { webSocketHandler.handle(now); });
+    HeapAccounting::handle(now);
+    CallbackBudget::handle();
 }
 
 void toggleOutput()
@@ -137,7 +153,10 @@ void beginWebServer()
             &otaHandler,
             &stateRestHandler,
             &bleManager,
-            &deviceManager
+            &deviceManager,
+            &profilerRestHandler,
+            &callbackBudgetRestHandler,
+            &heapRestHandler
         }
     );
 }
@@ -0,0 +1,202 @@
+#include "stall_watchdog.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include <esp_cpu_utils.h>
+#include <esp_debug_helpers.h>
+#include <esp_memory_utils.h>
+#include <esp_private/freertos_debug.h>
+#include <xtensa_context.h>
+#endif
+
+#include "profiler.hh"
+#include "task_registry.hh"
+
+namespace StallWatchdog
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "StallWatchdog";
+        constexpr uint32_t MAGIC = 0x53544c32; // "STL2"
+        constexpr uint32_t CHECK_INTERVAL_MS = 50;
+        // No stall in progress.
+        constexpr uint8_t NO_SLOT = UINT8_MAX;
+
+        struct Ring
+        {
+            uint32_t magic;
+            uint32_t boot;
+            uint8_t head;
+            uint8_t count;
+            std::array<uint8_t, 2> reserved;
+            std::array<Record, CAPACITY> records;
+            uint32_t crc;
+        };
+
+        static_assert(offsetof(Ring, records) % alignof(Record) == 0, "Ring::records must be aligned");
+        static_assert(offsetof(Ring, crc) == 12 + CAPACITY * sizeof(Record), "Ring must not contain implicit padding");
+
+        // Left alone by the startup code, so the records of the boot that stalled are still here.
+        RTC_NOINIT_ATTR Ring ring;
+
+        std::mutex ringMutex;
+        std::atomic<uint32_t> heartbeatMs = 0;
+        // Set by the first beat, so a slow setup() is not reported as a stall.
+        std::atomic<bool> beating = false;
+        TaskHandle_t watchedTask = nullptr;
+
+        uint32_t checksum(const Ring& value)
+        {
+            return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&value), offsetof(Ring, crc));
+        }
+
+        void reset()
+        {
+            ring.magic = MAGIC;
+            ring.head = 0;
+            ring.count = 0;
+        }
+
+        uint32_t uptimeMs()
+        {
+            return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+        }
+
+        uint8_t captureBacktrace(TaskHandle_t task, std::array<uint32_t, MAX_DEPTH>& out)
+        {
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+            // The task is switched out, so its context is saved on top of its stack.
+            TaskSnapshot_t snapshot;
+            if (vTaskGetSnapshot(task, &snapshot) != pdTRUE) return 0;
+            // A task preempted by an interrupt saved a full exception frame; one that blocked or yielded
+            // (a semaphore wait, an NVS commit, WiFi.disconnect) saved a solicited frame, marked by `exit == 0`.
+            esp_backtrace_frame_t frame = {};
+            if (const auto* context = static_cast<const XtExcFrame*>(snapshot.pxTopOfStack); context->exit != 0)
+            {
+                frame = {.pc = context->pc, .sp = context->a1, .next_pc = context->a0, .exc_frame = context};
+            }
+            else
+            {
+                const auto* solicited = static_cast<const XtSolFrame*>(snapshot.pxTopOfStack);
+                frame = {.pc = solicited->pc, .sp = solicited->a1, .next_pc = solicited->a0, .exc_frame = solicited};
+            }
+            uint8_t depth = 0;
+            out[depth++] = esp_cpu_process_stack_pc(frame.pc);
+            while (depth < MAX_DEPTH && frame.next_pc != 0)
+            {
+                if (!esp_backtrace_get_next_frame(&frame) || !esp_stack_ptr_is_sane(frame.sp)) break;
+                out[depth++] = esp_cpu_process_stack_pc(frame.pc);
+            }
+            return depth;
+#else
+            return 0;
+#endif
+        }
+
+        // Runs on the supervisor task; `slot` is the record of the stall in progress, or NO_SLOT.
+        void check(uint8_t& slot)
+        {
+            if (!beating.load(std::memory_order_relaxed)) return;
+            const auto start = heartbeatMs.load(std::memory_order_relaxed);
+            const auto elapsed = uptimeMs() - start;
+            const bool stalled = elapsed >= CONFIG_RGBW_CTRL_STALL_THRESHOLD_MS;
+            if (!stalled && slot == NO_SLOT) return;
+
+            std::lock_guard lock(ringMutex);
+            if (slot != NO_SLOT)
+            {
+                auto& record = ring.records[slot];
+                if (start == record.startMs)
+                {
+                    record.durationMs = elapsed;
+                    ring.crc = checksum(ring);
+                    return;
+                }
+                // The heartbeat moved, so the stalled pass ended when the next one started.
+                record.durationMs = start - record.startMs;
+                record.recovered = true;
+                slot = NO_SLOT;
+                ESP_LOGW(LOG_TAG, "Main loop recovered after %lu ms", record.durationMs);
+            }
+
+            if (stalled)
+            {
+                auto& record = ring.records[ring.head];
+                record = {};
+                record.boot = ring.boot;
+                record.startMs = start;
+                record.durationMs = elapsed;
+                strncpy(record.component.data(), Profiler::componentName(Profiler::current.load()),
+                        NAME_LENGTH - 1);
+                record.depth = captureBacktrace(watchedTask, record.backtrace);
+                slot = ring.head;
+                ring.head = (ring.head + 1) % CAPACITY;
+                if (ring.count < CAPACITY) ring.count++;
+                ESP_LOGW(LOG_TAG, "Main loop stalled for %lu ms in %s", elapsed, record.component.data());
+            }
+            ring.crc = checksum(ring);
+        }
+
+        [[noreturn]] void supervise(void*)
+        {
+            uint8_t slot = NO_SLOT;
+            for (;;)
+            {
+                vTaskDelay(pdMS_TO_TICKS(CHECK_INTERVAL_MS));
+                check(slot);
+            }
+        }
+    }
+
+    void begin(TaskHandle_t loopTask)
+    {
+        {
+            std::lock_guard lock(ringMutex);
+            if (ring.magic != MAGIC || ring.crc != checksum(ring) || ring.count > CAPACITY)
+            {
+                ring.boot = 0;
+                reset();
+            }
+            ring.boot++;
+            ring.crc = checksum(ring);
+        }
+        watchedTask = loopTask;
+        Tasks::spawn(Tasks::Plan::STALL_WATCHDOG, supervise, nullptr);
+    }
+
+    void beat()
+    {
+        heartbeatMs.store(uptimeMs(), std::memory_order_relaxed);
+        beating.store(true, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        std::lock_guard lock(ringMutex);
+        reset();
+        ring.crc = checksum(ring);
+    }
+
+    uint32_t getBoot()
+    {
+        std::lock_guard lock(ringMutex);
+        return ring.boot;
+    }
+
+    uint8_t getRecords(std::array<Record, CAPACITY>& out)
+    {
+        std::lock_guard lock(ringMutex);
+        for (uint8_t i = 0; i < ring.count; ++i)
+            out[i] = ring.records[(ring.head + CAPACITY - 1 - i) % CAPACITY];
+        return ring.count;
+    }
+}
@@ -0,0 +1,81 @@
+#include "task_registry.hh"
+
+#include <mutex>
+#include <esp_log.h>
+
+namespace Tasks
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "TaskRegistry";
+        constexpr uint8_t MAX_TASKS = 12;
+
+        struct Entry
+        {
+            const Spec* spec = nullptr;
+            TaskHandle_t handle = nullptr;
+        };
+
+        std::mutex registryMutex;
+        std::array<Entry, MAX_TASKS> registry = {};
+
+        void record(const Spec& spec, TaskHandle_t handle)
+        {
+            std::lock_guard lock(registryMutex);
+            for (auto& entry : registry)
+            {
+                if (entry.handle == nullptr)
+                {
+                    entry = {&spec, handle};
+                    return;
+                }
+            }
+            ESP_LOGW(LOG_TAG, "Registry full, %s will not be reported as declared", spec.name);
+        }
+    }
+
+    bool spawn(const Spec& spec, const TaskFunction_t function, void* arg, TaskHandle_t* handle)
+    {
+        TaskHandle_t created = nullptr;
+        if (xTaskCreatePinnedToCore(function, spec.name, spec.stackSize, arg, spec.priority, &created, spec.core)
+            != pdPASS)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to create %s on core %d", spec.name, spec.core);
+            return false;
+        }
+        record(spec, created);
+        if (handle) *handle = created;
+        return true;
+    }
+
+    void adopt(const Spec& spec, TaskHandle_t handle)
+    {
+        if (const auto core = xTaskGetCoreID(handle); core != spec.core)
+        {
+            ESP_LOGW(LOG_TAG, "%s runs on core %d but is declared on core %d", spec.name, core, spec.core);
+        }
+        vTaskPrioritySet(handle, spec.priority);
+        record(spec, handle);
+    }
+
+    void remove(TaskHandle_t handle)
+    {
+        std::lock_guard lock(registryMutex);
+        for (auto& entry : registry)
+        {
+            if (entry.handle == handle)
+                entry = {};
+        }
+    }
+
+    const Spec* findSpec(TaskHandle_t handle)
+    {
+        std::lock_guard lock(registryMutex);
+        for (const auto& entry : registry)
+        {
+            if (entry.handle != nullptr && entry.handle == handle)
+                return entry.spec;
+        }
+        return nullptr;
+    }
+}
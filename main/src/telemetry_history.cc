@@ -0,0 +1,261 @@
+#include "telemetry_history.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+
+#include "power.hh"
+#include "sensor.hh"
+
+namespace TelemetryHistory
+{
+    namespace
+    {
+        constexpr uint16_t SAMPLE_INTERVAL_MS = 1000;
+        constexpr uint16_t SECONDS_PER_MINUTE = 60;
+
+        // Two buckets per power of two up to 65535 us, so a percentile is within 25% of the true value.
+        constexpr uint8_t LOOP_BUCKETS = 32;
+        using LoopHistogram = std::array<uint32_t, LOOP_BUCKETS>;
+
+        template <uint16_t Capacity>
+        struct Ring
+        {
+            std::array<Sample, Capacity> samples = {};
+            // Samples ever pushed, i.e. the sequence number of the next one.
+            uint32_t total = 0;
+            uint32_t newestUptimeS = 0;
+
+            void push(const Sample& sample, const uint32_t uptimeS)
+            {
+                samples[total % Capacity] = sample;
+                total++;
+                newestUptimeS = uptimeS;
+            }
+
+            [[nodiscard]] uint32_t oldest() const
+            {
+                return total > Capacity ? total - Capacity : 0;
+            }
+        };
+
+        // Folds second samples into the minute sample being built.
+        struct MinuteAccumulator
+        {
+            uint16_t seconds = 0;
+            uint16_t freeHeap = UINT16_MAX;
+            uint16_t largestBlock = UINT16_MAX;
+            uint32_t milliVoltsSum = 0;
+            int32_t rssiSum = 0;
+            uint16_t connectedSeconds = 0;
+            uint32_t commands = 0;
+        };
+
+        std::mutex historyMutex;
+        Ring<SECONDS_CAPACITY> seconds;
+        Ring<MINUTES_CAPACITY> minutes;
+        Delegate<uint32_t()> inputSource;
+
+        // Only touched by the main loop.
+        MinuteAccumulator minute;
+        LoopHistogram secondLoops = {};
+        LoopHistogram minuteLoops = {};
+        unsigned long lastSample = 0;
+        uint32_t lastCommandCount = 0;
+
+        uint8_t bucketOf(const uint32_t durationUs)
+        {
+            const auto us = std::min<uint32_t>(durationUs, UINT16_MAX);
+            if (us < 2) return static_cast<uint8_t>(us);
+            const auto msb = static_cast<uint8_t>(31 - __builtin_clz(us));
+            return static_cast<uint8_t>(2 * msb + ((us >> (msb - 1)) & 1));
+        }
+
+        uint32_t bucketUpperBound(const uint8_t bucket)
+        {
+            if (bucket < 2) return bucket;
+            const uint8_t msb = bucket / 2;
+            const uint32_t lower = (2u | (bucket & 1u)) << (msb - 1);
+            return lower + (1u << (msb - 1)) - 1;
+        }
+
+        uint16_t percentile99(const LoopHistogram& histogram)
+        {
+            uint32_t total = 0;
+            for (const auto count : histogram) total += count;
+            if (total == 0) return 0;
+
+            // Smallest bucket that covers 99% of the passes.
+            const auto target = total - total / 100;
+            uint32_t seen = 0;
+            for (uint8_t i = 0; i < LOOP_BUCKETS; ++i)
+            {
+                seen += histogram[i];
+                if (seen >= target)
+                    return static_cast<uint16_t>(std::min<uint32_t>(bucketUpperBound(i), UINT16_MAX));
+            }
+            return UINT16_MAX;
+        }
+
+        uint16_t toHeapUnits(const size_t bytes)
+        {
+            return static_cast<uint16_t>(std::min<size_t>(bytes / HEAP_UNIT, UINT16_MAX));
+        }
+
+        uint32_t commandCount()
+        {
+            const auto stats = Power::getStats();
+            return stats.handlingAfterIdle.count + stats.handlingWhileHeld.count;
+        }
+
+        Sample takeSample()
+        {
+            Sample sample;
+            sample.freeHeap = toHeapUnits(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+            sample.largestBlock = toHeapUnits(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+            Delegate<uint32_t()> source;
+            {
+                std::lock_guard lock(historyMutex);
+                source = inputSource;
+            }
+            if (source)
+                sample.inputMilliVolts = static_cast<uint16_t>(std::min<uint32_t>(source(), UINT16_MAX));
+            if (WiFi.isConnected())
+            {
+                sample.rssi = WiFi.RSSI();
+                sample.connectedPercent = 100;
+            }
+            sample.loopP99Us = percentile99(secondLoops);
+
+            const auto commands = commandCount();
+            sample.commands = static_cast<uint16_t>(std::min<uint32_t>(commands - lastCommandCount, UINT16_MAX));
+            lastCommandCount = commands;
+            return sample;
+        }
+
+        void fold(const Sample& sample)
+        {
+            minute.seconds++;
+            minute.freeHeap = std::min(minute.freeHeap, sample.freeHeap);
+            minute.largestBlock = std::min(minute.largestBlock, sample.largestBlock);
+            minute.milliVoltsSum += sample.inputMilliVolts;
+            if (sample.connectedPercent > 0)
+            {
+                minute.rssiSum += sample.rssi;
+                minute.connectedSeconds++;
+            }
+            minute.commands += sample.commands;
+        }
+
+        Sample completeMinute()
+        {
+            Sample sample;
+            sample.freeHeap = minute.freeHeap;
+            sample.largestBlock = minute.largestBlock;
+            sample.inputMilliVolts = static_cast<uint16_t>(minute.milliVoltsSum / minute.seconds);
+            if (minute.connectedSeconds > 0)
+                sample.rssi = static_cast<int8_t>(minute.rssiSum / minute.connectedSeconds);
+            sample.connectedPercent = static_cast<uint8_t>(minute.connectedSeconds * 100 / minute.seconds);
+            sample.loopP99Us = percentile99(minuteLoops);
+            sample.commands = static_cast<uint16_t>(std::min<uint32_t>(minute.commands, UINT16_MAX));
+            minute = {};
+            minuteLoops = {};
+            return sample;
+        }
+
+        template <uint16_t Capacity>
+        FileHeader headerOf(const Ring<Capacity>& ring, const uint32_t since)
+        {
+            FileHeader header;
+            header.firstSequence = std::clamp(since, ring.oldest(), ring.total);
+            header.count = static_cast<uint16_t>(ring.total - header.firstSequence);
+            header.newestUptimeS = ring.newestUptimeS;
+            return header;
+        }
+
+        template <uint16_t Capacity>
+        const Sample* sampleAt(const Ring<Capacity>& ring, const uint32_t sequence)
+        {
+            static constexpr Sample OVERWRITTEN = {};
+            if (sequence < ring.oldest()) return &OVERWRITTEN;
+            return &ring.samples[sequence % Capacity];
+        }
+
+        size_t copyWindow(const size_t position, const void* data, const size_t size, const size_t offset,
+                          uint8_t* out, const size_t len)
+        {
+            const auto start = std::max(position, offset);
+            const auto end = std::min(position + size, offset + len);
+            if (start >= end) return 0;
+            memcpy(out + (start - offset), static_cast<const uint8_t*>(data) + (start - position), end - start);
+            return end - start;
+        }
+    }
+
+    void setInputSource(const Delegate<uint32_t()>& source)
+    {
+        std::lock_guard lock(historyMutex);
+        inputSource = source;
+    }
+
+    void handle(const unsigned long now)
+    {
+        if (now - lastSample < SAMPLE_INTERVAL_MS) return;
+        lastSample = now;
+
+        // Sampling takes other modules' locks, so it happens before the history is locked.
+        const auto sample = takeSample();
+        secondLoops = {};
+        fold(sample);
+
+        std::lock_guard lock(historyMutex);
+        const auto uptimeS = static_cast<uint32_t>(now / 1000);
+        seconds.push(sample, uptimeS);
+        if (minute.seconds == SECONDS_PER_MINUTE)
+            minutes.push(completeMinute(), uptimeS);
+    }
+
+    void recordLoop(const uint32_t durationUs)
+    {
+        const auto bucket = bucketOf(durationUs);
+        secondLoops[bucket]++;
+        minuteLoops[bucket]++;
+    }
+
+    uint16_t intervalS(const Tier tier)
+    {
+        return tier == Tier::Minutes ? SECONDS_PER_MINUTE : 1;
+    }
+
+    FileHeader beginDownload(const Tier tier, const uint32_t since)
+    {
+        const auto calibrationFactor = Sensor::getCalibrationFactor();
+        std::lock_guard lock(historyMutex);
+        auto header = tier == Tier::Minutes ? headerOf(minutes, since) : headerOf(seconds, since);
+        header.tier = tier;
+        header.intervalS = intervalS(tier);
+        header.calibrationFactor = calibrationFactor;
+        return header;
+    }
+
+    size_t read(const FileHeader& header, const size_t offset, uint8_t* out, const size_t len)
+    {
+        std::lock_guard lock(historyMutex);
+        size_t written = copyWindow(0, &header, sizeof(header), offset, out, len);
+        // Skips the samples sent in earlier windows.
+        uint16_t i = offset > sizeof(header) ? (offset - sizeof(header)) / sizeof(Sample) : 0;
+        size_t position = sizeof(header) + i * sizeof(Sample);
+        for (; i < header.count && position < offset + len; ++i)
+        {
+            const auto sequence = header.firstSequence + i;
+            const auto sample = header.tier == Tier::Minutes
+                                    ? sampleAt(minutes, sequence)
+                                    : sampleAt(seconds, sequence);
+            written += copyWindow(position, sample, sizeof(Sample), offset, out, len);
+            position += sizeof(Sample);
+        }
+        return written;
+    }
+}
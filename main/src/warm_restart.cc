@@ -0,0 +1,85 @@
+#include "warm_restart.hh"
+
+#include <cstddef>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+
+namespace WarmRestart
+{
+    namespace
+    {
+        constexpr uint32_t MAGIC = 0x57524d31; // "WRM1"
+
+#pragma pack(push, 1)
+        struct Mirror
+        {
+            uint32_t magic;
+            // An OTA update to another board profile is a software reset too.
+            uint8_t outputCount;
+            Outputs outputs;
+            uint32_t crc;
+        };
+#pragma pack(pop)
+
+        // Left alone by the startup code, so a warm boot finds the previous run's value.
+        RTC_NOINIT_ATTR Mirror mirror;
+
+        BootTiming bootTiming;
+
+        uint32_t checksum(const Mirror& value)
+        {
+            return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&value), offsetof(Mirror, crc));
+        }
+
+        bool keepsRtcMemory(const esp_reset_reason_t reason)
+        {
+            switch (reason)
+            {
+            case ESP_RST_SW:
+            case ESP_RST_PANIC:
+            case ESP_RST_INT_WDT:
+            case ESP_RST_TASK_WDT:
+            case ESP_RST_WDT:
+            case ESP_RST_DEEPSLEEP:
+                return true;
+            default:
+                return false;
+            }
+        }
+    }
+
+    std::optional<Outputs> load()
+    {
+        bootTiming.resetReason = esp_reset_reason();
+        if (!keepsRtcMemory(bootTiming.resetReason)) return std::nullopt;
+        if (mirror.magic != MAGIC || mirror.outputCount != ControllerHardware::OUTPUT_COUNT) return std::nullopt;
+        if (mirror.crc != checksum(mirror)) return std::nullopt;
+        return mirror.outputs;
+    }
+
+    void save(const Outputs& outputs)
+    {
+        mirror.magic = MAGIC;
+        mirror.outputCount = ControllerHardware::OUTPUT_COUNT;
+        mirror.outputs = outputs;
+        mirror.crc = checksum(mirror);
+    }
+
+    void invalidate()
+    {
+        mirror.magic = 0;
+    }
+
+    void markLightsOn(const bool warm)
+    {
+        if (bootTiming.lightsOnUs >= 0) return;
+        bootTiming.warm = warm;
+        bootTiming.lightsOnUs = esp_timer_get_time();
+    }
+
+    BootTiming getBootTiming()
+    {
+        return bootTiming;
+    }
+}
@@ -0,0 +1,213 @@
+#include "worker_pool.hh"
+#include "task_registry.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h> // NOLINT
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+
+namespace Async
+{
+    namespace
+    {
+        constexpr auto LOG_TAG = "WorkerPool";
+
+        constexpr uint8_t WORKER_COUNT = 2;
+        constexpr UBaseType_t QUEUE_LENGTH = 16;
+
+        // Delayed jobs live in a single-level timer wheel: WHEEL_SLOTS buckets of
+        // WHEEL_TICK_MS each, with a round counter for delays longer than one turn.
+        constexpr uint32_t WHEEL_TICK_MS = 10;
+        constexpr uint8_t WHEEL_SLOTS = 32;
+        constexpr uint8_t MAX_DELAYED_JOBS = 16;
+        constexpr uint8_t NO_ENTRY = 0xFF;
+
+        struct TimerEntry
+        {
+            Job job;
+            uint32_t rounds = 0;
+            uint8_t next = NO_ENTRY;
+        };
+
+        QueueHandle_t jobQueue = nullptr;
+        TimerHandle_t wheelTimer = nullptr;
+
+        std::mutex wheelMutex;
+        std::array<TimerEntry, MAX_DELAYED_JOBS> entries = {};
+        std::array<uint8_t, WHEEL_SLOTS> slots = {};
+        uint8_t freeHead = NO_ENTRY;
+        uint8_t cursor = 0;
+        uint8_t pendingDelayed = 0;
+
+        // Set when starting the wheel timer failed because the timer command queue was full; the next post()
+        // or finished job tries again, so delayed jobs are late rather than lost.
+        std::atomic<bool> wheelStartPending = false;
+
+        std::atomic<uint32_t> submitted = 0;
+        std::atomic<uint32_t> completed = 0;
+        std::atomic<uint32_t> rejected = 0;
+
+        bool enqueue(const Job& job)
+        {
+            if (xQueueSend(jobQueue, &job, 0) != pdTRUE)
+            {
+                ++rejected;
+                ESP_LOGE(LOG_TAG, "Job queue full, dropping job");
+                return false;
+            }
+            ++submitted;
+            return true;
+        }
+
+        // Call with wheelMutex held.
+        void startWheel()
+        {
+            const bool failed = xTimerStart(wheelTimer, 0) != pdPASS;
+            if (failed && !wheelStartPending)
+                ESP_LOGW(LOG_TAG, "Timer command queue full, retrying the wheel start on the next dispatch");
+            wheelStartPending = failed;
+        }
+
+        void retryWheelStart()
+        {
+            if (!wheelStartPending.load(std::memory_order_relaxed)) return;
+            std::lock_guard lock(wheelMutex);
+            if (wheelStartPending && pendingDelayed > 0) startWheel();
+        }
+
+        void advanceWheel(TimerHandle_t)
+        {
+            std::lock_guard lock(wheelMutex);
+            cursor = (cursor + 1) % WHEEL_SLOTS;
+            const uint8_t nextSlot = (cursor + 1) % WHEEL_SLOTS;
+            bool deferred = false;
+
+            auto* link = &slots[cursor];
+            while (*link != NO_ENTRY)
+            {
+                const uint8_t idx = *link;
+                auto& entry = entries[idx];
+                if (entry.rounds > 0)
+                {
+                    entry.rounds--;
+                    link = &entry.next;
+                    continue;
+                }
+                *link = entry.next;
+                // post() already accepted the job, so a full queue moves it to the next tick instead of dropping it.
+                if (xQueueSend(jobQueue, &entry.job, 0) != pdTRUE)
+                {
+                    entry.next = slots[nextSlot];
+                    slots[nextSlot] = idx;
+                    deferred = true;
+                    continue;
+                }
+                ++submitted;
+                entry = {};
+                entry.next = freeHead;
+                freeHead = idx;
+                pendingDelayed--;
+            }
+
+            if (deferred)
+                ESP_LOGW(LOG_TAG, "Job queue full, delayed jobs moved to the next tick");
+            if (pendingDelayed == 0)
+                xTimerStop(wheelTimer, 0);
+        }
+
+        bool schedule(const Job& job, const uint32_t delayMs)
+        {
+            const uint32_t ticks = std::max<uint32_t>(1, (delayMs + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS);
+
+            std::lock_guard lock(wheelMutex);
+            if (freeHead == NO_ENTRY)
+            {
+                ++rejected;
+                ESP_LOGE(LOG_TAG, "Timer wheel full, dropping delayed job");
+                return false;
+            }
+            const uint8_t idx = freeHead;
+            auto& entry = entries[idx];
+            freeHead = entry.next;
+
+            const uint8_t slot = (cursor + ticks) % WHEEL_SLOTS;
+            entry.job = job;
+            entry.rounds = (ticks - 1) / WHEEL_SLOTS;
+            entry.next = slots[slot];
+            slots[slot] = idx;
+
+            if (pendingDelayed++ == 0 || wheelStartPending)
+                startWheel();
+            return true;
+        }
+
+        [[noreturn]] void workerLoop(void*)
+        {
+            Job job;
+            while (true) // NOLINT
+            {
+                if (xQueueReceive(jobQueue, &job, portMAX_DELAY) == pdTRUE)
+                {
+                    if (job) job();
+                    ++completed;
+                    retryWheelStart();
+                }
+            }
+        }
+    }
+
+    bool begin()
+    {
+        if (jobQueue != nullptr) return true;
+
+        {
+            std::lock_guard lock(wheelMutex);
+            slots.fill(NO_ENTRY);
+            for (uint8_t i = 0; i < MAX_DELAYED_JOBS; ++i)
+                entries[i].next = i + 1 < MAX_DELAYED_JOBS ? i + 1 : NO_ENTRY;
+            freeHead = 0;
+        }
+
+        jobQueue = xQueueCreate(QUEUE_LENGTH, sizeof(Job));
+        if (!jobQueue)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to create job queue");
+            return false;
+        }
+
+        wheelTimer = xTimerCreate("AsyncWheel", pdMS_TO_TICKS(WHEEL_TICK_MS), pdTRUE, nullptr, advanceWheel);
+        if (!wheelTimer)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to create timer wheel");
+            return false;
+        }
+
+        for (uint8_t i = 0; i < WORKER_COUNT; ++i)
+        {
+            if (!Tasks::spawn(Tasks::Plan::ASYNC_WORKER, workerLoop, nullptr))
+                return false;
+        }
+        return true;
+    }
+
+    bool post(const Job& job, const uint32_t delayMs)
+    {
+        if (jobQueue == nullptr)
+        {
+            ESP_LOGE(LOG_TAG, "Worker pool not started");
+            return false;
+        }
+        retryWheelStart();
+        return delayMs == 0 ? enqueue(job) : schedule(job, delayMs);
+    }
+
+    Stats getStats()
+    {
+        std::lock_guard lock(wheelMutex);
+        return {submitted, completed, rejected, pendingDelayed};
+    }
+}